@@ -0,0 +1,153 @@
+#include "AllocationTracking.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace CTest
+{
+    namespace
+    {
+        //Plain pointer, so it needs no dynamic initialization and is safe to touch from inside operator new
+        thread_local AllocationCounters* activeCounters = nullptr;
+    }
+
+    AllocationScope::AllocationScope(AllocationCounters& _counters)
+    : counters{_counters}
+    {
+        counters.parent = activeCounters;
+        activeCounters = &counters;
+    }
+
+    AllocationScope::~AllocationScope()
+    {
+        activeCounters = counters.parent;
+    }
+
+    AllocationTrackingPause::AllocationTrackingPause()
+    : pausedCounters{activeCounters}
+    {
+        activeCounters = nullptr;
+    }
+
+    AllocationTrackingPause::~AllocationTrackingPause()
+    {
+        activeCounters = pausedCounters;
+    }
+
+#if defined(CANARY_TRACK_ALLOCATIONS)
+    bool IsAllocationTrackingEnabled()
+    {
+        return true;
+    }
+
+    namespace
+    {
+        //Every block is prefixed with its size, so that deallocations can be counted in bytes.
+        //The prefix is padded to keep the returned pointer suitably aligned for any type.
+        struct alignas(std::max_align_t) BlockHeader
+        {
+            size_t size;
+        };
+
+        void* TrackedAllocate(size_t size)
+        {
+            BlockHeader* header = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+            if(header == nullptr) return nullptr;
+            header->size = size;
+
+            for(AllocationCounters* counters = activeCounters; counters != nullptr; counters = counters->parent)
+            {
+                counters->nAllocations++;
+                counters->allocatedBytes += size;
+                counters->liveBytes += static_cast<int64_t>(size);
+                if(counters->liveBytes > counters->peakLiveBytes) counters->peakLiveBytes = counters->liveBytes;
+            }
+            return header + 1;
+        }
+
+        void TrackedFree(void* pointer)
+        {
+            if(pointer == nullptr) return;
+            BlockHeader* header = static_cast<BlockHeader*>(pointer) - 1;
+
+            for(AllocationCounters* counters = activeCounters; counters != nullptr; counters = counters->parent)
+            {
+                counters->nDeallocations++;
+                counters->liveBytes -= static_cast<int64_t>(header->size);
+            }
+            free(header);
+        }
+
+        void* TrackedAllocateOrThrow(size_t size)
+        {
+            for(;;)
+            {
+                void* pointer = TrackedAllocate(size);
+                if(pointer != nullptr) return pointer;
+
+                const std::new_handler handler = std::get_new_handler();
+                if(handler == nullptr) throw std::bad_alloc();
+                handler();
+            }
+        }
+    }
+#else
+    bool IsAllocationTrackingEnabled()
+    {
+        return false;
+    }
+#endif
+}
+
+#if defined(CANARY_TRACK_ALLOCATIONS)
+void* operator new(size_t size)
+{
+    return CTest::TrackedAllocateOrThrow(size);
+}
+
+void* operator new[](size_t size)
+{
+    return CTest::TrackedAllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return CTest::TrackedAllocateOrThrow(size); } catch(...) { return nullptr; }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return CTest::TrackedAllocateOrThrow(size); } catch(...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    CTest::TrackedFree(pointer);
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+//Building AllocationTracking.cpp with CANARY_TRACK_ALLOCATIONS defined replaces the global
+//operator new & delete, counting every heap allocation against the test running on the
+//allocating thread. Without it the counters below are never updated.
+namespace CTest
+{
+    //Allocations made on one thread while an AllocationScope is active
+    struct AllocationCounters
+    {
+        uint64_t nAllocations = 0;
+        uint64_t nDeallocations = 0;
+        uint64_t allocatedBytes = 0;
+        int64_t liveBytes = 0;      //Negative when the scope freed memory allocated before it started
+        int64_t peakLiveBytes = 0;
+        AllocationCounters* parent = nullptr;
+    };
+
+    bool IsAllocationTrackingEnabled();
+
+    //Attributes the current thread's allocations to 'counters' for its lifetime.
+    //Scopes nest, allocations are also counted against every enclosing scope.
+    class AllocationScope
+    {
+        AllocationCounters& counters;
+    public:
+        explicit AllocationScope(AllocationCounters& counters);
+        ~AllocationScope();
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+    };
+
+    //Keeps the framework's own bookkeeping (i.e. recording an assert) out of the test's counters
+    class AllocationTrackingPause
+    {
+        AllocationCounters* pausedCounters;
+    public:
+        AllocationTrackingPause();
+        ~AllocationTrackingPause();
+
+        AllocationTrackingPause(const AllocationTrackingPause&) = delete;
+        AllocationTrackingPause& operator=(const AllocationTrackingPause&) = delete;
+    };
+}
@@ -0,0 +1,139 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+
+namespace CTest
+{
+    void UseCharPointer(char const volatile*)
+    {}
+
+    namespace
+    {
+        const uint64_t maxIterationsPerSample = 1000000000ULL;
+
+        struct BatchOutcome
+        {
+            bool completed;
+            int64_t elapsedNanos;
+        };
+    }
+
+    constexpr size_t BenchmarkRunner::nSamples;
+    constexpr int64_t BenchmarkRunner::minSampleNanos;
+    constexpr int64_t BenchmarkRunner::minWarmupNanos;
+
+    void BenchmarkRunner::Run(TBenchmarkMethod method, Tester& tester)
+    {
+        auto runBatch = [method](Tester& batchTester, uint64_t iterations)
+        {
+            BenchmarkState state(iterations);
+            method(batchTester, state);
+
+            const bool completed = state.timerStarted && state.iterationsRemaining == 0;
+            const int64_t elapsedNanos = completed?
+                chrono::duration_cast<chrono::nanoseconds>(state.endTime - state.startTime).count() :
+                0;
+            return BatchOutcome{completed, elapsedNanos};
+        };
+
+        auto reportIncompleteLoop = [&tester]
+        {
+            tester.AddAssertResult(
+                AssertType::plain_assert,
+                false,
+                "Benchmark loop completed",
+                "bench.KeepRunning() must be called until it returns false"
+            );
+        };
+
+        //Asserts & logs are only kept from the first invocation of the body,
+        //later invocations only contribute their first failing assert (if any)
+        TestResults scratchResults;
+        Tester scratchTester(scratchResults, nullptr, tester.detailVerbosity, tester.runCancelled);
+        bool scratchFailureRecorded = false;
+        auto transferScratchFailure = [&]
+        {
+            for(const AssertResult& assertResult: scratchResults.assertionResults)
+            {
+                if(assertResult.passed || scratchFailureRecorded) continue;
+                tester.AddAssertResult(
+                    assertResult.assertType,
+                    false,
+                    assertResult.description,
+                    assertResult.additionalDetails);
+                scratchFailureRecorded = true;
+            }
+            scratchResults.assertionResults.clear();
+            scratchResults.logs.clear();
+            scratchTester.logBuffer.Discard();
+        };
+        auto runScratchBatch = [&](uint64_t iterations)
+        {
+            BatchOutcome outcome;
+            try
+            {
+                outcome = runBatch(scratchTester, iterations);
+            }
+            catch(const AbortTestMethod&)
+            {
+                //The failing require_* has to reach the real results before the benchmark stops
+                transferScratchFailure();
+                throw;
+            }
+            transferScratchFailure();
+            return outcome;
+        };
+
+        uint64_t iterations = 1;
+        BatchOutcome outcome = runBatch(tester, iterations);
+        if(!outcome.completed) return reportIncompleteLoop();
+        int64_t warmupNanos = outcome.elapsedNanos;
+
+        //Grow the batch until a single sample is long enough for the clock resolution not to matter
+        while(outcome.elapsedNanos < minSampleNanos && iterations < maxIterationsPerSample)
+        {
+            const double scale = outcome.elapsedNanos > 0?
+                1.2 * static_cast<double>(minSampleNanos) / static_cast<double>(outcome.elapsedNanos) :
+                100.0;
+            const double boundedScale = min(max(scale, 2.0), 100.0);
+            iterations = min(
+                static_cast<uint64_t>(static_cast<double>(iterations) * boundedScale),
+                maxIterationsPerSample);
+
+            outcome = runScratchBatch(iterations);
+            if(!outcome.completed) return reportIncompleteLoop();
+            warmupNanos += outcome.elapsedNanos;
+        }
+
+        while(warmupNanos < minWarmupNanos)
+        {
+            outcome = runScratchBatch(iterations);
+            if(!outcome.completed) return reportIncompleteLoop();
+            warmupNanos += max<int64_t>(outcome.elapsedNanos, 1);
+        }
+
+        BenchmarkStatistics statistics;
+        statistics.iterationsPerSample = iterations;
+        for(size_t i = 0; i < nSamples; i++)
+        {
+            outcome = runScratchBatch(iterations);
+            if(!outcome.completed) return reportIncompleteLoop();
+
+            statistics.nanosPerIterationSamples.push_back(
+                static_cast<double>(outcome.elapsedNanos) / static_cast<double>(iterations)
+            );
+        }
+        statistics.nanosPerIteration = ComputeSampleStatistics(statistics.nanosPerIterationSamples);
+
+        tester.boundResults.isBenchmark = true;
+        tester.boundResults.benchmark = move(statistics);
+    }
+
+    TTestMethod MakeBenchmarkMethod(TBenchmarkMethod method)
+    {
+        return [method](Tester& tester)
+        {
+            BenchmarkRunner::Run(method, tester);
+        };
+    }
+}
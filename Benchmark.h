@@ -0,0 +1,97 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#include "CTest.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace CTest
+{
+    using namespace std;
+
+    //Passed to BENCHMARK_METHOD bodies. The body is invoked several times by the framework,
+    //each invocation timing exactly the code inside its 'while(bench.KeepRunning())' loop.
+    //Setup code before the loop is not measured.
+    class BenchmarkState
+    {
+        friend class BenchmarkRunner;
+
+        uint64_t iterationsRemaining = 0;
+        bool timerStarted = false;
+        chrono::steady_clock::time_point startTime;
+        chrono::steady_clock::time_point endTime;
+
+        BenchmarkState(uint64_t iterations)
+        : iterationsRemaining{iterations}
+        {}
+    public:
+        bool KeepRunning()
+        {
+            if(iterationsRemaining != 0)
+            {
+                if(!timerStarted)
+                {
+                    timerStarted = true;
+                    startTime = chrono::steady_clock::now();
+                }
+                iterationsRemaining--;
+                return true;
+            }
+
+            endTime = chrono::steady_clock::now();
+            return false;
+        }
+    };
+
+    void UseCharPointer(char const volatile* pointer);
+
+    //Forces 'value' to be materialized, preventing the computation producing it from being optimized away
+    template<typename T>
+    inline void DoNotOptimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        UseCharPointer(&reinterpret_cast<char const volatile&>(value));
+        _ReadWriteBarrier();
+#endif
+    }
+
+    //Forces all pending writes to memory to be treated as observable
+    inline void ClobberMemory()
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : : "memory");
+#else
+        _ReadWriteBarrier();
+#endif
+    }
+
+    using TBenchmarkMethod = void(*)(Tester& tester, BenchmarkState& bench);
+
+    //Warm up, calibrate the iteration count so each sample takes long enough to time reliably,
+    //then record per-iteration timing statistics into the test results
+    class BenchmarkRunner
+    {
+    public:
+        static constexpr size_t nSamples = 30;
+        static constexpr int64_t minSampleNanos = 1000000;
+        static constexpr int64_t minWarmupNanos = 20000000;
+
+        static void Run(TBenchmarkMethod method, Tester& tester);
+    };
+
+    TTestMethod MakeBenchmarkMethod(TBenchmarkMethod method);
+}
+
+#define BENCHMARK_METHOD_NAME(METHOD_NAME) _benchmark_method_##METHOD_NAME
+
+#define BENCHMARK_GROUPED_METHOD(METHOD_NAME, LPSTR_GROUP_NAME)  \
+    void BENCHMARK_METHOD_NAME(METHOD_NAME)(CTest::Tester&, CTest::BenchmarkState&);     \
+    static CTest::MethodRegistrar _test_registrar##METHOD_NAME(#METHOD_NAME, LPSTR_GROUP_NAME, CTest::MakeBenchmarkMethod(BENCHMARK_METHOD_NAME(METHOD_NAME))); \
+    void BENCHMARK_METHOD_NAME(METHOD_NAME)(CTest::Tester& test, CTest::BenchmarkState& bench)
+
+#define BENCHMARK_METHOD(METHOD_NAME) BENCHMARK_GROUPED_METHOD(METHOD_NAME, "")
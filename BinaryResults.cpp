@@ -0,0 +1,580 @@
+#include "BinaryResults.h"
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CTest
+{
+#pragma region Layout
+    namespace
+    {
+        const char binaryMagic[8] = {'C', 'N', 'R', 'Y', 'R', 'E', 'S', '\0'};
+        const uint32_t binaryVersion = 1;
+        const uint32_t byteOrderMark = 0x01020304;
+        const size_t headerSize = sizeof(binaryMagic) + 2 * sizeof(uint32_t);
+
+        enum ChunkKind : uint8_t
+        {
+            stringChunk = 1,
+            testChunk = 2
+        };
+        const size_t chunkHeaderSize = sizeof(uint8_t) + sizeof(uint32_t);
+
+        //Offsets into a test chunk
+        const size_t groupIdOffset = 0;
+        const size_t methodIdOffset = 4;
+        const size_t millisOffset = 8;
+        const size_t nanosOffset = 16;
+        const size_t threadCpuOffset = 24;
+        const size_t processCpuOffset = 32;
+        const size_t flagsOffset = 40;
+        const size_t assertCountOffset = 44;
+        const size_t logCountOffset = 48;
+        const size_t assertsOffset = 52;
+
+        //uint8 type, uint8 passed, uint16 unused, uint32 description id, uint32 details id
+        const size_t assertEntrySize = 12;
+
+        //Optional sections following the log ids, in this order
+        const uint32_t benchmarkFlag = 1;
+        const uint32_t allocationsFlag = 2;
+        const uint32_t repeatFlag = 4;
+        const uint32_t hardwareCountersFlag = 8;
+        const uint32_t droppedLogsFlag = 16;
+
+        const size_t allocationsSectionSize = 4 * sizeof(uint64_t);
+        const size_t hardwareCountersSectionSize = 5 * sizeof(int64_t);
+        const size_t droppedLogsSectionSize = sizeof(uint64_t);
+
+        template<typename T>
+        void WriteRaw(string& buffer, T value)
+        {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        //The data may be unaligned
+        template<typename T>
+        T ReadRaw(const char* position)
+        {
+            T value;
+            memcpy(&value, position, sizeof(T));
+            return value;
+        }
+
+        uint32_t CheckedSize(size_t size)
+        {
+            if(size > UINT32_MAX) throw runtime_error("test result too large for the binary results format");
+            return static_cast<uint32_t>(size);
+        }
+
+        //Benchmark & repeat sections end in a variable number of samples
+        size_t SampleSectionSize(const char* section, size_t countOffset)
+        {
+            return countOffset + sizeof(uint32_t) + ReadRaw<uint32_t>(section + countOffset) * sizeof(double);
+        }
+
+        const size_t benchmarkSampleCountOffset = sizeof(uint64_t);
+        const size_t repeatSampleCountOffset = 3 * sizeof(uint64_t);
+
+        vector<double> ReadSamples(const char* section, size_t countOffset)
+        {
+            const uint32_t nSamples = ReadRaw<uint32_t>(section + countOffset);
+            vector<double> samples(nSamples);
+            if(nSamples > 0) memcpy(samples.data(), section + countOffset + sizeof(uint32_t), nSamples * sizeof(double));
+            return samples;
+        }
+
+        [[noreturn]] void ThrowCorrupt(const char* what)
+        {
+            throw runtime_error(string("corrupt binary results: ") + what);
+        }
+    }
+#pragma endregion
+
+#pragma region BinaryResultsWriter
+    BinaryResultsWriter::BinaryResultsWriter(ostream& _output)
+    : output{_output}
+    {
+        buffer.append(binaryMagic, sizeof(binaryMagic));
+        WriteRaw<uint32_t>(buffer, binaryVersion);
+        WriteRaw<uint32_t>(buffer, byteOrderMark);
+        output.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    }
+
+    uint32_t BinaryResultsWriter::InternString(const string& value)
+    {
+        const auto found = stringIds.find(value);
+        if(found != stringIds.end()) return found->second;
+
+        //Written straight away, so that it precedes the test referring to it
+        char chunkHeader[chunkHeaderSize];
+        chunkHeader[0] = static_cast<char>(stringChunk);
+        const uint32_t length = CheckedSize(value.size());
+        memcpy(chunkHeader + 1, &length, sizeof(length));
+        output.write(chunkHeader, sizeof(chunkHeader));
+        output.write(value.data(), static_cast<streamsize>(value.size()));
+
+        const uint32_t id = static_cast<uint32_t>(stringIds.size());
+        stringIds.emplace(value, id);
+        return id;
+    }
+
+    void BinaryResultsWriter::Write(const TestResults& results)
+    {
+        const uint32_t groupId = InternString(results.groupName);
+        const uint32_t methodId = InternString(results.methodName);
+
+        uint32_t flags = 0;
+        if(results.isBenchmark) flags |= benchmarkFlag;
+        if(results.hasAllocationStatistics) flags |= allocationsFlag;
+        if(results.isRepeated) flags |= repeatFlag;
+        if(results.hasHardwareCounters) flags |= hardwareCountersFlag;
+        if(results.nDroppedLogs > 0) flags |= droppedLogsFlag;
+
+        //Every string is interned before the chunk is started, interning writes to the stream
+        buffer.clear();
+        WriteRaw<uint8_t>(buffer, testChunk);
+        WriteRaw<uint32_t>(buffer, 0);  //Payload size, filled in at the end
+        WriteRaw<uint32_t>(buffer, groupId);
+        WriteRaw<uint32_t>(buffer, methodId);
+        WriteRaw<int64_t>(buffer, results.executionTimeMillis);
+        WriteRaw<int64_t>(buffer, results.executionTimeNanos);
+        WriteRaw<int64_t>(buffer, results.threadCpuTimeNanos);
+        WriteRaw<int64_t>(buffer, results.processCpuTimeNanos);
+        WriteRaw<uint32_t>(buffer, flags);
+        WriteRaw<uint32_t>(buffer, CheckedSize(results.assertionResults.size()));
+        WriteRaw<uint32_t>(buffer, CheckedSize(results.logs.size()));
+
+        for(const AssertResult& assertResult: results.assertionResults)
+        {
+            const uint32_t descriptionId = InternString(assertResult.description);
+            const uint32_t detailsId = InternString(assertResult.additionalDetails);
+            WriteRaw<uint8_t>(buffer, static_cast<uint8_t>(assertResult.assertType));
+            WriteRaw<uint8_t>(buffer, assertResult.passed? 1 : 0);
+            WriteRaw<uint16_t>(buffer, 0);
+            WriteRaw<uint32_t>(buffer, descriptionId);
+            WriteRaw<uint32_t>(buffer, detailsId);
+        }
+        for(const string& log: results.logs)
+        {
+            WriteRaw<uint32_t>(buffer, InternString(log));
+        }
+
+        if(results.isBenchmark)
+        {
+            WriteRaw<uint64_t>(buffer, results.benchmark.iterationsPerSample);
+            WriteRaw<uint32_t>(buffer, CheckedSize(results.benchmark.nanosPerIterationSamples.size()));
+            for(const double sample: results.benchmark.nanosPerIterationSamples) WriteRaw<double>(buffer, sample);
+        }
+        if(results.hasAllocationStatistics)
+        {
+            WriteRaw<uint64_t>(buffer, results.allocations.nAllocations);
+            WriteRaw<uint64_t>(buffer, results.allocations.allocatedBytes);
+            WriteRaw<int64_t>(buffer, results.allocations.peakLiveBytes);
+            WriteRaw<int64_t>(buffer, results.allocations.leakedBytes);
+        }
+        if(results.isRepeated)
+        {
+            WriteRaw<uint64_t>(buffer, results.repeat.nIterations);
+            WriteRaw<uint64_t>(buffer, results.repeat.nFailedIterations);
+            WriteRaw<uint64_t>(buffer, results.repeat.firstFailedIteration);
+            WriteRaw<uint32_t>(buffer, CheckedSize(results.repeat.wallNanosSamples.size()));
+            for(const double sample: results.repeat.wallNanosSamples) WriteRaw<double>(buffer, sample);
+        }
+        if(results.hasHardwareCounters)
+        {
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.cycles);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.instructions);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.branchMisses);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.l1dReadMisses);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.llcReadMisses);
+        }
+        if(results.nDroppedLogs > 0)
+        {
+            WriteRaw<uint64_t>(buffer, results.nDroppedLogs);
+        }
+
+        const uint32_t payloadSize = CheckedSize(buffer.size() - chunkHeaderSize);
+        memcpy(&buffer[1], &payloadSize, sizeof(payloadSize));
+        output.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    }
+
+    void BinaryResultsWriter::OnTestEnd(const TestResults& results)
+    {
+        Write(results);
+        output.flush();
+    }
+
+    void WriteBinaryResults(const vector<TestResults>& results, ostream& output)
+    {
+        BinaryResultsWriter writer(output);
+        for(const TestResults& result: results) writer.Write(result);
+    }
+#pragma endregion
+
+#pragma region BinaryViews
+    BinaryAssertView::BinaryAssertView(const BinaryResultsReader* _reader, const char* _entry)
+    : reader{_reader}
+    , entry{_entry}
+    {}
+
+    AssertType BinaryAssertView::GetType() const { return static_cast<AssertType>(ReadRaw<uint8_t>(entry)); }
+    bool BinaryAssertView::Passed() const { return ReadRaw<uint8_t>(entry + 1) != 0; }
+    JsonStringRef BinaryAssertView::GetDescription() const { return reader->GetString(ReadRaw<uint32_t>(entry + 4)); }
+    JsonStringRef BinaryAssertView::GetDetails() const { return reader->GetString(ReadRaw<uint32_t>(entry + 8)); }
+
+    AssertResult BinaryAssertView::ToAssertResult() const
+    {
+        return AssertResult{GetType(), Passed(), GetDescription().ToString(), GetDetails().ToString()};
+    }
+
+    BinaryTestView::BinaryTestView(const BinaryResultsReader* _reader, const char* _record)
+    : reader{_reader}
+    , record{_record}
+    {}
+
+    JsonStringRef BinaryTestView::GetGroupName() const { return reader->GetString(ReadRaw<uint32_t>(record + groupIdOffset)); }
+    JsonStringRef BinaryTestView::GetMethodName() const { return reader->GetString(ReadRaw<uint32_t>(record + methodIdOffset)); }
+    int64_t BinaryTestView::GetExecutionTimeMillis() const { return ReadRaw<int64_t>(record + millisOffset); }
+    int64_t BinaryTestView::GetExecutionTimeNanos() const { return ReadRaw<int64_t>(record + nanosOffset); }
+    int64_t BinaryTestView::GetThreadCpuTimeNanos() const { return ReadRaw<int64_t>(record + threadCpuOffset); }
+    int64_t BinaryTestView::GetProcessCpuTimeNanos() const { return ReadRaw<int64_t>(record + processCpuOffset); }
+
+    size_t BinaryTestView::GetAssertCount() const { return ReadRaw<uint32_t>(record + assertCountOffset); }
+    size_t BinaryTestView::GetLogCount() const { return ReadRaw<uint32_t>(record + logCountOffset); }
+
+    BinaryAssertView BinaryTestView::GetAssert(size_t index) const
+    {
+        return BinaryAssertView(reader, record + assertsOffset + index * assertEntrySize);
+    }
+
+    JsonStringRef BinaryTestView::GetLog(size_t index) const
+    {
+        const char* logIds = record + assertsOffset + GetAssertCount() * assertEntrySize;
+        return reader->GetString(ReadRaw<uint32_t>(logIds + index * sizeof(uint32_t)));
+    }
+
+    bool BinaryTestView::AllPassed() const
+    {
+        const size_t nAsserts = GetAssertCount();
+        for(size_t i = 0; i < nAsserts; i++)
+        {
+            if(ReadRaw<uint8_t>(record + assertsOffset + i * assertEntrySize + 1) == 0) return false;
+        }
+        return true;
+    }
+
+    bool BinaryTestView::IsBenchmark() const { return (ReadRaw<uint32_t>(record + flagsOffset) & benchmarkFlag) != 0; }
+    bool BinaryTestView::HasAllocationStatistics() const { return (ReadRaw<uint32_t>(record + flagsOffset) & allocationsFlag) != 0; }
+    bool BinaryTestView::IsRepeated() const { return (ReadRaw<uint32_t>(record + flagsOffset) & repeatFlag) != 0; }
+    bool BinaryTestView::HasHardwareCounters() const { return (ReadRaw<uint32_t>(record + flagsOffset) & hardwareCountersFlag) != 0; }
+
+    size_t BinaryTestView::GetDroppedLogCount() const
+    {
+        if((ReadRaw<uint32_t>(record + flagsOffset) & droppedLogsFlag) == 0) return 0;
+        return static_cast<size_t>(ReadRaw<uint64_t>(GetSection(droppedLogsFlag)));
+    }
+
+    const char* BinaryTestView::GetSection(uint32_t flag) const
+    {
+        const uint32_t flags = ReadRaw<uint32_t>(record + flagsOffset);
+        const char* section = record + assertsOffset + GetAssertCount() * assertEntrySize + GetLogCount() * sizeof(uint32_t);
+
+        //Skips the sections present before the requested one
+        if(flag == benchmarkFlag) return section;
+        if(flags & benchmarkFlag) section += SampleSectionSize(section, benchmarkSampleCountOffset);
+        if(flag == allocationsFlag) return section;
+        if(flags & allocationsFlag) section += allocationsSectionSize;
+        if(flag == repeatFlag) return section;
+        if(flags & repeatFlag) section += SampleSectionSize(section, repeatSampleCountOffset);
+        if(flag == hardwareCountersFlag) return section;
+        if(flags & hardwareCountersFlag) section += hardwareCountersSectionSize;
+        return section;
+    }
+
+    TestResults BinaryTestView::ToTestResults() const
+    {
+        TestResults results;
+        results.groupName = GetGroupName().ToString();
+        results.methodName = GetMethodName().ToString();
+        results.executionTimeMillis = GetExecutionTimeMillis();
+        results.executionTimeNanos = GetExecutionTimeNanos();
+        results.threadCpuTimeNanos = GetThreadCpuTimeNanos();
+        results.processCpuTimeNanos = GetProcessCpuTimeNanos();
+
+        const size_t nAsserts = GetAssertCount();
+        results.assertionResults.reserve(nAsserts);
+        for(size_t i = 0; i < nAsserts; i++) results.assertionResults.emplace_back(GetAssert(i).ToAssertResult());
+
+        const size_t nLogs = GetLogCount();
+        results.logs.reserve(nLogs);
+        for(size_t i = 0; i < nLogs; i++) results.logs.emplace_back(GetLog(i).ToString());
+        results.nDroppedLogs = GetDroppedLogCount();
+
+        if(IsBenchmark())
+        {
+            const char* section = GetSection(benchmarkFlag);
+            results.isBenchmark = true;
+            results.benchmark.iterationsPerSample = ReadRaw<uint64_t>(section);
+            results.benchmark.nanosPerIterationSamples = ReadSamples(section, benchmarkSampleCountOffset);
+            //Cheaper to recompute than to store
+            results.benchmark.nanosPerIteration = ComputeSampleStatistics(results.benchmark.nanosPerIterationSamples);
+        }
+        if(HasAllocationStatistics())
+        {
+            const char* section = GetSection(allocationsFlag);
+            results.hasAllocationStatistics = true;
+            results.allocations.nAllocations = ReadRaw<uint64_t>(section);
+            results.allocations.allocatedBytes = ReadRaw<uint64_t>(section + 8);
+            results.allocations.peakLiveBytes = ReadRaw<int64_t>(section + 16);
+            results.allocations.leakedBytes = ReadRaw<int64_t>(section + 24);
+        }
+        if(IsRepeated())
+        {
+            const char* section = GetSection(repeatFlag);
+            results.isRepeated = true;
+            results.repeat.nIterations = static_cast<size_t>(ReadRaw<uint64_t>(section));
+            results.repeat.nFailedIterations = static_cast<size_t>(ReadRaw<uint64_t>(section + 8));
+            results.repeat.firstFailedIteration = static_cast<size_t>(ReadRaw<uint64_t>(section + 16));
+            results.repeat.wallNanosSamples = ReadSamples(section, repeatSampleCountOffset);
+            results.repeat.wallNanos = ComputeSampleStatistics(results.repeat.wallNanosSamples);
+        }
+        if(HasHardwareCounters())
+        {
+            const char* section = GetSection(hardwareCountersFlag);
+            results.hasHardwareCounters = true;
+            results.hardwareCounters.cycles = ReadRaw<int64_t>(section);
+            results.hardwareCounters.instructions = ReadRaw<int64_t>(section + 8);
+            results.hardwareCounters.branchMisses = ReadRaw<int64_t>(section + 16);
+            results.hardwareCounters.l1dReadMisses = ReadRaw<int64_t>(section + 24);
+            results.hardwareCounters.llcReadMisses = ReadRaw<int64_t>(section + 32);
+        }
+        return results;
+    }
+#pragma endregion
+
+#pragma region BinaryResultsReader
+    class BinaryResultsReader::MappedFile
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+#if defined(_WIN32)
+    public:
+        explicit MappedFile(const string& path)
+        {
+            const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(file == INVALID_HANDLE_VALUE) throw runtime_error("unable to open binary results file " + path);
+
+            LARGE_INTEGER fileSize;
+            if(!GetFileSizeEx(file, &fileSize))
+            {
+                CloseHandle(file);
+                throw runtime_error("unable to read binary results file " + path);
+            }
+            size = static_cast<size_t>(fileSize.QuadPart);
+
+            //An empty file cannot be mapped, it fails the header check instead
+            if(size > 0)
+            {
+                const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if(mapping != nullptr)
+                {
+                    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    //The view keeps the mapping alive
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(file);
+            if(size > 0 && data == nullptr) throw runtime_error("unable to map binary results file " + path);
+        }
+
+        ~MappedFile()
+        {
+            if(data != nullptr) UnmapViewOfFile(data);
+        }
+#else
+    public:
+        explicit MappedFile(const string& path)
+        {
+            const int fd = open(path.c_str(), O_RDONLY);
+            if(fd == -1) throw runtime_error("unable to open binary results file " + path);
+
+            struct stat status;
+            if(fstat(fd, &status) != 0)
+            {
+                close(fd);
+                throw runtime_error("unable to read binary results file " + path);
+            }
+            size = static_cast<size_t>(status.st_size);
+
+            //An empty file cannot be mapped, it fails the header check instead
+            if(size > 0)
+            {
+                void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                data = mapped != MAP_FAILED? static_cast<const char*>(mapped) : nullptr;
+            }
+            //The mapping stays valid once the descriptor is closed
+            close(fd);
+            if(size > 0 && data == nullptr) throw runtime_error("unable to map binary results file " + path);
+        }
+
+        ~MappedFile()
+        {
+            if(data != nullptr) munmap(const_cast<char*>(data), size);
+        }
+#endif
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* GetData() const { return data; }
+        size_t GetSize() const { return size; }
+    };
+
+    BinaryResultsReader BinaryResultsReader::Open(const string& path)
+    {
+        unique_ptr<MappedFile> mappedFile = make_unique<MappedFile>(path);
+        BinaryResultsReader reader(mappedFile->GetData(), mappedFile->GetSize());
+        reader.mappedFile = move(mappedFile);
+        return reader;
+    }
+
+    BinaryResultsReader::BinaryResultsReader(const char* _data, size_t _size)
+    : data{_data}
+    , size{_size}
+    {
+        Index();
+    }
+
+    //Out of line, where MappedFile is complete. Moving keeps the mapped data in place.
+    BinaryResultsReader::BinaryResultsReader(BinaryResultsReader&& other) noexcept = default;
+    BinaryResultsReader& BinaryResultsReader::operator=(BinaryResultsReader&& other) noexcept = default;
+    BinaryResultsReader::~BinaryResultsReader() = default;
+
+    void BinaryResultsReader::Index()
+    {
+        if(size < headerSize || memcmp(data, binaryMagic, sizeof(binaryMagic)) != 0)
+        {
+            throw runtime_error("not a binary results file");
+        }
+        if(ReadRaw<uint32_t>(data + sizeof(binaryMagic)) != binaryVersion)
+        {
+            throw runtime_error("unsupported binary results version");
+        }
+        if(ReadRaw<uint32_t>(data + sizeof(binaryMagic) + sizeof(uint32_t)) != byteOrderMark)
+        {
+            throw runtime_error("binary results written with a different byte order");
+        }
+
+        size_t position = headerSize;
+        while(position < size)
+        {
+            if(size - position < chunkHeaderSize)
+            {
+                truncated = true;
+                break;
+            }
+            const uint8_t kind = ReadRaw<uint8_t>(data + position);
+            const uint32_t payloadSize = ReadRaw<uint32_t>(data + position + 1);
+            const char* payload = data + position + chunkHeaderSize;
+            if(size - position - chunkHeaderSize < payloadSize)
+            {
+                truncated = true;
+                break;
+            }
+            position += chunkHeaderSize + payloadSize;
+
+            if(kind == stringChunk)
+            {
+                strings.emplace_back(payload, payloadSize);
+                continue;
+            }
+            //Unknown kinds are skipped, so that newer chunks can be added
+            if(kind != testChunk) continue;
+
+            //Checked once here, the views then read without any bounds checks
+            const size_t nStrings = strings.size();
+            if(payloadSize < assertsOffset) ThrowCorrupt("test chunk too short");
+            if(ReadRaw<uint32_t>(payload + groupIdOffset) >= nStrings || ReadRaw<uint32_t>(payload + methodIdOffset) >= nStrings)
+            {
+                ThrowCorrupt("test refers to an unknown string");
+            }
+
+            const uint64_t nAsserts = ReadRaw<uint32_t>(payload + assertCountOffset);
+            const uint64_t nLogs = ReadRaw<uint32_t>(payload + logCountOffset);
+            uint64_t sectionsOffset = assertsOffset + nAsserts * assertEntrySize + nLogs * sizeof(uint32_t);
+            if(sectionsOffset > payloadSize) ThrowCorrupt("asserts overrun their test chunk");
+
+            for(uint64_t i = 0; i < nAsserts; i++)
+            {
+                const char* entry = payload + assertsOffset + i * assertEntrySize;
+                if(ReadRaw<uint32_t>(entry + 4) >= nStrings || ReadRaw<uint32_t>(entry + 8) >= nStrings)
+                {
+                    ThrowCorrupt("assert refers to an unknown string");
+                }
+            }
+            const char* logIds = payload + assertsOffset + nAsserts * assertEntrySize;
+            for(uint64_t i = 0; i < nLogs; i++)
+            {
+                if(ReadRaw<uint32_t>(logIds + i * sizeof(uint32_t)) >= nStrings) ThrowCorrupt("log refers to an unknown string");
+            }
+
+            const uint32_t flags = ReadRaw<uint32_t>(payload + flagsOffset);
+            auto requireSection = [payloadSize, &sectionsOffset](uint64_t sectionSize)
+            {
+                if(sectionsOffset + sectionSize > payloadSize) ThrowCorrupt("statistics overrun their test chunk");
+                sectionsOffset += sectionSize;
+            };
+            auto requireSampleSection = [payload, &requireSection, &sectionsOffset](size_t countOffset)
+            {
+                requireSection(countOffset + sizeof(uint32_t));
+                const uint64_t nSamples = ReadRaw<uint32_t>(payload + sectionsOffset - sizeof(uint32_t));
+                requireSection(nSamples * sizeof(double));
+            };
+            if(flags & benchmarkFlag) requireSampleSection(benchmarkSampleCountOffset);
+            if(flags & allocationsFlag) requireSection(allocationsSectionSize);
+            if(flags & repeatFlag) requireSampleSection(repeatSampleCountOffset);
+            if(flags & hardwareCountersFlag) requireSection(hardwareCountersSectionSize);
+            if(flags & droppedLogsFlag) requireSection(droppedLogsSectionSize);
+
+            tests.push_back(payload);
+        }
+    }
+
+    JsonStringRef BinaryResultsReader::GetString(uint32_t id) const
+    {
+        return strings[id];
+    }
+
+    vector<TestResults> BinaryResultsReader::ReadAll() const
+    {
+        vector<TestResults> results;
+        results.reserve(tests.size());
+        for(size_t i = 0; i < tests.size(); i++) results.emplace_back(GetTest(i).ToTestResults());
+        return results;
+    }
+#pragma endregion
+
+#pragma region Converters
+    void ConvertBinaryResultsToJson(const BinaryResultsReader& reader, ostream& output, JsonStyle style)
+    {
+        WriteJsonReport(reader.ReadAll(), output, style);
+    }
+
+    string ConvertBinaryResultsToText(const BinaryResultsReader& reader, TextLogVerbosity verbosity)
+    {
+        return FormatAsText(reader.ReadAll(), verbosity);
+    }
+#pragma endregion
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CTest.h"
+#include "JsonWriter.h"
+
+//Compact binary encoding of test results, much faster to write & to read than the JSON report.
+//The file is a header followed by length-prefixed chunks, each either a string or a test:
+//  header  "CNRYRES\0", uint32 version, uint32 byte order mark
+//  chunk   uint8 kind, uint32 payload size, payload
+//Strings are numbered in the order they appear and each distinct string (group names, descriptions,
+//details & logs) is written only once, before the first test referring to it. Tests refer to strings
+//by number and keep their asserts in fixed-size entries, so a reader can index them in place.
+//Integers are written in native byte order; a file is only read back on a machine of the same byte order.
+namespace CTest
+{
+    using namespace std;
+
+    //Streams results as they are written, i.e. as a listener during the run (see RunOptions::listeners).
+    //A run which gets killed still leaves every completed test readable.
+    class BinaryResultsWriter : public TestListener
+    {
+        ostream& output;
+        unordered_map<string, uint32_t> stringIds;
+        string buffer;
+
+        uint32_t InternString(const string& value);
+    public:
+        //Writes the header straight away
+        explicit BinaryResultsWriter(ostream& output);
+
+        void Write(const TestResults& results);
+
+        //Also flushes the stream after every test
+        void OnTestEnd(const TestResults& results) override;
+    };
+
+    void WriteBinaryResults(const vector<TestResults>& results, ostream& output);
+
+    class BinaryResultsReader;
+
+    //Views read straight from the reader's buffer, they are only valid as long as the reader is
+    class BinaryAssertView
+    {
+        const BinaryResultsReader* reader;
+        const char* entry;
+    public:
+        BinaryAssertView(const BinaryResultsReader* reader, const char* entry);
+
+        AssertType GetType() const;
+        bool Passed() const;
+        JsonStringRef GetDescription() const;
+        JsonStringRef GetDetails() const;
+
+        AssertResult ToAssertResult() const;
+    };
+
+    class BinaryTestView
+    {
+        const BinaryResultsReader* reader;
+        const char* record;
+
+        const char* GetSection(uint32_t flag) const;
+    public:
+        BinaryTestView(const BinaryResultsReader* reader, const char* record);
+
+        JsonStringRef GetGroupName() const;
+        JsonStringRef GetMethodName() const;
+        int64_t GetExecutionTimeMillis() const;
+        int64_t GetExecutionTimeNanos() const;
+        int64_t GetThreadCpuTimeNanos() const;
+        int64_t GetProcessCpuTimeNanos() const;
+
+        size_t GetAssertCount() const;
+        BinaryAssertView GetAssert(size_t index) const;
+        size_t GetLogCount() const;
+        JsonStringRef GetLog(size_t index) const;
+        size_t GetDroppedLogCount() const;
+
+        //Scans the fixed-size assert entries only, without touching any string
+        bool AllPassed() const;
+
+        bool IsBenchmark() const;
+        bool HasAllocationStatistics() const;
+        bool IsRepeated() const;
+        bool HasHardwareCounters() const;
+
+        //Copies the test out, including its benchmark, allocation, repeat & hardware counter statistics
+        TestResults ToTestResults() const;
+    };
+
+    //Reads results written by BinaryResultsWriter in place, without copying or parsing any string.
+    //Opening indexes the chunks & checks every test refers only to strings written before it,
+    //the views then read the data unchecked.
+    class BinaryResultsReader
+    {
+        class MappedFile;
+        unique_ptr<MappedFile> mappedFile;
+        const char* data = nullptr;
+        size_t size = 0;
+        vector<JsonStringRef> strings;  //In place, indexed by string id
+        vector<const char*> tests;      //Chunk payload of each test
+        bool truncated = false;
+
+        void Index();
+    public:
+        //Memory maps the file. Throws runtime_error if it cannot be opened or is not a binary results file.
+        static BinaryResultsReader Open(const string& path);
+
+        //Reads from a buffer which has to outlive the reader
+        BinaryResultsReader(const char* data, size_t size);
+
+        BinaryResultsReader(BinaryResultsReader&& other) noexcept;
+        BinaryResultsReader& operator=(BinaryResultsReader&& other) noexcept;
+        ~BinaryResultsReader();
+
+        size_t GetTestCount() const { return tests.size(); }
+        BinaryTestView GetTest(size_t index) const { return BinaryTestView(this, tests[index]); }
+
+        size_t GetStringCount() const { return strings.size(); }
+        JsonStringRef GetString(uint32_t id) const;
+
+        //Whether the file ends part way through a chunk, i.e. the writing run was killed.
+        //Every test before that point is still read.
+        bool IsTruncated() const { return truncated; }
+
+        vector<TestResults> ReadAll() const;
+    };
+
+    //Converters to the existing reports, the tests are copied out first
+    void ConvertBinaryResultsToJson(const BinaryResultsReader& reader, ostream& output, JsonStyle style);
+    string ConvertBinaryResultsToText(
+        const BinaryResultsReader& reader,
+        TextLogVerbosity verbosity = TextLogVerbosity::printAdditionalDetailsOnFailingTests);
+}
@@ -3,22 +3,65 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <regex>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
 
 #include "formatter.h"
+#include "WorkStealingPool.h"
+#include "ForkedWorkerPool.h"
+#include "TestHistory.h"
+#include "PerformanceBaselines.h"
+#include "Watchdog.h"
+#include "AllocationTracking.h"
+#include "PerfCounters.h"
 
 namespace CTest
 {
+    //Defined with the reports
+    string FormatNanos(double nanos);
+
 #pragma region Tester
-    Tester::Tester(TestResults& _boundResults)
+    Tester::Tester(TestResults& _boundResults, TestListener* _listener, TextLogVerbosity _detailVerbosity, const atomic<bool>* _runCancelled, const LogOptions& _logOptions)
         :boundResults(_boundResults)
+        ,listener(_listener)
+        ,detailVerbosity(_detailVerbosity)
+        ,runCancelled(_runCancelled)
+        ,logBuffer(_logOptions.maxLogsPerTest)
+        ,logRetention(_logOptions.retention)
     {}
 
+    bool Tester::run_cancelled() const
+    {
+        return runCancelled != nullptr && runCancelled->load(memory_order_relaxed);
+    }
+
+    bool Tester::ShouldCaptureDetails(bool passed) const
+    {
+        //Failures are always recorded, the verbosity only decides what the text log prints
+        return !passed || detailVerbosity == TextLogVerbosity::alwaysPrintAdditionalDetails;
+    }
+
     void Tester::AddAssertResult(
         AssertType enType, 
         bool passed, 
         const string& description,
         const string& details)
     {
+        const AllocationTrackingPause bookkeeping;
         boundResults.assertionResults.emplace_back(
             AssertResult{
                 enType,
@@ -26,163 +69,1187 @@ namespace CTest
                 description,
                 details
             }
-        );
+        );
+
+        if(listener != nullptr)
+        {
+            listener->OnAssert(boundResults.groupName, boundResults.methodName, boundResults.assertionResults.back());
+        }
+
+        //Cooperative cancellation, tests running when the run is cancelled stop at their next assert
+        if(run_cancelled()) throw AbortTestMethod{};
+    }
+
+    void Tester::StopIfLastAssertFailed()
+    {
+        if(!boundResults.assertionResults.back().passed) throw AbortTestMethod{};
+    }
+
+    void Tester::assert(bool expressionPassed, const string& description)
+    {
+        AddAssertResult(AssertType::plain_assert, expressionPassed, description, "");
+    }    
+
+    void Tester::TestForThrow(const bool throwExpected, std::function<void(void)>& expr, const string& description)
+    {
+        bool exceptionThrown = false;
+        string stdExceptionMsg;
+        try
+        {
+            expr();
+        }
+        catch(const AbortTestMethod&)
+        {
+            //A require_* failing inside expr stops the test, it is not the exception being tested for
+            throw;
+        }
+        catch(const exception& stdException)
+        {
+            exceptionThrown = true;
+            stdExceptionMsg = "exception message: " + string(stdException.what());
+        }
+        catch(...)
+        {
+            exceptionThrown = true;
+            stdExceptionMsg = "No message logged - exception does not inherit from std::exception";
+        }
+
+        const bool throwCriteriaMet = exceptionThrown == throwExpected;
+
+        AddAssertResult(
+            throwExpected? AssertType::assert_throws : AssertType::assert_nothrow,
+            throwCriteriaMet, 
+            description,
+            stdExceptionMsg
+        );
+    }
+
+    void Tester::assert_throw(std::function<void(void)> expr, const string& description)
+    {
+        TestForThrow(true, expr, description);
+    }
+
+    void Tester::assert_nothrow(std::function<void(void)> expr, const string& description)
+    {
+        TestForThrow(false, expr, description);
+    }
+
+    void Tester::assert_max_allocations(uint64_t maxAllocations, std::function<void(void)> expr, const string& description)
+    {
+        AllocationCounters counters;
+        {
+            const AllocationScope scope(counters);
+            expr();
+        }
+
+        if(!IsAllocationTrackingEnabled())
+        {
+            AddAssertResult(AssertType::allocation_budget, false, description, "Not checked, built without CANARY_TRACK_ALLOCATIONS");
+            return;
+        }
+
+        const bool passed = counters.nAllocations <= maxAllocations;
+        AddAssertResult(
+            AssertType::allocation_budget,
+            passed,
+            description,
+            ShouldCaptureDetails(passed)?
+                cfmt("Allocations: %t |Maximum: %t", counters.nAllocations, maxAllocations) :
+                string()
+        );
+    }
+
+    void Tester::assert_max_peak_bytes(int64_t maxPeakBytes, std::function<void(void)> expr, const string& description)
+    {
+        AllocationCounters counters;
+        {
+            const AllocationScope scope(counters);
+            expr();
+        }
+
+        if(!IsAllocationTrackingEnabled())
+        {
+            AddAssertResult(AssertType::allocation_budget, false, description, "Not checked, built without CANARY_TRACK_ALLOCATIONS");
+            return;
+        }
+
+        const bool passed = counters.peakLiveBytes <= maxPeakBytes;
+        AddAssertResult(
+            AssertType::allocation_budget,
+            passed,
+            description,
+            ShouldCaptureDetails(passed)?
+                cfmt("Peak live bytes: %t |Maximum: %t", counters.peakLiveBytes, maxPeakBytes) :
+                string()
+        );
+    }
+
+    void Tester::assert_max_median_nanos(int64_t maxMedianNanos, std::function<void(void)> expr, const string& description, size_t nSamples)
+    {
+        if(nSamples == 0) throw invalid_argument("assert_max_median_nanos needs at least 1 sample");
+
+        //Not timed, faults in code & data on first use
+        expr();
+
+        vector<double> samples;
+        samples.reserve(nSamples);
+        for(size_t i = 0; i < nSamples; i++)
+        {
+            const auto startTime = chrono::steady_clock::now();
+            expr();
+            const auto endTime = chrono::steady_clock::now();
+            samples.push_back(static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(endTime - startTime).count()));
+        }
+
+        const double medianNanos = ComputeSampleStatistics(move(samples)).median;
+        const bool passed = medianNanos <= static_cast<double>(maxMedianNanos);
+        AddAssertResult(
+            AssertType::time_budget,
+            passed,
+            description,
+            ShouldCaptureDetails(passed)?
+                cfmt("Median: %tns |Maximum: %tns (%t samples)", FormatNanos(medianNanos), maxMedianNanos, nSamples) :
+                string()
+        );
+    }
+
+    void Tester::require(bool expressionPassed, const string& description)
+    {
+        assert(expressionPassed, description);
+        StopIfLastAssertFailed();
+    }
+
+    void Tester::require_throw(std::function<void(void)> expr, const string& description)
+    {
+        TestForThrow(true, expr, description);
+        StopIfLastAssertFailed();
+    }
+
+    void Tester::require_nothrow(std::function<void(void)> expr, const string& description)
+    {
+        TestForThrow(false, expr, description);
+        StopIfLastAssertFailed();
+    }
+
+    void Tester::log(const string& message)
+    {
+        const AllocationTrackingPause bookkeeping;
+        logBuffer.Push(message);
+    }
+
+    void Tester::EmitLogs()
+    {
+        if(logRetention == LogRetention::failingTestsOnly && boundResults.GetNumberOfPassedAndFailedCases().second == 0)
+        {
+            logBuffer.Discard();
+            return;
+        }
+        boundResults.nDroppedLogs += logBuffer.GetDroppedCount();
+        logBuffer.MoveTo(boundResults.logs);
+    }
+#pragma endregion
+
+#pragma region CpuClocks
+    namespace
+    {
+#if defined(_WIN32)
+        int64_t FileTimeToNanos(const FILETIME& fileTime)
+        {
+            ULARGE_INTEGER ticks;
+            ticks.LowPart = fileTime.dwLowDateTime;
+            ticks.HighPart = fileTime.dwHighDateTime;
+            return static_cast<int64_t>(ticks.QuadPart) * 100; //100ns ticks
+        }
+
+        int64_t GetThreadCpuTimeNanos()
+        {
+            FILETIME creation, exit, kernel, user;
+            if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+            return FileTimeToNanos(kernel) + FileTimeToNanos(user);
+        }
+
+        int64_t GetProcessCpuTimeNanos()
+        {
+            FILETIME creation, exit, kernel, user;
+            if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+            return FileTimeToNanos(kernel) + FileTimeToNanos(user);
+        }
+#elif defined(CLOCK_THREAD_CPUTIME_ID) && defined(CLOCK_PROCESS_CPUTIME_ID)
+        int64_t ReadClockNanos(clockid_t clockId)
+        {
+            timespec time;
+            if(clock_gettime(clockId, &time) != 0) return 0;
+            return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+        }
+
+        int64_t GetThreadCpuTimeNanos()
+        {
+            return ReadClockNanos(CLOCK_THREAD_CPUTIME_ID);
+        }
+
+        int64_t GetProcessCpuTimeNanos()
+        {
+            return ReadClockNanos(CLOCK_PROCESS_CPUTIME_ID);
+        }
+#else
+        //No per-thread clock available, the process clock is the closest approximation
+        int64_t GetProcessCpuTimeNanos()
+        {
+            return static_cast<int64_t>(clock()) * (1000000000 / CLOCKS_PER_SEC);
+        }
+
+        int64_t GetThreadCpuTimeNanos()
+        {
+            return GetProcessCpuTimeNanos();
+        }
+#endif
+    }
+#pragma endregion
+
+#pragma region Canary
+    namespace
+    {
+        //'*' matches any run of characters, '?' any single one.
+        //Backtracks only to the most recent '*', so matching stays linear in practice.
+        bool MatchesGlob(const string& pattern, const string& text)
+        {
+            size_t p = 0;
+            size_t t = 0;
+            size_t starPattern = string::npos;
+            size_t starText = 0;
+
+            while(t < text.size())
+            {
+                if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+                {
+                    p++;
+                    t++;
+                }
+                else if(p < pattern.size() && pattern[p] == '*')
+                {
+                    starPattern = p++;
+                    starText = t;
+                }
+                else if(starPattern != string::npos)
+                {
+                    p = starPattern + 1;
+                    t = ++starText;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            while(p < pattern.size() && pattern[p] == '*') p++;
+            return p == pattern.size();
+        }
+
+        bool ContainsAny(const vector<string>& values, const vector<string>& wanted)
+        {
+            return any_of(values.begin(), values.end(), [&wanted](const string& value)
+            {
+                return find(wanted.begin(), wanted.end(), value) != wanted.end();
+            });
+        }
+
+        //Sorted union of several index lists, i.e. registration order without duplicates
+        vector<size_t> MergeIndexLists(const vector<const vector<size_t>*>& lists)
+        {
+            vector<size_t> merged;
+            for(const vector<size_t>* list: lists) merged.insert(merged.end(), list->begin(), list->end());
+
+            sort(merged.begin(), merged.end());
+            merged.erase(unique(merged.begin(), merged.end()), merged.end());
+            return merged;
+        }
+    }
+
+    class Canary::RegistryIndex
+    {
+        mutex indexLock;
+        size_t nIndexedMethods = 0;
+        unordered_map<string, vector<size_t>> methodsByGroup;
+        unordered_map<string, vector<size_t>> methodsByTag;
+
+        void CatchUp(const vector<TestMethod>& methodList)
+        {
+            for(; nIndexedMethods < methodList.size(); nIndexedMethods++)
+            {
+                const TestMethod& method = methodList[nIndexedMethods];
+                methodsByGroup[method.groupName].push_back(nIndexedMethods);
+                for(const string& tag: method.tags) methodsByTag[tag].push_back(nIndexedMethods);
+            }
+        }
+
+        vector<size_t> Lookup(const unordered_map<string, vector<size_t>>& index, const vector<string>& keys) const
+        {
+            vector<const vector<size_t>*> lists;
+            for(const string& key: keys)
+            {
+                const auto found = index.find(key);
+                if(found != index.end()) lists.push_back(&found->second);
+            }
+            return MergeIndexLists(lists);
+        }
+    public:
+        //Indices of the tests in any of 'groups', or carrying any of 'tags' if no groups are given.
+        //Only to narrow down the candidates, the remaining criteria are checked per test.
+        vector<size_t> Candidates(const vector<TestMethod>& methodList, const vector<string>& groups, const vector<string>& tags)
+        {
+            //Tests can run queries of their own, possibly from several worker threads
+            lock_guard<mutex> guard(indexLock);
+            CatchUp(methodList);
+
+            if(!groups.empty()) return Lookup(methodsByGroup, groups);
+            if(!tags.empty()) return Lookup(methodsByTag, tags);
+
+            vector<size_t> all(methodList.size());
+            for(size_t i = 0; i < all.size(); i++) all[i] = i;
+            return all;
+        }
+    };
+
+    Canary::Canary()
+    : registryIndex{make_unique<RegistryIndex>()}
+    {}
+
+    Canary::~Canary() = default;
+
+    Canary& Canary::Instance()
+    {
+        static Canary singleton;
+        return singleton;
+    }
+
+    void Canary::AddTestMethod(const string& methodName, const string& groupName, TTestMethod testMethod, vector<string> tags, int64_t timeoutMillis)
+    {
+        if(timeoutMillis < 0) throw invalid_argument("test timeout must not be negative");
+
+        testMethodList.emplace_back(
+            TestMethod{
+                methodName,
+                groupName,
+                move(testMethod),
+                move(tags),
+                timeoutMillis
+            }
+        );
+    }
+
+    vector<size_t> Canary::SelectTests(const TestQuery& query)
+    {
+        vector<size_t> selection = registryIndex->Candidates(testMethodList, query.groups, query.includeTags);
+
+        //Compile each regex once rather than once per test
+        vector<regex> nameRegexes;
+        if(query.patternSyntax == NamePatternSyntax::regex)
+        {
+            for(const string& pattern: query.namePatterns) nameRegexes.emplace_back(pattern);
+        }
+
+        auto isSelected = [this, &query, &nameRegexes](size_t methodIndex)
+        {
+            const TestMethod& method = testMethodList[methodIndex];
+            if(!query.groups.empty() && !query.includeTags.empty() && !ContainsAny(method.tags, query.includeTags)) return false;
+            if(ContainsAny(method.tags, query.excludeTags)) return false;
+            if(query.namePatterns.empty()) return true;
+
+            if(query.patternSyntax == NamePatternSyntax::regex)
+            {
+                return any_of(nameRegexes.begin(), nameRegexes.end(), [&method](const regex& pattern)
+                {
+                    return regex_match(method.name, pattern);
+                });
+            }
+            return any_of(query.namePatterns.begin(), query.namePatterns.end(), [&method](const string& pattern)
+            {
+                return MatchesGlob(pattern, method.name);
+            });
+        };
+
+        selection.erase(
+            remove_if(selection.begin(), selection.end(), [&isSelected](size_t methodIndex) { return !isSelected(methodIndex); }),
+            selection.end()
+        );
+        return selection;
+    }
+
+    //Sorts in place by moving the results around, nothing inside of them is copied
+    void SortFailedTestFirst_ThenByGroup_ThenByAlphabeticalOrder(vector<TestResults>& results)
+    {
+        vector<size_t> sortedOrder;
+        sortedOrder.reserve(results.size());
+        {
+            const TestResultsView view(results, ResultOrder::failedTestsFirst);
+            for(const TestResultsEntry& entry: view.GetEntries())
+            {
+                sortedOrder.push_back(static_cast<size_t>(entry.results - results.data()));
+            }
+        }
+
+        vector<TestResults> sorted;
+        sorted.reserve(results.size());
+        for(const size_t index: sortedOrder)
+        {
+            sorted.emplace_back(move(results[index]));
+        }
+        results.swap(sorted);
+    }
+
+    namespace
+    {
+        //Stops watching a task even if the test method throws
+        struct DeadlineScope
+        {
+            Watchdog* watchdog;
+            size_t taskIndex;
+            ~DeadlineScope() { if(watchdog != nullptr) watchdog->Finish(taskIndex); }
+        };
+
+        //Combines the iterations of one repeated test, which may be running on several workers ("lanes") at once
+        class RepeatedRun
+        {
+            const RepeatOptions& options;
+            const atomic<bool>* runCancelled;
+            mutex lock;
+            size_t nextIteration = 0;
+            size_t nRunningLanes;
+            bool anyIterationFailed = false;
+            chrono::steady_clock::time_point deadline;
+
+            //Iteration whose asserts & logs are reported
+            size_t shownIteration = SIZE_MAX;
+            bool shownIterationFailed = false;
+            TestResults combined;
+
+        public:
+            RepeatedRun(const string& groupName, const string& methodName, const RepeatOptions& _options, size_t nLanes, const atomic<bool>* _runCancelled)
+            : options{_options}
+            , runCancelled{_runCancelled}
+            , nRunningLanes{nLanes}
+            {
+                combined.groupName = groupName;
+                combined.methodName = methodName;
+                combined.executionTimeMillis = 0;
+                combined.isRepeated = true;
+            }
+
+            //Claims the next iteration to run, false once the count or budget is used up
+            bool NextIteration(size_t& iteration)
+            {
+                lock_guard<mutex> guard(lock);
+                if(options.count != 0 && nextIteration >= options.count) return false;
+                if(options.untilFirstFailure && anyIterationFailed) return false;
+                if(runCancelled != nullptr && runCancelled->load(memory_order_relaxed)) return false;
+
+                const auto now = chrono::steady_clock::now();
+                if(nextIteration == 0) deadline = now + chrono::milliseconds(options.budgetMillis);
+                else if(options.budgetMillis > 0 && now >= deadline) return false;
+
+                iteration = nextIteration++;
+                return true;
+            }
+
+            void AddIteration(size_t iteration, TestResults&& result)
+            {
+                const bool failed = result.GetNumberOfPassedAndFailedCases().second > 0;
+
+                lock_guard<mutex> guard(lock);
+                RepeatStatistics& repeat = combined.repeat;
+                repeat.nIterations++;
+                repeat.wallNanosSamples.push_back(static_cast<double>(result.executionTimeNanos));
+                if(failed)
+                {
+                    if(repeat.nFailedIterations == 0 || iteration < repeat.firstFailedIteration) repeat.firstFailedIteration = iteration;
+                    repeat.nFailedIterations++;
+                    anyIterationFailed = true;
+                }
+
+                combined.executionTimeNanos += result.executionTimeNanos;
+                combined.threadCpuTimeNanos += result.threadCpuTimeNanos;
+                combined.processCpuTimeNanos += result.processCpuTimeNanos;
+
+                if(result.hasAllocationStatistics)
+                {
+                    AllocationStatistics& allocations = combined.allocations;
+                    combined.hasAllocationStatistics = true;
+                    allocations.nAllocations += result.allocations.nAllocations;
+                    allocations.allocatedBytes += result.allocations.allocatedBytes;
+                    allocations.peakLiveBytes = max(allocations.peakLiveBytes, result.allocations.peakLiveBytes);
+                    allocations.leakedBytes += result.allocations.leakedBytes;
+                }
+
+                if(result.hasHardwareCounters)
+                {
+                    HardwareCounterStatistics& counters = combined.hardwareCounters;
+                    const HardwareCounterStatistics& iterationCounters = result.hardwareCounters;
+                    if(!combined.hasHardwareCounters)
+                    {
+                        combined.hasHardwareCounters = true;
+                        counters = iterationCounters;
+                    }
+                    else
+                    {
+                        //An event missing from any iteration is missing from the total
+                        auto addCount = [](int64_t& total, int64_t count) { total = total < 0 || count < 0? -1 : total + count; };
+                        addCount(counters.cycles, iterationCounters.cycles);
+                        addCount(counters.instructions, iterationCounters.instructions);
+                        addCount(counters.branchMisses, iterationCounters.branchMisses);
+                        addCount(counters.l1dReadMisses, iterationCounters.l1dReadMisses);
+                        addCount(counters.llcReadMisses, iterationCounters.llcReadMisses);
+                    }
+                }
+
+                //Lanes finish out of order, so keep whichever iteration is earliest among the failing ones
+                const bool showFailure = failed && (!shownIterationFailed || iteration < shownIteration);
+                const bool showFirst = !failed && !shownIterationFailed && iteration < shownIteration;
+                if(showFailure || showFirst)
+                {
+                    combined.assertionResults = move(result.assertionResults);
+                    combined.logs = move(result.logs);
+                    combined.nDroppedLogs = result.nDroppedLogs;
+                    combined.isBenchmark = result.isBenchmark;
+                    combined.benchmark = move(result.benchmark);
+                    shownIteration = iteration;
+                    shownIterationFailed = failed;
+                }
+            }
+
+            //True for the last lane to finish, which then reports the combined results
+            bool LaneFinished()
+            {
+                lock_guard<mutex> guard(lock);
+                return --nRunningLanes == 0;
+            }
+
+            TestResults TakeResults()
+            {
+                lock_guard<mutex> guard(lock);
+                combined.executionTimeMillis = combined.executionTimeNanos / 1000000;
+                combined.repeat.wallNanos = ComputeSampleStatistics(combined.repeat.wallNanosSamples);
+                return move(combined);
+            }
+        };
+    }
+
+    //Fans events out to the run's listeners and collects the finished results
+    class Canary::RunProgress : public TestListener
+    {
+        const vector<TestListener*>& listeners;
+        const bool retainResults;
+        TestHistory* history;
+        const string& historyFile;
+        PerformanceBaselines* baselines;
+        const BaselineOptions& baselineOptions;
+        const TextLogVerbosity detailVerbosity;
+        const size_t maxFailures;
+        mutex eventLock;
+        vector<TestResults> results;
+        vector<bool> resultReported;
+        size_t nReportedResults = 0;
+        OverallTestResults overallResults;
+        atomic<bool> cancelled{false};
+
+        //Adds a 'regression' assert to a passing test which has a baseline, records one for those without
+        void ApplyBaseline(TestResults& result)
+        {
+            //A failing test's timings say nothing about its performance
+            if(result.GetNumberOfPassedAndFailedCases().second > 0) return;
+
+            const PerformanceBaselines::Comparison comparison = baselineOptions.mode == BaselineMode::compare?
+                baselines->Compare(result, baselineOptions) :
+                PerformanceBaselines::Comparison{};
+            if(!comparison.hasBaseline)
+            {
+                baselines->Record(result);
+                return;
+            }
+            if(!comparison.conclusive)
+            {
+                //A baseline with enough samples is kept rather than replaced by a run with too few
+                if(comparison.baseline.nSamples < baselineOptions.minSamples) baselines->Record(result);
+                return;
+            }
+
+            const bool passed = !comparison.regressed;
+            const bool captureDetails = !passed || detailVerbosity == TextLogVerbosity::alwaysPrintAdditionalDetails;
+            result.assertionResults.emplace_back(
+                AssertResult{
+                    AssertType::performance_regression,
+                    passed,
+                    "Median time within the performance baseline",
+                    captureDetails?
+                        cfmt("Median: %tns (%t samples) |Baseline median: %tns, MAD %tns (%t samples), limit %tns",
+                            FormatNanos(comparison.medianNanos),
+                            comparison.nSamples,
+                            FormatNanos(comparison.baseline.medianNanos),
+                            FormatNanos(comparison.baseline.madNanos),
+                            comparison.baseline.nSamples,
+                            FormatNanos(comparison.limitNanos)
+                        ) :
+                        string()
+                }
+            );
+            for(TestListener* pListener: listeners)
+            {
+                pListener->OnAssert(result.groupName, result.methodName, result.assertionResults.back());
+            }
+        }
+
+        void NotifyTestEnd(size_t methodIndex, TestResults&& result)
+        {
+            //Tests finishing after the cancellation may have been cut short, only their failures are meaningful
+            const bool cutShort = cancelled.load(memory_order_relaxed);
+            if(baselines != nullptr && !cutShort) ApplyBaseline(result);
+
+            const auto passedAndFailed = result.GetNumberOfPassedAndFailedCases();
+            const bool failed = passedAndFailed.second > 0;
+            if(cutShort && !failed) return;
+
+            overallResults.Accumulate(result, passedAndFailed.first, passedAndFailed.second);
+            if(history != nullptr) history->Record(result);
+            for(TestListener* pListener: listeners) pListener->OnTestEnd(result);
+
+            if(maxFailures > 0 && overallResults.nTotalFailedTests >= maxFailures) cancelled.store(true);
+
+            if(retainResults)
+            {
+                results[methodIndex] = move(result);
+                resultReported[methodIndex] = true;
+                nReportedResults++;
+            }
+        }
+    public:
+        RunProgress(const RunOptions& options, size_t nTests, TestHistory* _history, PerformanceBaselines* _baselines)
+        : listeners{options.listeners}
+        , retainResults{options.retainResults}
+        , history{_history}
+        , historyFile{options.historyFile}
+        , baselines{_baselines}
+        , baselineOptions{options.baseline}
+        , detailVerbosity{options.detailVerbosity}
+        , maxFailures{options.maxFailures}
+        , results(options.retainResults? nTests : 0)
+        , resultReported(results.size(), false)
+        {}
+
+        bool IsCancelled() const
+        {
+            return cancelled.load(memory_order_relaxed);
+        }
+
+        const atomic<bool>* CancellationFlag() const
+        {
+            return maxFailures > 0? &cancelled : nullptr;
+        }
+
+        //Tests only need to report their progress when somebody is listening
+        TestListener* TestEventSink() 
+        {
+            return listeners.empty()? nullptr : this;
+        }
+
+        void OnRunStart(size_t nTests) override
+        {
+            lock_guard<mutex> guard(eventLock);
+            for(TestListener* pListener: listeners) pListener->OnRunStart(nTests);
+        }
+
+        void OnTestStart(const string& groupName, const string& methodName) override
+        {
+            lock_guard<mutex> guard(eventLock);
+            for(TestListener* pListener: listeners) pListener->OnTestStart(groupName, methodName);
+        }
+
+        void OnAssert(const string& groupName, const string& methodName, const AssertResult& result) override
+        {
+            lock_guard<mutex> guard(eventLock);
+            for(TestListener* pListener: listeners) pListener->OnAssert(groupName, methodName, result);
+        }
+
+        void TestFinished(size_t methodIndex, TestResults&& result)
+        {
+            lock_guard<mutex> guard(eventLock);
+            NotifyTestEnd(methodIndex, move(result));
+        }
+
+        //For tests whose start and assert events could not be reported as they happened
+        void ReplayFinishedTest(size_t methodIndex, TestResults&& result)
+        {
+            lock_guard<mutex> guard(eventLock);
+            for(TestListener* pListener: listeners)
+            {
+                pListener->OnTestStart(result.groupName, result.methodName);
+                for(const AssertResult& assertResult: result.assertionResults)
+                {
+                    pListener->OnAssert(result.groupName, result.methodName, assertResult);
+                }
+            }
+            NotifyTestEnd(methodIndex, move(result));
+        }
+
+        void RunFinished()
+        {
+            lock_guard<mutex> guard(eventLock);
+            for(TestListener* pListener: listeners) pListener->OnRunEnd(overallResults);
+        }
+
+        //A test running on a thread cannot be abandoned, so the run ends here: the listeners see
+        //the overrun test & the end of the run, so streamed reports are complete up to this point
+        [[noreturn]] void AbortRun(size_t methodIndex, TestResults&& timedOut)
+        {
+            lock_guard<mutex> guard(eventLock);
+            cerr << "Test " << timedOut.groupName << "::" << timedOut.methodName << " timed out, aborting the run" << endl;
+
+            NotifyTestEnd(methodIndex, move(timedOut));
+            for(TestListener* pListener: listeners) pListener->OnRunEnd(overallResults);
+
+            if(history != nullptr)
+            {
+                //Nothing else can report the failure from here on
+                try { history->Save(historyFile); } catch(const exception&) {}
+            }
+
+            cout.flush();
+            fflush(nullptr);
+            _Exit(timeoutExitCode);
+        }
+
+        vector<TestResults> TakeSortedResults()
+        {
+            //Tests skipped by a cancelled run leave their slots empty
+            if(nReportedResults < results.size())
+            {
+                size_t nKept = 0;
+                for(size_t i = 0; i < results.size(); i++)
+                {
+                    if(!resultReported[i]) continue;
+                    //Moving a slot onto itself would empty it
+                    if(nKept != i) results[nKept] = move(results[i]);
+                    nKept++;
+                }
+                results.resize(nKept);
+            }
+
+            SortFailedTestFirst_ThenByGroup_ThenByAlphabeticalOrder(results);
+            return move(results);
+        }
+    };
+
+    TestResults Canary::ExecuteTestMethod(const TestMethod& testMethod, TestListener* listener, TextLogVerbosity detailVerbosity, const atomic<bool>* runCancelled, bool countHardwareEvents, const LogOptions& logOptions)
+    {
+        TestResults testResultSet;
+        testResultSet.groupName = testMethod.groupName;
+        testResultSet.methodName = testMethod.name;
+        Tester tester(testResultSet, listener, detailVerbosity, runCancelled, logOptions);
+
+        if(listener != nullptr) listener->OnTestStart(testMethod.groupName, testMethod.name);
+
+        //Opened for every test rather than once per thread, as a forked worker has to count its own thread
+        unique_ptr<PerfCounterGroup> perfCounters = countHardwareEvents? make_unique<PerfCounterGroup>() : nullptr;
+        int64_t hardwareCounts[nPerfEvents];
+        bool countedHardwareEvents = false;
+
+        const int64_t startThreadCpuNanos = GetThreadCpuTimeNanos();
+        const int64_t startProcessCpuNanos = GetProcessCpuTimeNanos();
+        AllocationCounters allocationCounters;
+        const auto startTime = chrono::steady_clock::now();
+        {
+            const AllocationScope allocationScope(allocationCounters);
+            if(perfCounters) perfCounters->Start();
+            try
+            {
+                testMethod.method(tester);
+            }
+            catch(const AbortTestMethod&)
+            {
+                //Stopped by a failing require_* or a cancelled run, the asserts recorded so far stand
+            }
+            if(perfCounters) countedHardwareEvents = perfCounters->Stop(hardwareCounts);
+        }
+        const auto endTime = chrono::steady_clock::now();
+        const int64_t endProcessCpuNanos = GetProcessCpuTimeNanos();
+        const int64_t endThreadCpuNanos = GetThreadCpuTimeNanos();
+
+        //Formatted outside the timed & allocation tracked scope, deferred logs cost the test next to nothing
+        tester.EmitLogs();
+
+        const int64_t elapsedNanos = 
+            chrono::duration_cast<chrono::nanoseconds>(endTime - startTime).count();
+
+        testResultSet.executionTimeNanos = elapsedNanos;
+        testResultSet.executionTimeMillis = elapsedNanos / 1000000;
+        testResultSet.threadCpuTimeNanos = endThreadCpuNanos - startThreadCpuNanos;
+        testResultSet.processCpuTimeNanos = endProcessCpuNanos - startProcessCpuNanos;
+
+        if(IsAllocationTrackingEnabled())
+        {
+            AllocationStatistics& allocations = testResultSet.allocations;
+            testResultSet.hasAllocationStatistics = true;
+            allocations.nAllocations = allocationCounters.nAllocations;
+            allocations.allocatedBytes = allocationCounters.allocatedBytes;
+            allocations.peakLiveBytes = allocationCounters.peakLiveBytes;
+            allocations.leakedBytes = max<int64_t>(allocationCounters.liveBytes, 0);
+        }
+
+        if(countedHardwareEvents)
+        {
+            HardwareCounterStatistics& counters = testResultSet.hardwareCounters;
+            testResultSet.hasHardwareCounters = true;
+            counters.cycles = hardwareCounts[static_cast<size_t>(PerfEvent::cycles)];
+            counters.instructions = hardwareCounts[static_cast<size_t>(PerfEvent::instructions)];
+            counters.branchMisses = hardwareCounts[static_cast<size_t>(PerfEvent::branchMisses)];
+            counters.l1dReadMisses = hardwareCounts[static_cast<size_t>(PerfEvent::l1dReadMisses)];
+            counters.llcReadMisses = hardwareCounts[static_cast<size_t>(PerfEvent::llcReadMisses)];
+        }
+        return testResultSet;
+    }
+
+    TestResults Canary::MakeTerminatedTestResults(const TestMethod& testMethod, const string& reason)
+    {
+        TestResults terminated;
+        terminated.groupName = testMethod.groupName;
+        terminated.methodName = testMethod.name;
+        terminated.executionTimeMillis = 0;
+        terminated.assertionResults.emplace_back(
+            AssertResult{
+                AssertType::process_terminated,
+                false,
+                "Test method terminated its worker process",
+                reason
+            }
+        );
+        return terminated;
+    }
+
+    TestResults Canary::MakeTimedOutTestResults(const TestMethod& testMethod, const string& details)
+    {
+        TestResults timedOut;
+        timedOut.groupName = testMethod.groupName;
+        timedOut.methodName = testMethod.name;
+        timedOut.executionTimeMillis = 0;
+        timedOut.assertionResults.emplace_back(
+            AssertResult{
+                AssertType::timeout,
+                false,
+                "Test method exceeded its timeout",
+                details
+            }
+        );
+        return timedOut;
+    }
+
+    int64_t Canary::ResolveTimeoutMillis(const TestMethod& testMethod, const RunOptions& options)
+    {
+        return testMethod.timeoutMillis > 0? testMethod.timeoutMillis : options.defaultTimeoutMillis;
+    }
+
+    void Canary::ExecuteInForkedProcesses(const vector<size_t>& selection, const vector<size_t>& taskOrder, size_t nWorkers, const RunOptions& options, RunProgress& progress) const
+    {
+        const TextLogVerbosity detailVerbosity = options.detailVerbosity;
+
+        ForkedWorkerPool pool(nWorkers);
+        pool.Run(
+            taskOrder,
+            [this, &selection, &options, detailVerbosity](size_t taskIndex)
+            {
+                const TestMethod& method = testMethodList[selection[taskIndex]];
+                return options.repeat.IsRepeating()?
+                    ExecuteRepeatedTestMethod(method, options) :
+                    ExecuteTestMethod(method, nullptr, detailVerbosity, nullptr, options.countHardwareEvents, options.logs);
+            },
+            [this, &selection](size_t taskIndex, const string& reason)
+            {
+                return MakeTerminatedTestResults(testMethodList[selection[taskIndex]], reason);
+            },
+            [&progress](size_t taskIndex, TestResults&& result)
+            {
+                progress.ReplayFinishedTest(taskIndex, move(result));
+            },
+            [this, &selection, &options](size_t taskIndex)
+            {
+                //The parent only sees the task as a whole, so a repeated test gets the deadline of all its iterations
+                const int64_t timeoutMillis = ResolveTimeoutMillis(testMethodList[selection[taskIndex]], options);
+                const RepeatOptions& repeat = options.repeat;
+                if(timeoutMillis <= 0 || !repeat.IsRepeating()) return timeoutMillis;
+
+                const int64_t byCount = repeat.count == 0? INT64_MAX : timeoutMillis * static_cast<int64_t>(repeat.count);
+                const int64_t byBudget = repeat.budgetMillis > 0? repeat.budgetMillis + timeoutMillis : INT64_MAX;
+                return min(byCount, byBudget);
+            },
+            [this, &selection](size_t taskIndex, const string& reason)
+            {
+                return MakeTimedOutTestResults(testMethodList[selection[taskIndex]], reason);
+            },
+            [&progress]
+            {
+                return progress.IsCancelled();
+            }
+        );
+    }
+
+    unique_ptr<Watchdog> Canary::StartWatchdog(const vector<size_t>& selection, size_t keysPerTest, const RunOptions& options, RunProgress& progress) const
+    {
+        //Only started when some test has a deadline to watch
+        const bool anyTimeout = any_of(selection.begin(), selection.end(), [this, &options](size_t methodIndex)
+        {
+            return ResolveTimeoutMillis(testMethodList[methodIndex], options) > 0;
+        });
+        if(!anyTimeout) return nullptr;
+
+        return make_unique<Watchdog>([this, &selection, keysPerTest, &options, &progress](size_t key, int64_t elapsedNanos)
+        {
+            const size_t testIndex = key / keysPerTest;
+            const TestMethod& method = testMethodList[selection[testIndex]];
+            TestResults timedOut = MakeTimedOutTestResults(
+                method,
+                "Still running after " + to_string(elapsedNanos / 1000000) + " ms, exceeding its " + 
+                    to_string(ResolveTimeoutMillis(method, options)) + " ms timeout. The run was aborted."
+            );
+            timedOut.executionTimeNanos = elapsedNanos;
+            timedOut.executionTimeMillis = elapsedNanos / 1000000;
+            progress.AbortRun(testIndex, move(timedOut));
+        });
+    }
+
+    void Canary::ExecuteInSharedProcess(const vector<size_t>& selection, const vector<size_t>& taskOrder, size_t nWorkers, const RunOptions& options, RunProgress& progress) const
+    {
+        unique_ptr<Watchdog> watchdog = StartWatchdog(selection, 1, options, progress);
+
+        TestListener* const testEventSink = progress.TestEventSink();
+        auto runTest = [this, &selection, &progress, &options, &watchdog, testEventSink](size_t taskIndex)
+        {
+            if(progress.IsCancelled()) return;
+
+            const TestMethod& method = testMethodList[selection[taskIndex]];
+            const int64_t timeoutMillis = watchdog? ResolveTimeoutMillis(method, options) : 0;
+            if(timeoutMillis > 0) watchdog->Start(taskIndex, timeoutMillis);
+
+            TestResults result;
+            {
+                const DeadlineScope deadline{timeoutMillis > 0? watchdog.get() : nullptr, taskIndex};
+                result = ExecuteTestMethod(method, testEventSink, options.detailVerbosity, progress.CancellationFlag(), options.countHardwareEvents, options.logs);
+            }
+            progress.TestFinished(taskIndex, move(result));
+        };
+
+        if(nWorkers <= 1)
+        {
+            for(size_t i = 0; i < selection.size() && !progress.IsCancelled(); i++) runTest(i);
+        }
+        else
+        {
+            //Every test writes only to its own pre-allocated slot, so workers never share a TestResults 
+            //and the pre-sort order matches a sequential run regardless of which worker ran each test
+            WorkStealingPool pool(nWorkers);
+            pool.Run(taskOrder, runTest);
+        }
     }
 
-    void Tester::assert(bool expressionPassed, const string& description)
+    TestResults Canary::ExecuteRepeatedTestMethod(const TestMethod& testMethod, const RunOptions& options)
     {
-        AddAssertResult(AssertType::plain_assert, expressionPassed, description, "");
-    }    
+        RepeatedRun repeatedRun(testMethod.groupName, testMethod.name, options.repeat, 1, nullptr);
+        size_t iteration = 0;
+        while(repeatedRun.NextIteration(iteration))
+        {
+            repeatedRun.AddIteration(iteration, ExecuteTestMethod(testMethod, nullptr, options.detailVerbosity, nullptr, options.countHardwareEvents, options.logs));
+        }
+        return repeatedRun.TakeResults();
+    }
 
-    void Tester::TestForThrow(const bool throwExpected, std::function<void(void)>& expr, const string& description)
+    void Canary::ExecuteRepeatedInSharedProcess(const vector<size_t>& selection, const vector<size_t>& taskOrder, const RunOptions& options, RunProgress& progress) const
     {
-        bool exceptionThrown = false;
-        string stdExceptionMsg;
-        try
+        //Each test is split into lanes, one per worker, which take turns claiming its iterations
+        const size_t nWorkers = ResolveWorkerCount(options.jobs);
+        const size_t nLanes = options.repeat.count == 0? nWorkers : max<size_t>(min(options.repeat.count, nWorkers), 1);
+
+        vector<unique_ptr<RepeatedRun>> repeatedRuns;
+        repeatedRuns.reserve(selection.size());
+        for(const size_t methodIndex: selection)
         {
-            expr();
+            const TestMethod& method = testMethodList[methodIndex];
+            repeatedRuns.emplace_back(make_unique<RepeatedRun>(method.groupName, method.name, options.repeat, nLanes, progress.CancellationFlag()));
         }
-        catch(const exception& stdException)
+
+        //Consecutive lanes of a test are dealt to different workers
+        vector<size_t> laneOrder;
+        laneOrder.reserve(taskOrder.size() * nLanes);
+        for(const size_t taskIndex: taskOrder)
         {
-            exceptionThrown = true;
-            stdExceptionMsg = "exception message: " + string(stdException.what());
+            for(size_t lane = 0; lane < nLanes; lane++) laneOrder.push_back(taskIndex * nLanes + lane);
         }
-        catch(...)
+
+        unique_ptr<Watchdog> watchdog = StartWatchdog(selection, nLanes, options, progress);
+
+        auto runLane = [this, &selection, &options, &progress, &watchdog, &repeatedRuns, nLanes](size_t laneIndex)
         {
-            exceptionThrown = true;
-            stdExceptionMsg = "No message logged - exception does not inherit from std::exception";
-        }
+            const size_t taskIndex = laneIndex / nLanes;
+            const TestMethod& method = testMethodList[selection[taskIndex]];
+            RepeatedRun& repeatedRun = *repeatedRuns[taskIndex];
+            const int64_t timeoutMillis = watchdog? ResolveTimeoutMillis(method, options) : 0;
 
-        const bool throwCriteriaMet = exceptionThrown == throwExpected;
+            size_t iteration = 0;
+            while(repeatedRun.NextIteration(iteration))
+            {
+                if(timeoutMillis > 0) watchdog->Start(laneIndex, timeoutMillis);
 
-        AddAssertResult(
-            throwExpected? AssertType::assert_throws : AssertType::assert_nothrow,
-            throwCriteriaMet, 
-            description,
-            stdExceptionMsg
-        );
-    }
+                TestResults result;
+                {
+                    const DeadlineScope deadline{timeoutMillis > 0? watchdog.get() : nullptr, laneIndex};
+                    result = ExecuteTestMethod(method, nullptr, options.detailVerbosity, progress.CancellationFlag(), options.countHardwareEvents, options.logs);
+                }
+                repeatedRun.AddIteration(iteration, move(result));
+            }
 
-    void Tester::assert_throw(std::function<void(void)> expr, const string& description)
-    {
-        TestForThrow(true, expr, description);
-    }
+            //Listeners only see the combined result, as if the test had run once
+            if(repeatedRun.LaneFinished()) progress.ReplayFinishedTest(taskIndex, repeatedRun.TakeResults());
+        };
 
-    void Tester::assert_nothrow(std::function<void(void)> expr, const string& description)
-    {
-        TestForThrow(false, expr, description);
+        const size_t nPoolWorkers = min(nWorkers, laneOrder.size());
+        if(nPoolWorkers <= 1)
+        {
+            for(const size_t laneIndex: laneOrder) runLane(laneIndex);
+        }
+        else
+        {
+            WorkStealingPool pool(nPoolWorkers);
+            pool.Run(laneOrder, runLane);
+        }
     }
 
-    void Tester::log(const string& message)
+    vector<size_t> Canary::ApplyHistoryOrder(const vector<size_t>& selection, const TestHistory& history, HistoryOrder order) const
     {
-        boundResults.logs.emplace_back(message);
-    }
-#pragma endregion
+        if(order == HistoryOrder::asRegistered) return selection;
 
-#pragma region Canary
-    Canary& Canary::Instance()
-    {
-        static Canary singleton;
-        return singleton;
-    }
+        vector<size_t> ordered = selection;
+        auto failedLastRun = [this, &history](size_t methodIndex)
+        {
+            const TestMethod& method = testMethodList[methodIndex];
+            return history.FailedLastRun(method.groupName, method.name);
+        };
 
-    void Canary::AddTestMethod(const string& methodName, const string& groupName, TTestMethod testMethod)
-    {
-        testMethodList.emplace_back(
-            TestMethod{
-                methodName,
-                groupName,
-                testMethod
-            }
-        );
+        if(order == HistoryOrder::previouslyFailedOnly)
+        {
+            ordered.erase(
+                remove_if(ordered.begin(), ordered.end(), [&failedLastRun](size_t methodIndex) { return !failedLastRun(methodIndex); }),
+                ordered.end()
+            );
+        }
+        else
+        {
+            stable_partition(ordered.begin(), ordered.end(), failedLastRun);
+        }
+        return ordered;
     }
 
-    vector<TestResults> SortFailedTestFirst_ThenByGroup_ThenByAlphabeticalOrder(const vector<TestResults>& results)
+    vector<size_t> Canary::ScheduleLongestFirst(const vector<size_t>& selection, const TestHistory& history, HistoryOrder order) const
     {
-        using TNoFailures = bool;
-        using TCachedFailureCount = pair<TNoFailures, const TestResults*>;
-        vector<TCachedFailureCount> resultsToSort;
-        //Cache whether each result set has failed test cases to avoid having the assertionResults vector
-        //be scanned every comparison during the sort
-        for(const TestResults& result: results)
+        vector<size_t> taskOrder(selection.size());
+        for(size_t i = 0; i < taskOrder.size(); i++) taskOrder[i] = i;
+
+        vector<double> expectedNanos(selection.size());
+        vector<bool> runFirst(selection.size());
+        for(size_t i = 0; i < selection.size(); i++)
         {
-            size_t _discard = 0UL;
-            size_t failedCases = 0UL;
-            tie(_discard, failedCases) = result.GetNumberOfPassedAndFailedCases();
-            
-            const bool hasNoFailedTestCases = failedCases == 0;
-            resultsToSort.emplace_back(
-                make_pair(hasNoFailedTestCases,&result)
-            );
+            const TestMethod& method = testMethodList[selection[i]];
+            expectedNanos[i] = history.ExpectedNanos(method.groupName, method.name);
+            runFirst[i] = order == HistoryOrder::previouslyFailedFirst && history.FailedLastRun(method.groupName, method.name);
         }
 
-        sort(
-            resultsToSort.begin(),
-            resultsToSort.end(),
-            [](const TCachedFailureCount& t1, TCachedFailureCount& t2)
+        //Previously failed tests still lead the run, each partition is then ordered by duration
+        stable_sort(
+            taskOrder.begin(),
+            taskOrder.end(),
+            [&expectedNanos, &runFirst](size_t lhs, size_t rhs)
             {
-                return 
-                    tie(t1.first, t1.second->groupName, t1.second->methodName) <
-                    tie(t2.first, t2.second->groupName, t2.second->methodName);
+                if(runFirst[lhs] != runFirst[rhs]) return static_cast<bool>(runFirst[lhs]);
+                return expectedNanos[lhs] > expectedNanos[rhs];
             }
         );
+        return taskOrder;
+    }
 
-        vector<TestResults> sortedWithFailuresFirstThenLexologically;
-        for(TCachedFailureCount& sorted: resultsToSort)
+    vector<TestResults> Canary::ExecuteTestMethods(const vector<size_t>& requestedSelection, const RunOptions& options) const
+    {
+        if(options.repeat.count == 0 && options.repeat.budgetMillis <= 0)
         {
-            sortedWithFailuresFirstThenLexologically.emplace_back(*sorted.second);
+            throw invalid_argument("repeat.count of 0 requires a repeat.budgetMillis");
         }
 
-        return sortedWithFailuresFirstThenLexologically;
-    }
+        const bool useHistory = !options.historyFile.empty();
+        TestHistory history = useHistory? TestHistory::Load(options.historyFile) : TestHistory{};
+        const vector<size_t> selection = ApplyHistoryOrder(requestedSelection, history, options.historyOrder);
 
-    vector<TestResults> Canary::ExecuteTestMethods(vector<TestMethod>& methodList)
-    {
-        vector<TestResults> results;
+        const size_t nWorkers = min(ResolveWorkerCount(options.jobs), selection.size());
 
-        transform(
-            methodList.begin(), methodList.end(),
-            back_inserter(results),
-            [](TestMethod& testMethod)
-            {
-                TestResults testResultSet;
-                Tester tester(testResultSet);
+        const bool useBaselines = !options.baseline.file.empty();
+        PerformanceBaselines baselines = useBaselines? PerformanceBaselines::Load(options.baseline.file) : PerformanceBaselines{};
 
-                const auto startTime = chrono::steady_clock::now();
-                testMethod.method(tester);
-                const auto endTime = chrono::steady_clock::now();
+        RunProgress progress(options, selection.size(), useHistory? &history : nullptr, useBaselines? &baselines : nullptr);
+        progress.OnRunStart(selection.size());
 
-                const int64_t elapsedMillis = 
-                    chrono::duration_cast<chrono::milliseconds>(endTime - startTime).count();
+        //Results stay indexed by selection, only the order in which the tests are handed out changes
+        vector<size_t> taskOrder;
+        if(useHistory && nWorkers > 1)
+        {
+            taskOrder = ScheduleLongestFirst(selection, history, options.historyOrder);
+        }
+        else
+        {
+            taskOrder.resize(selection.size());
+            for(size_t i = 0; i < taskOrder.size(); i++) taskOrder[i] = i;
+        }
 
-                testResultSet.groupName = testMethod.groupName;
-                testResultSet.methodName = testMethod.name;
-                testResultSet.executionTimeMillis = elapsedMillis;
-                return testResultSet;
-            }
-        );
+        if(options.isolation == ExecutionIsolation::forkedProcesses)
+        {
+            ExecuteInForkedProcesses(selection, taskOrder, nWorkers, options, progress);
+        }
+        else if(options.repeat.IsRepeating())
+        {
+            ExecuteRepeatedInSharedProcess(selection, taskOrder, options, progress);
+        }
+        else
+        {
+            ExecuteInSharedProcess(selection, taskOrder, nWorkers, options, progress);
+        }
 
-        return SortFailedTestFirst_ThenByGroup_ThenByAlphabeticalOrder(results);
+        progress.RunFinished();
+        if(useHistory) history.Save(options.historyFile);
+        if(baselines.IsModified()) baselines.Save(options.baseline.file);
+        return progress.TakeSortedResults();
     }
 
-    vector<TestResults> Canary::RunAllTests()
+    vector<TestResults> Canary::RunAllTests(const RunOptions& options)
     {
-       return ExecuteTestMethods(testMethodList);
+        return RunQuery(TestQuery{}, options);
     }
 
-    vector<TestResults> Canary::RunTestGroup(const string& name)
+    vector<TestResults> Canary::RunTestGroup(const string& name, const RunOptions& options)
     {
-        vector<TestMethod> filteredMethods;
-        copy_if(
-            testMethodList.begin(), testMethodList.end(),
-            back_inserter(filteredMethods),
-            [&name](const TestMethod& results)
-            {
-                return results.groupName == name;
-            }
-        );
+        TestQuery query;
+        query.groups.push_back(name);
+        return RunQuery(query, options);
+    }
+
+    vector<TestResults> Canary::RunQuery(const TestQuery& query, const RunOptions& options)
+    {
+        return ExecuteTestMethods(SelectTests(query), options);
+    }
+
+    vector<TestResults> Canary::RunShard(size_t shardIndex, size_t shardCount, const RunOptions& options)
+    {
+        if(shardCount == 0) throw invalid_argument("shard count must be at least 1");
+        if(shardIndex >= shardCount) throw invalid_argument("shard index must be less than the shard count");
+
+        vector<size_t> shardMethods;
+        for(size_t i = 0; i < testMethodList.size(); i++)
+        {
+            const TestMethod& method = testMethodList[i];
+            if(GetTestShard(method.groupName, method.name, shardCount) == shardIndex) shardMethods.push_back(i);
+        }
 
-        return ExecuteTestMethods(filteredMethods);
+        return ExecuteTestMethods(shardMethods, options);
     }
 
 #pragma endregion
@@ -202,42 +1269,147 @@ namespace CTest
 
         return make_pair(nPassingTests, nFailingTests);
     }
+
+    double RepeatStatistics::PassRate() const
+    {
+        if(nIterations == 0) return 0.0;
+        return static_cast<double>(nIterations - nFailedIterations) / static_cast<double>(nIterations);
+    }
+
+    double HardwareCounterStatistics::InstructionsPerCycle() const
+    {
+        if(cycles <= 0 || instructions < 0) return 0.0;
+        return static_cast<double>(instructions) / static_cast<double>(cycles);
+    }
 #pragma endregion
 
-#pragma region MethodRegistrar
-    MethodRegistrar::MethodRegistrar(string methodName, string groupName, TTestMethod method)
+#pragma region SampleStatistics
+    SampleStatistics ComputeSampleStatistics(vector<double> samples)
     {
-        Canary::Instance().AddTestMethod(methodName, groupName, method);
+        SampleStatistics statistics;
+        statistics.nSamples = samples.size();
+        if(samples.empty()) return statistics;
+
+        sort(samples.begin(), samples.end());
+        const size_t n = samples.size();
+
+        statistics.min = samples.front();
+        statistics.median = (n % 2 == 1)?
+            samples[n / 2] :
+            (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+
+        //Nearest-rank percentile
+        const size_t p99Rank = static_cast<size_t>(ceil(0.99 * static_cast<double>(n)));
+        statistics.p99 = samples[max<size_t>(p99Rank, 1) - 1];
+
+        double sum = 0.0;
+        for(const double sample: samples) sum += sample;
+        statistics.mean = sum / static_cast<double>(n);
+
+        if(n > 1)
+        {
+            double squaredDeviations = 0.0;
+            for(const double sample: samples) 
+            {
+                squaredDeviations += (sample - statistics.mean) * (sample - statistics.mean);
+            }
+            statistics.stddev = sqrt(squaredDeviations / static_cast<double>(n - 1));
+        }
+
+        return statistics;
     }
 #pragma endregion
 
-#pragma region FreeStandingFunctions
-    struct OverallTestResults
+#pragma region OverallTestResults
+    void OverallTestResults::Accumulate(const TestResults& result)
     {
-        size_t nTotalPassedTests = 0;
-        size_t nTotalFailedTests = 0;
-        int64_t totalTestTimeMillis = 0;
-        size_t nTotalTests = 0;
-    };
+        size_t nPassed = 0;
+        size_t nFailed = 0;
+        tie(nPassed, nFailed) = result.GetNumberOfPassedAndFailedCases();
+        Accumulate(result, nPassed, nFailed);
+    }
 
-    OverallTestResults GetOverallTestResults(const vector<TestResults>& results)
+    void OverallTestResults::Accumulate(const TestResults& result, size_t nPassed, size_t nFailed)
     {
-        OverallTestResults overallResults{};
+        nTotalPassedTests += nPassed;
+        nTotalFailedTests += nFailed;
+        totalTestTimeMillis += result.executionTimeMillis;
+        totalTestTimeNanos += result.executionTimeNanos;
+        totalThreadCpuTimeNanos += result.threadCpuTimeNanos;
+        nTotalTests = nTotalPassedTests + nTotalFailedTests;
+    }
+#pragma endregion
 
+#pragma region TestResultsView
+    TestResultsView::TestResultsView(const vector<TestResults>& results, ResultOrder order)
+    {
+        entries.reserve(results.size());
         for(const TestResults& result: results)
         {
-            size_t nPassed = 0;
-            size_t nFailed = 0;
-            tie(nPassed, nFailed) = result.GetNumberOfPassedAndFailedCases();
-            overallResults.nTotalPassedTests += nPassed;
-            overallResults.nTotalFailedTests += nFailed;
-            overallResults.totalTestTimeMillis += result.executionTimeMillis;
+            TestResultsEntry entry{&result, 0, 0};
+            tie(entry.nPassed, entry.nFailed) = result.GetNumberOfPassedAndFailedCases();
+            overallResults.Accumulate(result, entry.nPassed, entry.nFailed);
+            entries.push_back(entry);
         }
-        overallResults.nTotalTests = 
-            overallResults.nTotalPassedTests +
-            overallResults.nTotalFailedTests;
-        
-        return overallResults;
+
+        if(order == ResultOrder::failedTestsFirst)
+        {
+            sort(
+                entries.begin(),
+                entries.end(),
+                [](const TestResultsEntry& e1, const TestResultsEntry& e2)
+                {
+                    const bool e1NoFailures = e1.nFailed == 0;
+                    const bool e2NoFailures = e2.nFailed == 0;
+                    return 
+                        tie(e1NoFailures, e1.results->groupName, e1.results->methodName) <
+                        tie(e2NoFailures, e2.results->groupName, e2.results->methodName);
+                }
+            );
+        }
+    }
+#pragma endregion
+
+#pragma region MethodRegistrar
+    MethodRegistrar::MethodRegistrar(string methodName, string groupName, TTestMethod method, vector<string> tags, int64_t timeoutMillis)
+    {
+        Canary::Instance().AddTestMethod(methodName, groupName, move(method), move(tags), timeoutMillis);
+    }
+#pragma endregion
+
+#pragma region FreeStandingFunctions
+    size_t GetTestShard(const string& groupName, const string& methodName, size_t shardCount)
+    {
+        if(shardCount == 0) throw invalid_argument("shard count must be at least 1");
+
+        //FNV-1a rather than std::hash, whose output may differ between standard library implementations
+        uint64_t hash = 14695981039346656037ULL;
+        auto hashBytes = [&hash](const string& bytes)
+        {
+            for(const char c: bytes)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ULL;
+            }
+        };
+
+        hashBytes(groupName);
+        hashBytes(string(1, '\0')); //Keeps {"ab", "c"} & {"a", "bc"} apart
+        hashBytes(methodName);
+
+        return static_cast<size_t>(hash % shardCount);
+    }
+
+    vector<TestResults> MergeTestResults(vector<vector<TestResults>> resultSets)
+    {
+        vector<TestResults> merged;
+        for(vector<TestResults>& resultSet: resultSets)
+        {
+            move(resultSet.begin(), resultSet.end(), back_inserter(merged));
+        }
+
+        SortFailedTestFirst_ThenByGroup_ThenByAlphabeticalOrder(merged);
+        return merged;
     }
 
     std::string GetAssertTypeName(const AssertType enType)
@@ -249,6 +1421,12 @@ namespace CTest
             case AssertType::assert_notequals:  return "neq";
             case AssertType::assert_throws:     return "throw";
             case AssertType::assert_nothrow:    return "nothrow";
+            case AssertType::process_terminated: return "crash";
+            case AssertType::check:             return "check";
+            case AssertType::timeout:           return "timeout";
+            case AssertType::allocation_budget: return "alloc";
+            case AssertType::performance_regression: return "regression";
+            case AssertType::time_budget:       return "time";
             default: return "[unknown]";
         }
     }
@@ -267,61 +1445,207 @@ namespace CTest
         return padded;
     }
 
-    string JsonifyTestResults(const vector<TestResults>& results)
+    //Fills the (empty) object 'target' with the results of a single test
+    void BuildJsonTestResult(JsonDocument& document, JsonDocument::NodeId target, const TestResultsEntry& entry)
     {
-        const OverallTestResults overallResults = GetOverallTestResults(results);
-        const bool allTestsPassed = overallResults.nTotalFailedTests == 0;
-        auto reportBody = make_unique<JsonObject>();
-        
-        reportBody->AddBool("all-tests-passed", allTestsPassed);
-        reportBody->AddInteger("passing-tests", overallResults.nTotalPassedTests);
-        reportBody->AddInteger("failing-tests", overallResults.nTotalFailedTests);
-        reportBody->AddInteger("total-test-time-millis", overallResults.totalTestTimeMillis);
+        const TestResults& result = *entry.results;
+        const size_t nPassed = entry.nPassed;
+        const size_t nFailed = entry.nFailed;
 
-        auto testResults = make_unique<JsonArray>();
-        for(const TestResults& result: results)
+        document.AddString(target, "name", result.methodName);
+        document.AddString(target, "group", result.groupName);
+        document.AddBool(target, "all-passed", nFailed == 0);
+        document.AddInteger(target, "passing-tests", nPassed);
+        document.AddInteger(target, "failing-tests", nFailed);
+        document.AddInteger(target, "test-time-millis", result.executionTimeMillis);
+        document.AddInteger(target, "test-time-nanos", result.executionTimeNanos);
+        document.AddInteger(target, "thread-cpu-time-nanos", result.threadCpuTimeNanos);
+        document.AddInteger(target, "process-cpu-time-nanos", result.processCpuTimeNanos);
+
+        if(result.isBenchmark)
         {
-            size_t nPassed = 0;
-            size_t nFailed = 0;
-            tie(nPassed, nFailed) = result.GetNumberOfPassedAndFailedCases();
+            const SampleStatistics& nanosPerIteration = result.benchmark.nanosPerIteration;
+            const JsonDocument::NodeId benchmarkNode = document.AddObject(target, "benchmark");
+            document.AddInteger(benchmarkNode, "iterations-per-sample", static_cast<int64_t>(result.benchmark.iterationsPerSample));
+            document.AddInteger(benchmarkNode, "samples", nanosPerIteration.nSamples);
+            document.AddDouble(benchmarkNode, "min-nanos", nanosPerIteration.min);
+            document.AddDouble(benchmarkNode, "median-nanos", nanosPerIteration.median);
+            document.AddDouble(benchmarkNode, "mean-nanos", nanosPerIteration.mean);
+            document.AddDouble(benchmarkNode, "p99-nanos", nanosPerIteration.p99);
+            document.AddDouble(benchmarkNode, "stddev-nanos", nanosPerIteration.stddev);
+        }
 
-            auto currentResult = make_unique<JsonObject>();
-            currentResult->AddString("name", result.methodName);
-            currentResult->AddString("group", result.groupName);
-            currentResult->AddBool("all-passed", nFailed == 0);
-            currentResult->AddInteger("passing-tests", nPassed);
-            currentResult->AddInteger("failing-tests", nFailed);
-            currentResult->AddInteger("test-time-millis", result.executionTimeMillis);
+        if(result.hasAllocationStatistics)
+        {
+            const AllocationStatistics& allocations = result.allocations;
+            const JsonDocument::NodeId allocationNode = document.AddObject(target, "allocations");
+            document.AddInteger(allocationNode, "count", static_cast<int64_t>(allocations.nAllocations));
+            document.AddInteger(allocationNode, "bytes", static_cast<int64_t>(allocations.allocatedBytes));
+            document.AddInteger(allocationNode, "peak-live-bytes", allocations.peakLiveBytes);
+            document.AddInteger(allocationNode, "leaked-bytes", allocations.leakedBytes);
+        }
 
-            {
-                auto assertList = make_unique<JsonArray>();
-                for(const AssertResult& assertResult: result.assertionResults)
-                {
-                    auto assertNode = make_unique<JsonObject>();
-                    assertNode->AddString("type", GetAssertTypeName(assertResult.assertType));
-                    assertNode->AddBool("passed", assertResult.passed);
-                    assertNode->AddString("description", assertResult.description);
-                    assertNode->AddString("details", assertResult.additionalDetails);
+        if(result.hasHardwareCounters)
+        {
+            const HardwareCounterStatistics& counters = result.hardwareCounters;
+            const JsonDocument::NodeId counterNode = document.AddObject(target, "hardware-counters");
 
-                    assertList->AddElement(move(assertNode));
-                }
-                currentResult->AddNode("assertions", move(assertList));
+            //Events this machine could not count are left out rather than reported as 0
+            auto addCount = [&document, counterNode](const char* name, int64_t count)
+            {
+                if(count >= 0) document.AddInteger(counterNode, name, count);
+            };
+            addCount("cycles", counters.cycles);
+            addCount("instructions", counters.instructions);
+            addCount("branch-misses", counters.branchMisses);
+            addCount("l1d-read-misses", counters.l1dReadMisses);
+            addCount("llc-read-misses", counters.llcReadMisses);
+            if(counters.cycles > 0 && counters.instructions >= 0)
+            {
+                document.AddDouble(counterNode, "instructions-per-cycle", counters.InstructionsPerCycle());
             }
+        }
+
+        if(result.isRepeated)
+        {
+            const RepeatStatistics& repeat = result.repeat;
+            const JsonDocument::NodeId repeatNode = document.AddObject(target, "repeat");
+            document.AddInteger(repeatNode, "iterations", repeat.nIterations);
+            document.AddInteger(repeatNode, "failed-iterations", repeat.nFailedIterations);
+            document.AddDouble(repeatNode, "pass-rate", repeat.PassRate());
+            if(repeat.nFailedIterations > 0)
             {
-                auto logList = make_unique<JsonArray>();
-                for(const string& log: result.logs)
-                {
-                    logList->AddElement(make_unique<JsonString>(log));
-                }
-                currentResult->AddNode("logs", move(logList));
+                //The test's assertions are the ones from this iteration
+                document.AddInteger(repeatNode, "first-failed-iteration", repeat.firstFailedIteration);
             }
+            document.AddDouble(repeatNode, "min-nanos", repeat.wallNanos.min);
+            document.AddDouble(repeatNode, "median-nanos", repeat.wallNanos.median);
+            document.AddDouble(repeatNode, "mean-nanos", repeat.wallNanos.mean);
+            document.AddDouble(repeatNode, "p99-nanos", repeat.wallNanos.p99);
+            document.AddDouble(repeatNode, "stddev-nanos", repeat.wallNanos.stddev);
+        }
+
+        const JsonDocument::NodeId assertList = document.AddArray(target, "assertions");
+        for(const AssertResult& assertResult: result.assertionResults)
+        {
+            const JsonDocument::NodeId assertNode = document.AppendObject(assertList);
+            document.AddString(assertNode, "type", GetAssertTypeName(assertResult.assertType));
+            document.AddBool(assertNode, "passed", assertResult.passed);
+            document.AddString(assertNode, "description", assertResult.description);
+            document.AddString(assertNode, "details", assertResult.additionalDetails);
+        }
+
+        const JsonDocument::NodeId logList = document.AddArray(target, "logs");
+        for(const string& log: result.logs)
+        {
+            document.AppendString(logList, log);
+        }
+        if(result.nDroppedLogs > 0)
+        {
+            document.AddInteger(target, "dropped-logs", static_cast<int64_t>(result.nDroppedLogs));
+        }
+    }
+
+    void BuildJsonReport(JsonDocument& document, const TestResultsView& results)
+    {
+        const OverallTestResults& overallResults = results.GetOverallResults();
+        const bool allTestsPassed = overallResults.nTotalFailedTests == 0;
+        const JsonDocument::NodeId reportBody = document.GetRoot();
+
+        //Rough upper bound so the node buffer is only allocated once for typical reports
+        size_t nNodes = 8;
+        for(const TestResultsEntry& entry: results.GetEntries())
+        {
+            nNodes += 24 + 5 * entry.results->assertionResults.size() + entry.results->logs.size();
+        }
+        document.Reserve(nNodes, 0);
+        
+        document.AddBool(reportBody, "all-tests-passed", allTestsPassed);
+        document.AddInteger(reportBody, "passing-tests", overallResults.nTotalPassedTests);
+        document.AddInteger(reportBody, "failing-tests", overallResults.nTotalFailedTests);
+        document.AddInteger(reportBody, "total-test-time-millis", overallResults.totalTestTimeMillis);
+        document.AddInteger(reportBody, "total-test-time-nanos", overallResults.totalTestTimeNanos);
+        document.AddInteger(reportBody, "total-thread-cpu-time-nanos", overallResults.totalThreadCpuTimeNanos);
 
-            testResults->AddElement(move(currentResult));
+        const JsonDocument::NodeId testResults = document.AddArray(reportBody, "test-results");
+        for(const TestResultsEntry& entry: results.GetEntries())
+        {
+            BuildJsonTestResult(document, document.AppendObject(testResults), entry);
         }
+    }
+
+    string JsonifyTestResults(const vector<TestResults>& results)
+    {
+        return JsonifyTestResults(results, JsonStyle::Pretty);
+    }
+
+    string JsonifyTestResults(const vector<TestResults>& results, JsonStyle style)
+    {
+        return JsonifyTestResults(TestResultsView(results), style);
+    }
+
+    string JsonifyTestResults(const TestResultsView& results, JsonStyle style)
+    {
+        JsonDocument document;
+        BuildJsonReport(document, results);
+
+        string report;
+        SerializeJson(document, report, style);
+        return report;
+    }
+
+    void WriteJsonReport(const vector<TestResults>& results, ostream& output, JsonStyle style)
+    {
+        WriteJsonReport(TestResultsView(results), output, style);
+    }
+
+    void WriteJsonReport(const TestResultsView& results, ostream& output, JsonStyle style)
+    {
+        JsonDocument document;
+        BuildJsonReport(document, results);
+        SerializeJson(document, output, style);
+    }
+
+    JsonLinesReporter::JsonLinesReporter(ostream& _output)
+    : output{_output}
+    {}
 
-        reportBody->AddNode("test-results", move(testResults));
+    void JsonLinesReporter::OnTestEnd(const TestResults& results)
+    {
+        TestResultsEntry entry{&results, 0, 0};
+        tie(entry.nPassed, entry.nFailed) = results.GetNumberOfPassedAndFailedCases();
+
+        JsonDocument document;
+        BuildJsonTestResult(document, document.GetRoot(), entry);
+
+        buffer.clear();
+        SerializeJson(document, buffer, JsonStyle::Compact);
+        buffer.push_back('\n');
+
+        output.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        output.flush();
+    }
+
+    string FormatNanos(double nanos)
+    {
+        char formatted[32];
+        snprintf(formatted, sizeof(formatted), "%.2f", nanos);
+        return formatted;
+    }
 
-        return reportBody->serialize();
+    //Picks the largest unit that keeps at least 1 whole unit, i.e. 1.25ms instead of 1250000ns
+    string FormatDuration(int64_t nanos)
+    {
+        const char* unit = "ns";
+        double value = static_cast<double>(nanos);
+        if(llabs(nanos) >= 1000000000) { value /= 1e9; unit = "s"; }
+        else if(llabs(nanos) >= 1000000) { value /= 1e6; unit = "ms"; }
+        else if(llabs(nanos) >= 1000) { value /= 1e3; unit = "us"; }
+        else return to_string(nanos) + unit;
+
+        char formatted[32];
+        snprintf(formatted, sizeof(formatted), "%.2f%s", value, unit);
+        return formatted;
     }
 
     bool ShouldPrintAdditionalDetails(
@@ -350,7 +1674,12 @@ namespace CTest
 
     string FormatAsText(const vector<TestResults>& results, enum TextLogVerbosity verbosity)
     {
-        const OverallTestResults overallResults = GetOverallTestResults(results);
+        return FormatAsText(TestResultsView(results), verbosity);
+    }
+
+    string FormatAsText(const TestResultsView& results, enum TextLogVerbosity verbosity)
+    {
+        const OverallTestResults& overallResults = results.GetOverallResults();
         const bool allCasesPassed = overallResults.nTotalFailedTests == 0;
 
         const string overallResultCaption = 
@@ -358,44 +1687,94 @@ namespace CTest
                 "All tests passed" :
                 "Failing tests detected";
 
-        string header = cfmt("%t|%t/%t tests passed|Time taken:%tms",
+        //Every line is appended straight into one buffer
+        string report;
+        cfmt_to(report, CFMT("%t|%t/%t tests passed|Time taken:%tms (wall %t, thread cpu %t)\nTest results:"),
                 overallResultCaption,
                 overallResults.nTotalPassedTests,
                 overallResults.nTotalTests,
-                overallResults.totalTestTimeMillis
+                overallResults.totalTestTimeMillis,
+                FormatDuration(overallResults.totalTestTimeNanos),
+                FormatDuration(overallResults.totalThreadCpuTimeNanos)
             );
-        
-        vector<string> report;
-        report.emplace_back(move(header));
-        report.emplace_back("Test results:");
 
-        for(const TestResults& testResult: results)
+        for(const TestResultsEntry& entry: results.GetEntries())
         {
-            size_t nPassing = 0;
-            size_t nFailing = 0;
-            tie(nPassing, nFailing) = testResult.GetNumberOfPassedAndFailedCases();
+            const TestResults& testResult = *entry.results;
+            const size_t nPassing = entry.nPassed;
+            const size_t nFailing = entry.nFailed;
 
-            const string groupDisplay = 
-                !testResult.groupName.empty()? cfmt(", group:%t", testResult.groupName):
-                "";
-
-            string testMethodOverview = cfmt("   Test Method:%t, passed %t/%t, all-passed?:%t, running time:%tms%t", 
+            cfmt_to(report, CFMT("\n   Test Method:%t, passed %t/%t, all-passed?:%t, running time:%tms (wall %t, thread cpu %t, process cpu %t)"),
                 testResult.methodName,
                 nPassing, nPassing + nFailing,
                 (nFailing == 0)? "True": "False",
                 testResult.executionTimeMillis,
-                groupDisplay
+                FormatDuration(testResult.executionTimeNanos),
+                FormatDuration(testResult.threadCpuTimeNanos),
+                FormatDuration(testResult.processCpuTimeNanos)
             );
+            if(!testResult.groupName.empty())
+            {
+                cfmt_to(report, CFMT(", group:%t"), testResult.groupName);
+            }
 
-            report.emplace_back(move(testMethodOverview));
+            if(testResult.isBenchmark)
+            {
+                const SampleStatistics& nanosPerIteration = testResult.benchmark.nanosPerIteration;
+                cfmt_to(report, CFMT("\n      Benchmark: min %tns, median %tns, mean %tns, p99 %tns, stddev %tns (%t samples x %t iterations)"),
+                    FormatNanos(nanosPerIteration.min),
+                    FormatNanos(nanosPerIteration.median),
+                    FormatNanos(nanosPerIteration.mean),
+                    FormatNanos(nanosPerIteration.p99),
+                    FormatNanos(nanosPerIteration.stddev),
+                    nanosPerIteration.nSamples,
+                    testResult.benchmark.iterationsPerSample
+                );
+            }
+            if(testResult.hasAllocationStatistics)
+            {
+                const AllocationStatistics& allocations = testResult.allocations;
+                cfmt_to(report, CFMT("\n      Allocations: %t (%t bytes), peak live %t bytes, leaked %t bytes"),
+                    allocations.nAllocations,
+                    allocations.allocatedBytes,
+                    allocations.peakLiveBytes,
+                    allocations.leakedBytes
+                );
+            }
+            if(testResult.hasHardwareCounters)
+            {
+                const HardwareCounterStatistics& counters = testResult.hardwareCounters;
+                auto formatCount = [](int64_t count) { return count < 0? string("n/a") : to_string(count); };
+                cfmt_to(report, CFMT("\n      Hardware counters: %t cycles, %t instructions, %t branch misses, %t L1d / %t LLC read misses"),
+                    formatCount(counters.cycles),
+                    formatCount(counters.instructions),
+                    formatCount(counters.branchMisses),
+                    formatCount(counters.l1dReadMisses),
+                    formatCount(counters.llcReadMisses)
+                );
+            }
+            if(testResult.isRepeated)
+            {
+                const RepeatStatistics& repeat = testResult.repeat;
+                cfmt_to(report, CFMT("\n      Repeated: %t/%t iterations passed, wall min %tns, median %tns, p99 %tns"),
+                    repeat.nIterations - repeat.nFailedIterations,
+                    repeat.nIterations,
+                    FormatNanos(repeat.wallNanos.min),
+                    FormatNanos(repeat.wallNanos.median),
+                    FormatNanos(repeat.wallNanos.p99)
+                );
+                if(repeat.nFailedIterations > 0)
+                {
+                    cfmt_to(report, CFMT(", asserts below are from iteration %t (the first to fail)"), repeat.firstFailedIteration);
+                }
+            }
             for(const AssertResult& assertResult: testResult.assertionResults)
             {
-                string line = cfmt("      %t - %t, Description [ %t ]",
+                cfmt_to(report, CFMT("\n      %t - %t, Description [ %t ]"),
                     assertResult.passed? "Passed" : "Failed",
                     PadWithSpaces(GetAssertTypeName(assertResult.assertType), 6),
                     assertResult.description
                 );
-                report.emplace_back(move(line));
 
                 if(ShouldPrintAdditionalDetails(
                     assertResult.passed, 
@@ -404,17 +1783,14 @@ namespace CTest
 
                 
                 //Print out the logs (if any)
-                string additionalDetails = cfmt("         Details: %t", 
-                    assertResult.additionalDetails
-                );
-                report.emplace_back(move(additionalDetails));
+                cfmt_to(report, CFMT("\n         Details: %t"), assertResult.additionalDetails);
             }
         }
 
         //Indicate overall pass/failure at the bottom to allow it to be 
         //more easily read at the end of console output
-        report.emplace_back(cfmt("\n[---%t---]", overallResultCaption));
-        return StrJoin(report, "\n");
+        cfmt_to(report, CFMT("\n\n[---%t---]"), overallResultCaption);
+        return report;
     }
 #pragma endregion
 }
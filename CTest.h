@@ -1,9 +1,18 @@
 #pragma once
+#include <atomic>
 #include <functional>
 #include <vector>
 #include <string>
 #include <type_traits>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
 #include "StringConverter.h"
+#include "ExpressionDecomposer.h"
+#include "LogBuffer.h"
+#include "AllocationTracking.h"
+
+enum class JsonStyle; //JsonWriter.h
 
 namespace CTest
 {
@@ -15,7 +24,13 @@ namespace CTest
         assert_equals,
         assert_notequals,
         assert_throws,
-        assert_nothrow
+        assert_nothrow,
+        process_terminated,
+        check,
+        timeout,
+        allocation_budget,
+        performance_regression,
+        time_budget
     };
 
     enum class TextLogVerbosity
@@ -25,6 +40,21 @@ namespace CTest
         neverPrintAdditionalDetails
     };
 
+    enum class LogRetention
+    {
+        always,
+        failingTestsOnly    //Logs of passing tests are discarded without ever being formatted
+    };
+
+    struct LogOptions
+    {
+        //Most recent logs kept per test, older ones are dropped & counted in TestResults::nDroppedLogs.
+        //0 keeps every log.
+        size_t maxLogsPerTest = 1024;
+
+        LogRetention retention = LogRetention::always;
+    };
+
     struct AssertResult
     {
         AssertType assertType;
@@ -33,36 +63,240 @@ namespace CTest
         string additionalDetails; //Additional info like "expected" & "actual" value
     };
 
+    //Summary of a set of timing samples
+    struct SampleStatistics
+    {
+        size_t nSamples = 0;
+        double min = 0.0;
+        double median = 0.0;
+        double mean = 0.0;
+        double p99 = 0.0;
+        double stddev = 0.0;
+    };
+
+    SampleStatistics ComputeSampleStatistics(vector<double> samples);
+
+    struct BenchmarkStatistics
+    {
+        uint64_t iterationsPerSample = 0;
+        vector<double> nanosPerIterationSamples;   //One entry per timed sample
+        SampleStatistics nanosPerIteration;
+    };
+
+    //Heap usage of a test method, only recorded when built with CANARY_TRACK_ALLOCATIONS (see AllocationTracking.h).
+    //Allocations made by threads the test starts are not attributed to it.
+    struct AllocationStatistics
+    {
+        uint64_t nAllocations = 0;
+        uint64_t allocatedBytes = 0;
+        int64_t peakLiveBytes = 0;
+        int64_t leakedBytes = 0;    //Allocated during the test & not freed by the time it returned
+    };
+
+    //Hardware event counts of a test method's own thread, only recorded with RunOptions::countHardwareEvents (see PerfCounters.h).
+    //Each count is -1 when that event is not available on this machine.
+    struct HardwareCounterStatistics
+    {
+        int64_t cycles = -1;
+        int64_t instructions = -1;
+        int64_t branchMisses = -1;
+        int64_t l1dReadMisses = -1;
+        int64_t llcReadMisses = -1;
+
+        double InstructionsPerCycle() const;    //0 unless both counts are available
+    };
+
+    //Outcome of a test run several times over (see RunOptions::repeat)
+    struct RepeatStatistics
+    {
+        size_t nIterations = 0;
+        size_t nFailedIterations = 0;
+        size_t firstFailedIteration = 0;    //0-based, only meaningful when nFailedIterations > 0
+        vector<double> wallNanosSamples;    //One entry per iteration, in completion order
+        SampleStatistics wallNanos;
+
+        double PassRate() const;
+    };
+
     struct TestResults
     {
         string methodName;
         string groupName;
         vector<AssertResult> assertionResults;
         vector<string> logs;
+        size_t nDroppedLogs = 0;    //Earlier logs beyond LogOptions::maxLogsPerTest
         int64_t executionTimeMillis;
+        int64_t executionTimeNanos = 0;     //Wall-clock time
+        int64_t threadCpuTimeNanos = 0;     //CPU time of the thread running the test
+        int64_t processCpuTimeNanos = 0;    //CPU time of the whole process, includes other tests running in parallel
+
+        bool isBenchmark = false;
+        BenchmarkStatistics benchmark; //Only filled in when isBenchmark is set
+
+        //Repeated tests report the asserts & logs of their first failing iteration (or of the first iteration
+        //if every one passed), and the times summed over all iterations
+        bool isRepeated = false;
+        RepeatStatistics repeat; //Only filled in when isRepeated is set
+
+        bool hasAllocationStatistics = false;
+        AllocationStatistics allocations; //Only filled in when hasAllocationStatistics is set
+
+        bool hasHardwareCounters = false;
+        HardwareCounterStatistics hardwareCounters; //Only filled in when hasHardwareCounters is set
 
         using TPassedCases = size_t;
         using FailedCases = size_t;
         pair<TPassedCases, FailedCases> GetNumberOfPassedAndFailedCases() const;
     };
 
+    struct OverallTestResults
+    {
+        size_t nTotalPassedTests = 0;
+        size_t nTotalFailedTests = 0;
+        int64_t totalTestTimeMillis = 0;
+        int64_t totalTestTimeNanos = 0;
+        int64_t totalThreadCpuTimeNanos = 0;
+        size_t nTotalTests = 0;
+
+        void Accumulate(const TestResults& result);
+        void Accumulate(const TestResults& result, size_t nPassed, size_t nFailed);
+    };
+
+    //Pass/fail counts of a single test, worked out once so that sorting & reporting
+    //do not have to rescan its assertion results
+    struct TestResultsEntry
+    {
+        const TestResults* results;
+        size_t nPassed;
+        size_t nFailed;
+    };
+
+    enum class ResultOrder
+    {
+        asGiven,
+        failedTestsFirst    //Then by group & method name, the order RunAllTests() returns
+    };
+
+    //Non-owning view over a set of results, the viewed results must outlive the view.
+    //Build one view and pass it to several reports instead of copying or rescanning the results.
+    class TestResultsView
+    {
+        vector<TestResultsEntry> entries;
+        OverallTestResults overallResults;
+    public:
+        explicit TestResultsView(const vector<TestResults>& results, ResultOrder order = ResultOrder::asGiven);
+
+        const vector<TestResultsEntry>& GetEntries() const { return entries; }
+        const OverallTestResults& GetOverallResults() const { return overallResults; }
+    };
+
+    //Receives progress events while tests are running.
+    //Callbacks are serialized by the runner, so implementations need no locking of their own
+    //even when tests run on several threads. With forked process isolation, the start and assert
+    //events of a test are replayed in the parent once its results have been received.
+    class TestListener
+    {
+    public:
+        virtual void OnRunStart(size_t /*nTests*/) {}
+        virtual void OnTestStart(const string& /*groupName*/, const string& /*methodName*/) {}
+        virtual void OnAssert(const string& /*groupName*/, const string& /*methodName*/, const AssertResult& /*result*/) {}
+        virtual void OnTestEnd(const TestResults& /*results*/) {}
+        virtual void OnRunEnd(const OverallTestResults& /*overallResults*/) {}
+
+        virtual ~TestListener() = default;
+    };
+
+    //Writes one compact JSON object per completed test (JSON Lines), 
+    //flushing after every line so a killed run still leaves its completed results behind
+    class JsonLinesReporter : public TestListener
+    {
+        ostream& output;
+        string buffer;
+    public:
+        JsonLinesReporter(ostream& output);
+        void OnTestEnd(const TestResults& results) override;
+    };
+
+    //Thrown by the require_* asserts to stop the running test method, and caught by the runner.
+    //Deliberately not derived from std::exception; test code catching (...) must rethrow it.
+    struct AbortTestMethod
+    {};
+
     class Tester
     {
     private:
+        friend class BenchmarkRunner;
+        friend class Canary;
+
         TestResults& boundResults;
+        TestListener* listener;
+        TextLogVerbosity detailVerbosity;
+        const atomic<bool>* runCancelled;
+        LogBuffer logBuffer;
+        LogRetention logRetention;
 
         void AddAssertResult(AssertType enType, bool passed, const string& description, const string& details);
         void TestForThrow(const bool throwExpected, std::function<void(void)>& expr, const string& description);
 
+        //Throws AbortTestMethod if the assert which was just recorded failed
+        void StopIfLastAssertFailed();
+
+        //Failing asserts always record their details (for the reports), passing asserts only do the
+        //formatting work if every detail is to be printed
+        bool ShouldCaptureDetails(bool passed) const;
+
+        //Moves the buffered logs into the results once the test method has returned
+        void EmitLogs();
+
     public:
-        Tester(TestResults& boundResults);
+        Tester(
+            TestResults& boundResults, 
+            TestListener* listener = nullptr, 
+            TextLogVerbosity detailVerbosity = TextLogVerbosity::printAdditionalDetailsOnFailingTests,
+            const atomic<bool>* runCancelled = nullptr,
+            const LogOptions& logOptions = LogOptions());
         void log(const string& message);
 
+        //Keeps the format & a copy of the arguments, the log is only formatted with cfmt if it ends up in the results
+        //i.e. test.logf("Iteration %t of %t", i, n). Takes string literals only, the format is read after the call.
+        template<size_t NFormatLength, typename ...TArgs>
+        void logf(const char (&format)[NFormatLength], const TArgs&... args)
+        {
+            const AllocationTrackingPause bookkeeping;
+            logBuffer.Push(format, args...);
+        }
+
+        //Set once the run has been cancelled (see RunOptions::maxFailures). The next assert stops the test
+        //method anyway, long-running tests without asserts can poll this to stop early.
+        bool run_cancelled() const;
+
         void assert(bool value, const string& description);
 
+        //Use via the CHECK(expression) macro
+        template<typename TExpression>
+        void check(const TExpression& expression, const string& description)
+        {
+            const bool passed = expression.GetResult();
+            AddAssertResult(
+                AssertType::check,
+                passed,
+                description,
+                ShouldCaptureDetails(passed)? "Expansion: " + expression.Describe() : string()
+            );
+        }
+
         void assert_throw(std::function<void(void)> expr, const string& description);
         void assert_nothrow(std::function<void(void)> expr, const string& description);
 
+        //Heap budgets for expr, counting the allocations it makes on the calling thread.
+        //Fail without checking anything unless built with CANARY_TRACK_ALLOCATIONS.
+        void assert_max_allocations(uint64_t maxAllocations, std::function<void(void)> expr, const string& description);
+        void assert_max_peak_bytes(int64_t maxPeakBytes, std::function<void(void)> expr, const string& description);
+
+        //Time budget for expr: after one untimed warm-up call, expr is timed nSamples times and its median
+        //has to stay within maxMedianNanos
+        void assert_max_median_nanos(int64_t maxMedianNanos, std::function<void(void)> expr, const string& description, size_t nSamples = 11);
+
         template<typename T>
         void assert_eq(const T& actual, const T& expected, const string& description)
         {
@@ -72,15 +306,15 @@ namespace CTest
             );
 
             using namespace std;
-            string details = 
-                "Actual: " + StrConverter::str_converter<T>::get(actual) + 
-                " |Expected: " + StrConverter::str_converter<T>::get(expected);
-
+            const bool passed = actual == expected;
             AddAssertResult(
                 AssertType::assert_equals,
-                actual == expected,
+                passed,
                 description,
-                details
+                ShouldCaptureDetails(passed)?
+                    "Actual: " + StrConverter::str_converter<T>::get(actual) + 
+                    " |Expected: " + StrConverter::str_converter<T>::get(expected) :
+                    string()
             );
         }
 
@@ -92,21 +326,185 @@ namespace CTest
                 "assert_neq requires a to_string() function or string cast operator to log down tested values"
             );
 
-            const string details = 
-                "Actual: " + StrConverter::str_converter<T>::get(actual) + 
-                " |Compared Value: " + StrConverter::str_converter<T>::get(comparedValue);
-
+            const bool passed = actual != comparedValue;
             AddAssertResult(
                 AssertType::assert_notequals,
-                actual != comparedValue,
+                passed,
                 description,
-                details
+                ShouldCaptureDetails(passed)?
+                    "Actual: " + StrConverter::str_converter<T>::get(actual) + 
+                    " |Compared Value: " + StrConverter::str_converter<T>::get(comparedValue) :
+                    string()
             );
         }
+
+        //Fatal variants of the asserts above: a failure is recorded the same way,
+        //then the rest of the test method is skipped
+        void require(bool value, const string& description);
+        void require_throw(std::function<void(void)> expr, const string& description);
+        void require_nothrow(std::function<void(void)> expr, const string& description);
+
+        //Use via the REQUIRE(expression) macro
+        template<typename TExpression>
+        void require_check(const TExpression& expression, const string& description)
+        {
+            check(expression, description);
+            StopIfLastAssertFailed();
+        }
+
+        template<typename T>
+        void require_eq(const T& actual, const T& expected, const string& description)
+        {
+            assert_eq(actual, expected, description);
+            StopIfLastAssertFailed();
+        }
+
+        template<typename T>
+        void require_neq(const T& actual, const T& comparedValue, const string& description)
+        {
+            assert_neq(actual, comparedValue, description);
+            StopIfLastAssertFailed();
+        }
     };
 
     using TTestMethod = function<void(Tester& tester)>; 
 
+    enum class ExecutionIsolation
+    {
+        sharedProcess,
+        forkedProcesses //POSIX only, a crashing test only takes down its own worker process
+    };
+
+    enum class HistoryOrder
+    {
+        asRegistered,
+        previouslyFailedFirst,  //Tests which failed in the previous run start first, the rest of the selection follows
+        previouslyFailedOnly    //Only the tests which failed in the previous run
+    };
+
+    struct RepeatOptions
+    {
+        //Iterations of each selected test. 0 repeats until budgetMillis runs out.
+        size_t count = 1;
+
+        //No new iteration of a test is started once it has been repeating for this long, 0 for no limit
+        int64_t budgetMillis = 0;
+
+        //Stops repeating a test after its first failing iteration
+        bool untilFirstFailure = false;
+
+        bool IsRepeating() const { return count != 1 || budgetMillis > 0; }
+    };
+
+    enum class BaselineMode
+    {
+        compare,    //Tests with a baseline are compared against it, the others get one recorded
+        update      //Every passing test's baseline is replaced with this run's timings, nothing is compared
+    };
+
+    struct BaselineOptions
+    {
+        //State file holding the timing baseline of each test (see PerformanceBaselines.h),
+        //read before the run and saved after it if any baseline was recorded. Empty disables it.
+        string file;
+
+        BaselineMode mode = BaselineMode::compare;
+
+        //A passing test whose median time exceeds its baseline median by more than both of these fails
+        //with a 'regression' assert. Single-run tests have no spread of their own to go by, repeat them
+        //(see RunOptions::repeat) so that the median & MAD are over several iterations.
+        double madFactor = 3.0;             //Multiple of the baseline's scaled median absolute deviation
+        double minRelativeSlowdown = 0.1;   //Fraction of the baseline median
+
+        //Tests are only compared when both the baseline and the run have at least this many samples,
+        //fewer cannot tell a slowdown from ordinary jitter. A baseline short of samples is replaced instead.
+        size_t minSamples = 5;
+    };
+
+    struct RunOptions
+    {
+        //Number of worker threads used to execute test methods.
+        //1 runs every test on the calling thread, 0 uses one worker per hardware thread.
+        //Test methods must not share unsynchronized state when more than 1 job is used.
+        size_t jobs = 1;
+
+        //forkedProcesses runs tests in a pool of 'jobs' child processes. A test which terminates its process
+        //is reported as failed and the rest of the run carries on in a freshly forked worker.
+        ExecutionIsolation isolation = ExecutionIsolation::sharedProcess;
+
+        //Notified as tests start, assert and finish (not owned)
+        vector<TestListener*> listeners;
+
+        //false discards each TestResults once the listeners have seen it, keeping memory flat
+        //for very large suites. The Run...() methods then return an empty vector.
+        bool retainResults = true;
+
+        //Which asserts capture their additional details (i.e. the actual & expected values).
+        //Should match the verbosity the results are reported with, anything else is wasted work.
+        TextLogVerbosity detailVerbosity = TextLogVerbosity::printAdditionalDetailsOnFailingTests;
+
+        //State file remembering the outcome of each test across runs (see TestHistory.h),
+        //read before the run and updated once it completes. Empty disables it.
+        string historyFile;
+
+        //How the previous outcomes in historyFile change the tests run & their order
+        HistoryOrder historyOrder = HistoryOrder::asRegistered;
+
+        //Deadline for tests registered without a timeout of their own, 0 for none.
+        //An overrunning test is recorded with a 'timeout' assert. With forkedProcesses its worker is killed
+        //and the run carries on, otherwise the listeners are notified and the process exits with timeoutExitCode.
+        int64_t defaultTimeoutMillis = 0;
+
+        //Cancels the run once this many tests have failed, 0 runs every test regardless.
+        //Queued tests are skipped and tests already running stop at their next assert; neither is
+        //reported, except for tests which failed before stopping.
+        size_t maxFailures = 0;
+
+        //Runs every selected test many times over to expose flaky tests, aggregating the iterations into a
+        //single result per test. Iterations of the same test are spread across the 'jobs' worker threads,
+        //with forkedProcesses each worker process repeats its own test.
+        RepeatOptions repeat;
+
+        //Counts cycles, instructions, branch misses & L1d/LLC read misses around each test method (Linux only).
+        //Where perf events are unavailable (i.e. restricted by perf_event_paranoid or a container) the tests
+        //run as usual and hasHardwareCounters is left unset.
+        bool countHardwareEvents = false;
+
+        //Compares the timings of every passing test with those recorded by earlier runs
+        BaselineOptions baseline;
+
+        //Bounds the logs kept by each test & whether passing tests keep theirs at all
+        LogOptions logs;
+    };
+
+    //Exit status of a shared-process run aborted by a test overrunning its timeout
+    const int timeoutExitCode = 124;
+
+    enum class NamePatternSyntax
+    {
+        glob,   //'*' matches any run of characters, '?' any single character
+        regex   //ECMAScript std::regex, matched against the whole method name
+    };
+
+    //Selects a subset of the registered tests. Empty lists do not filter anything,
+    //a test has to satisfy every list which is not empty.
+    struct TestQuery
+    {
+        //Exact group names, the test has to be in any one of them
+        vector<string> groups;
+
+        //The method name has to match any one of these patterns
+        vector<string> namePatterns;
+        NamePatternSyntax patternSyntax = NamePatternSyntax::glob;
+
+        //The test has to carry any one of includeTags and none of excludeTags
+        vector<string> includeTags;
+        vector<string> excludeTags;
+    };
+
+    class TestHistory; //TestHistory.h
+    class Watchdog; //Watchdog.h
+
     class Canary
     {
         struct TestMethod
@@ -114,32 +512,81 @@ namespace CTest
             string name;
             string groupName;
             TTestMethod method;
+            vector<string> tags;
+            int64_t timeoutMillis;  //0 uses RunOptions::defaultTimeoutMillis
         };
 
         vector<TestMethod> testMethodList;
 
-        Canary() = default;
+        //Group & tag -> method indices, built on first use after registration
+        class RegistryIndex;
+        unique_ptr<RegistryIndex> registryIndex;
+
+        Canary();
+        ~Canary();
         
-        static vector<TestResults> ExecuteTestMethods(vector<TestMethod>& methodList);
+        class RunProgress;
+
+        vector<size_t> SelectTests(const TestQuery& query);
+
+        static TestResults ExecuteTestMethod(const TestMethod& testMethod, TestListener* listener, TextLogVerbosity detailVerbosity, const atomic<bool>* runCancelled, bool countHardwareEvents, const LogOptions& logOptions);
+        static TestResults MakeTerminatedTestResults(const TestMethod& testMethod, const string& reason);
+        static TestResults MakeTimedOutTestResults(const TestMethod& testMethod, const string& details);
+        static int64_t ResolveTimeoutMillis(const TestMethod& testMethod, const RunOptions& options);
+        static TestResults ExecuteRepeatedTestMethod(const TestMethod& testMethod, const RunOptions& options);
+        void ExecuteInForkedProcesses(const vector<size_t>& selection, const vector<size_t>& taskOrder, size_t nWorkers, const RunOptions& options, RunProgress& progress) const;
+        unique_ptr<Watchdog> StartWatchdog(const vector<size_t>& selection, size_t keysPerTest, const RunOptions& options, RunProgress& progress) const;
+        void ExecuteInSharedProcess(const vector<size_t>& selection, const vector<size_t>& taskOrder, size_t nWorkers, const RunOptions& options, RunProgress& progress) const;
+        void ExecuteRepeatedInSharedProcess(const vector<size_t>& selection, const vector<size_t>& taskOrder, const RunOptions& options, RunProgress& progress) const;
+
+        vector<size_t> ApplyHistoryOrder(const vector<size_t>& selection, const TestHistory& history, HistoryOrder order) const;
+
+        //Positions into selection, longest expected duration first so that no long test is started last
+        vector<size_t> ScheduleLongestFirst(const vector<size_t>& selection, const TestHistory& history, HistoryOrder order) const;
+
+        //Runs testMethodList[selection[i]] for every i, without copying the methods
+        vector<TestResults> ExecuteTestMethods(const vector<size_t>& selection, const RunOptions& options) const;
     public:
         static Canary& Instance();
-        void AddTestMethod(const string& methodName, const string& groupName, TTestMethod testMethod);
+        void AddTestMethod(const string& methodName, const string& groupName, TTestMethod testMethod, vector<string> tags = {}, int64_t timeoutMillis = 0);
+
+        vector<TestResults> RunAllTests(const RunOptions& options = RunOptions{});
+        vector<TestResults> RunTestGroup(const string& name, const RunOptions& options = RunOptions{});
+        vector<TestResults> RunQuery(const TestQuery& query, const RunOptions& options = RunOptions{});
 
-        vector<TestResults> RunAllTests();
-        vector<TestResults> RunTestGroup(const string& name);
+        //Runs the subset of all tests assigned to shardIndex (0-based) out of shardCount shards.
+        //Assignment depends only on each test's group and method name (see GetTestShard), 
+        //so every machine computes the same partition regardless of registration order.
+        vector<TestResults> RunShard(size_t shardIndex, size_t shardCount, const RunOptions& options = RunOptions{});
     };
 
     class MethodRegistrar
     {
     public:
-        MethodRegistrar(string methodName, string groupName, TTestMethod method);
+        MethodRegistrar(string methodName, string groupName, TTestMethod method, vector<string> tags = {}, int64_t timeoutMillis = 0);
     };
 
+    //Stable 64-bit FNV-1a hash of the group & method name, reduced to a shard number in [0, shardCount)
+    size_t GetTestShard(const string& groupName, const string& methodName, size_t shardCount);
+
+    //Combines the results of several runs (i.e. one per shard) into a single result set,
+    //ordered the same way as the results of RunAllTests()
+    vector<TestResults> MergeTestResults(vector<vector<TestResults>> resultSets);
+
     string JsonifyTestResults(const vector<TestResults>& results);
+    string JsonifyTestResults(const vector<TestResults>& results, JsonStyle style);
+    string JsonifyTestResults(const TestResultsView& results, JsonStyle style);
+
+    //Streams the report in chunks instead of building the complete document as a single string
+    void WriteJsonReport(const vector<TestResults>& results, ostream& output, JsonStyle style);
+    void WriteJsonReport(const TestResultsView& results, ostream& output, JsonStyle style);
 
     string FormatAsText(
         const vector<TestResults>& results, 
         enum TextLogVerbosity = TextLogVerbosity::printAdditionalDetailsOnFailingTests);
+    string FormatAsText(
+        const TestResultsView& results, 
+        enum TextLogVerbosity = TextLogVerbosity::printAdditionalDetailsOnFailingTests);
 }
 
 #define TEST_METHOD_NAME(METHOD_NAME) _test_method_##METHOD_NAME
@@ -150,6 +597,45 @@ namespace CTest
     void TEST_METHOD_NAME(METHOD_NAME)(CTest::Tester& test)
 
 #define TEST_METHOD(METHOD_NAME) TEST_GROUPED_METHOD(METHOD_NAME, "")
+
+//Tags are string literals, i.e. TEST_TAGGED_METHOD(Name, "group", "slow", "network")
+#define TEST_TAGGED_METHOD(METHOD_NAME, LPSTR_GROUP_NAME, ...)  \
+    void TEST_METHOD_NAME(METHOD_NAME)(CTest::Tester&);     \
+    static CTest::MethodRegistrar _test_registrar##METHOD_NAME(#METHOD_NAME, LPSTR_GROUP_NAME, TEST_METHOD_NAME(METHOD_NAME), {__VA_ARGS__}); \
+    void TEST_METHOD_NAME(METHOD_NAME)(CTest::Tester& test)
+
+//Fails the test with a 'timeout' assert once it runs for longer than TIMEOUT_MILLIS (see RunOptions::defaultTimeoutMillis)
+#define TEST_TIMED_METHOD(METHOD_NAME, LPSTR_GROUP_NAME, TIMEOUT_MILLIS)  \
+    void TEST_METHOD_NAME(METHOD_NAME)(CTest::Tester&);     \
+    static CTest::MethodRegistrar _test_registrar##METHOD_NAME(#METHOD_NAME, LPSTR_GROUP_NAME, TEST_METHOD_NAME(METHOD_NAME), {}, TIMEOUT_MILLIS); \
+    void TEST_METHOD_NAME(METHOD_NAME)(CTest::Tester& test)
+
+//Records the outcome of a comparison, i.e. CHECK(a == b), along with its source text.
+//The operands are only converted to strings if the details are going to be reported.
+#if defined(__GNUC__) || defined(__clang__)
+    #define CTEST_SUPPRESS_PARENTHESES_WARNINGS_BEGIN \
+        _Pragma("GCC diagnostic push") \
+        _Pragma("GCC diagnostic ignored \"-Wparentheses\"")
+    #define CTEST_SUPPRESS_PARENTHESES_WARNINGS_END _Pragma("GCC diagnostic pop")
+#else
+    #define CTEST_SUPPRESS_PARENTHESES_WARNINGS_BEGIN
+    #define CTEST_SUPPRESS_PARENTHESES_WARNINGS_END
+#endif
+
+#define CHECK(EXPRESSION) \
+    do { \
+        CTEST_SUPPRESS_PARENTHESES_WARNINGS_BEGIN \
+        test.check(CTest::ExpressionDecomposer() <= EXPRESSION, #EXPRESSION); \
+        CTEST_SUPPRESS_PARENTHESES_WARNINGS_END \
+    } while(false)
+
+//Same as CHECK(), but stops the test method if the expression does not hold
+#define REQUIRE(EXPRESSION) \
+    do { \
+        CTEST_SUPPRESS_PARENTHESES_WARNINGS_BEGIN \
+        test.require_check(CTest::ExpressionDecomposer() <= EXPRESSION, #EXPRESSION); \
+        CTEST_SUPPRESS_PARENTHESES_WARNINGS_END \
+    } while(false)
     
     
     
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <type_traits>
+
+#include "StringConverter.h"
+
+//Support for the CHECK(a == b) macro: "ExpressionDecomposer() <= a == b" parses as
+//"(ExpressionDecomposer() <= a) == b", which captures both operands by reference and
+//evaluates the comparison once. The operands are only converted to strings when the
+//details of the check are actually requested.
+namespace CTest
+{
+    //Values without a to_string() or string conversion can still be checked,
+    //they are just not shown in the details
+    template<typename T>
+    std::string DescribeValue(const T& value, std::true_type /*convertible*/)
+    {
+        return StrConverter::str_converter<T>::get(value);
+    }
+
+    template<typename T>
+    std::string DescribeValue(const T&, std::false_type /*convertible*/)
+    {
+        return "{?}";
+    }
+
+    template<typename T>
+    std::string DescribeValue(const T& value)
+    {
+        using TConvertible = std::integral_constant<
+            bool,
+            StrConverter::str_converter<T>::scheme != StrConverter::conversion_scheme::none
+        >;
+        return DescribeValue(value, TConvertible{});
+    }
+
+    template<typename TLhs, typename TRhs>
+    class BinaryExpression
+    {
+        const TLhs& lhs;
+        const TRhs& rhs;
+        const char* comparison;
+        bool result;
+    public:
+        BinaryExpression(const TLhs& _lhs, const TRhs& _rhs, const char* _comparison, bool _result)
+        : lhs{_lhs}
+        , rhs{_rhs}
+        , comparison{_comparison}
+        , result{_result}
+        {}
+
+        bool GetResult() const { return result; }
+
+        std::string Describe() const
+        {
+            return DescribeValue(lhs) + " " + comparison + " " + DescribeValue(rhs);
+        }
+    };
+
+    template<typename TLhs>
+    class ExpressionLhs
+    {
+        const TLhs& lhs;
+    public:
+        explicit ExpressionLhs(const TLhs& _lhs)
+        : lhs{_lhs}
+        {}
+
+        //CHECK(value) without any comparison
+        bool GetResult() const { return static_cast<bool>(lhs); }
+        std::string Describe() const { return DescribeValue(lhs); }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator==(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, "==", static_cast<bool>(lhs == rhs));
+        }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator!=(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, "!=", static_cast<bool>(lhs != rhs));
+        }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator<(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, "<", static_cast<bool>(lhs < rhs));
+        }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator<=(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, "<=", static_cast<bool>(lhs <= rhs));
+        }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator>(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, ">", static_cast<bool>(lhs > rhs));
+        }
+
+        template<typename TRhs>
+        BinaryExpression<TLhs, TRhs> operator>=(const TRhs& rhs) const
+        {
+            return BinaryExpression<TLhs, TRhs>(lhs, rhs, ">=", static_cast<bool>(lhs >= rhs));
+        }
+    };
+
+    struct ExpressionDecomposer
+    {
+        template<typename TLhs>
+        ExpressionLhs<TLhs> operator<=(const TLhs& lhs) const
+        {
+            return ExpressionLhs<TLhs>(lhs);
+        }
+    };
+}
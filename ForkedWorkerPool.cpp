@@ -0,0 +1,633 @@
+#include "ForkedWorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CANARY_HAS_FORK 1
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#else
+#define CANARY_HAS_FORK 0
+#endif
+
+namespace CTest
+{
+#pragma region Serialization
+    //Results are only ever exchanged between a parent and its own forked children,
+    //so integers are written in native byte order
+    namespace
+    {
+        template<typename T>
+        void WriteRaw(string& buffer, T value)
+        {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void WriteString(string& buffer, const string& value)
+        {
+            WriteRaw<uint32_t>(buffer, static_cast<uint32_t>(value.size()));
+            buffer.append(value);
+        }
+
+        class ByteReader
+        {
+            const char* current;
+            const char* end;
+
+            void Require(size_t nBytes)
+            {
+                if(static_cast<size_t>(end - current) < nBytes)
+                {
+                    throw runtime_error("truncated test result message");
+                }
+            }
+        public:
+            ByteReader(const char* data, size_t size)
+            : current{data}
+            , end{data + size}
+            {}
+
+            template<typename T>
+            T ReadRaw()
+            {
+                Require(sizeof(T));
+                T value;
+                memcpy(&value, current, sizeof(T));
+                current += sizeof(T);
+                return value;
+            }
+
+            string ReadString()
+            {
+                const uint32_t length = ReadRaw<uint32_t>();
+                Require(length);
+                string value(current, length);
+                current += length;
+                return value;
+            }
+        };
+    }
+
+    void SerializeTestResults(const TestResults& results, string& buffer)
+    {
+        WriteString(buffer, results.methodName);
+        WriteString(buffer, results.groupName);
+        WriteRaw<int64_t>(buffer, results.executionTimeMillis);
+        WriteRaw<int64_t>(buffer, results.executionTimeNanos);
+        WriteRaw<int64_t>(buffer, results.threadCpuTimeNanos);
+        WriteRaw<int64_t>(buffer, results.processCpuTimeNanos);
+
+        WriteRaw<uint32_t>(buffer, static_cast<uint32_t>(results.assertionResults.size()));
+        for(const AssertResult& assertResult: results.assertionResults)
+        {
+            WriteRaw<uint8_t>(buffer, static_cast<uint8_t>(assertResult.assertType));
+            WriteRaw<uint8_t>(buffer, assertResult.passed? 1 : 0);
+            WriteString(buffer, assertResult.description);
+            WriteString(buffer, assertResult.additionalDetails);
+        }
+
+        WriteRaw<uint32_t>(buffer, static_cast<uint32_t>(results.logs.size()));
+        for(const string& log: results.logs)
+        {
+            WriteString(buffer, log);
+        }
+        WriteRaw<uint64_t>(buffer, results.nDroppedLogs);
+
+        WriteRaw<uint8_t>(buffer, results.isBenchmark? 1 : 0);
+        if(results.isBenchmark)
+        {
+            WriteRaw<uint64_t>(buffer, results.benchmark.iterationsPerSample);
+            WriteRaw<uint32_t>(buffer, static_cast<uint32_t>(results.benchmark.nanosPerIterationSamples.size()));
+            for(const double sample: results.benchmark.nanosPerIterationSamples)
+            {
+                WriteRaw<double>(buffer, sample);
+            }
+        }
+
+        WriteRaw<uint8_t>(buffer, results.hasAllocationStatistics? 1 : 0);
+        if(results.hasAllocationStatistics)
+        {
+            WriteRaw<uint64_t>(buffer, results.allocations.nAllocations);
+            WriteRaw<uint64_t>(buffer, results.allocations.allocatedBytes);
+            WriteRaw<int64_t>(buffer, results.allocations.peakLiveBytes);
+            WriteRaw<int64_t>(buffer, results.allocations.leakedBytes);
+        }
+
+        WriteRaw<uint8_t>(buffer, results.isRepeated? 1 : 0);
+        if(results.isRepeated)
+        {
+            WriteRaw<uint64_t>(buffer, results.repeat.nIterations);
+            WriteRaw<uint64_t>(buffer, results.repeat.nFailedIterations);
+            WriteRaw<uint64_t>(buffer, results.repeat.firstFailedIteration);
+            WriteRaw<uint32_t>(buffer, static_cast<uint32_t>(results.repeat.wallNanosSamples.size()));
+            for(const double sample: results.repeat.wallNanosSamples)
+            {
+                WriteRaw<double>(buffer, sample);
+            }
+        }
+
+        WriteRaw<uint8_t>(buffer, results.hasHardwareCounters? 1 : 0);
+        if(results.hasHardwareCounters)
+        {
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.cycles);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.instructions);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.branchMisses);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.l1dReadMisses);
+            WriteRaw<int64_t>(buffer, results.hardwareCounters.llcReadMisses);
+        }
+    }
+
+    TestResults DeserializeTestResults(const char* data, size_t size)
+    {
+        ByteReader reader(data, size);
+        TestResults results;
+        results.methodName = reader.ReadString();
+        results.groupName = reader.ReadString();
+        results.executionTimeMillis = reader.ReadRaw<int64_t>();
+        results.executionTimeNanos = reader.ReadRaw<int64_t>();
+        results.threadCpuTimeNanos = reader.ReadRaw<int64_t>();
+        results.processCpuTimeNanos = reader.ReadRaw<int64_t>();
+
+        const uint32_t nAsserts = reader.ReadRaw<uint32_t>();
+        for(uint32_t i = 0; i < nAsserts; i++)
+        {
+            AssertResult assertResult;
+            assertResult.assertType = static_cast<AssertType>(reader.ReadRaw<uint8_t>());
+            assertResult.passed = reader.ReadRaw<uint8_t>() != 0;
+            assertResult.description = reader.ReadString();
+            assertResult.additionalDetails = reader.ReadString();
+            results.assertionResults.emplace_back(move(assertResult));
+        }
+
+        const uint32_t nLogs = reader.ReadRaw<uint32_t>();
+        for(uint32_t i = 0; i < nLogs; i++)
+        {
+            results.logs.emplace_back(reader.ReadString());
+        }
+        results.nDroppedLogs = static_cast<size_t>(reader.ReadRaw<uint64_t>());
+
+        results.isBenchmark = reader.ReadRaw<uint8_t>() != 0;
+        if(results.isBenchmark)
+        {
+            results.benchmark.iterationsPerSample = reader.ReadRaw<uint64_t>();
+            const uint32_t nSamples = reader.ReadRaw<uint32_t>();
+            for(uint32_t i = 0; i < nSamples; i++)
+            {
+                results.benchmark.nanosPerIterationSamples.push_back(reader.ReadRaw<double>());
+            }
+            //Cheaper to recompute than to send
+            results.benchmark.nanosPerIteration = ComputeSampleStatistics(results.benchmark.nanosPerIterationSamples);
+        }
+
+        results.hasAllocationStatistics = reader.ReadRaw<uint8_t>() != 0;
+        if(results.hasAllocationStatistics)
+        {
+            results.allocations.nAllocations = reader.ReadRaw<uint64_t>();
+            results.allocations.allocatedBytes = reader.ReadRaw<uint64_t>();
+            results.allocations.peakLiveBytes = reader.ReadRaw<int64_t>();
+            results.allocations.leakedBytes = reader.ReadRaw<int64_t>();
+        }
+
+        results.isRepeated = reader.ReadRaw<uint8_t>() != 0;
+        if(results.isRepeated)
+        {
+            results.repeat.nIterations = static_cast<size_t>(reader.ReadRaw<uint64_t>());
+            results.repeat.nFailedIterations = static_cast<size_t>(reader.ReadRaw<uint64_t>());
+            results.repeat.firstFailedIteration = static_cast<size_t>(reader.ReadRaw<uint64_t>());
+            const uint32_t nSamples = reader.ReadRaw<uint32_t>();
+            for(uint32_t i = 0; i < nSamples; i++)
+            {
+                results.repeat.wallNanosSamples.push_back(reader.ReadRaw<double>());
+            }
+            results.repeat.wallNanos = ComputeSampleStatistics(results.repeat.wallNanosSamples);
+        }
+
+        results.hasHardwareCounters = reader.ReadRaw<uint8_t>() != 0;
+        if(results.hasHardwareCounters)
+        {
+            results.hardwareCounters.cycles = reader.ReadRaw<int64_t>();
+            results.hardwareCounters.instructions = reader.ReadRaw<int64_t>();
+            results.hardwareCounters.branchMisses = reader.ReadRaw<int64_t>();
+            results.hardwareCounters.l1dReadMisses = reader.ReadRaw<int64_t>();
+            results.hardwareCounters.llcReadMisses = reader.ReadRaw<int64_t>();
+        }
+
+        return results;
+    }
+#pragma endregion
+
+#pragma region ForkedWorkerPool
+    ForkedWorkerPool::ForkedWorkerPool(size_t _nWorkers)
+    : nWorkers{_nWorkers == 0? 1 : _nWorkers}
+    {}
+
+    bool ForkedWorkerPool::IsSupported()
+    {
+        return CANARY_HAS_FORK != 0;
+    }
+
+#if CANARY_HAS_FORK
+    namespace
+    {
+        const size_t noTask = SIZE_MAX;
+
+        struct WorkerProcess
+        {
+            pid_t pid = -1;
+            int taskFd = -1;    //parent -> child, task indices
+            int resultFd = -1;  //child -> parent, length-prefixed TestResults
+            size_t currentTask = noTask;
+            chrono::steady_clock::time_point taskStartTime;
+            int64_t timeoutMillis = 0;  //0 when the current task has no deadline
+        };
+
+        bool WriteAll(int fd, const char* data, size_t size)
+        {
+            while(size > 0)
+            {
+                const ssize_t written = write(fd, data, size);
+                if(written < 0 && errno == EINTR) continue;
+                if(written <= 0) return false;
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        //Returns false on EOF or error, i.e. when the other end of the pipe has gone away
+        bool ReadAll(int fd, char* data, size_t size)
+        {
+            while(size > 0)
+            {
+                const ssize_t nRead = read(fd, data, size);
+                if(nRead < 0 && errno == EINTR) continue;
+                if(nRead <= 0) return false;
+                data += nRead;
+                size -= static_cast<size_t>(nRead);
+            }
+            return true;
+        }
+
+        void CloseFd(int& fd)
+        {
+            if(fd >= 0) close(fd);
+            fd = -1;
+        }
+
+        //Parent-side pipe ends of every live worker in this process, across all pools.
+        //Pools can run at the same time (i.e. from tests running on several threads), so a new child
+        //has to close the pipes of other pools' workers as well, or they would never see EOF.
+        mutex workerPipesLock;
+        vector<int> workerPipeFds;
+
+        void ReleaseWorkerPipe(int& fd)
+        {
+            if(fd < 0) return;
+
+            lock_guard<mutex> guard(workerPipesLock);
+            workerPipeFds.erase(remove(workerPipeFds.begin(), workerPipeFds.end(), fd), workerPipeFds.end());
+            CloseFd(fd);
+        }
+
+        [[noreturn]] void ChildLoop(int taskFd, int resultFd, const ForkedWorkerPool::TRunTask& runTask, const ForkedWorkerPool::TMakeFailure& makeFailure)
+        {
+            string message;
+            uint64_t taskIndex = 0;
+            while(ReadAll(taskFd, reinterpret_cast<char*>(&taskIndex), sizeof(taskIndex)))
+            {
+                TestResults results;
+                try
+                {
+                    results = runTask(static_cast<size_t>(taskIndex));
+                }
+                catch(const exception& stdException)
+                {
+                    results = makeFailure(static_cast<size_t>(taskIndex), "Uncaught exception: " + string(stdException.what()));
+                }
+                catch(...)
+                {
+                    results = makeFailure(static_cast<size_t>(taskIndex), "Uncaught exception not derived from std::exception");
+                }
+
+                message.clear();
+                WriteRaw<uint32_t>(message, 0);
+                SerializeTestResults(results, message);
+                const uint32_t payloadSize = static_cast<uint32_t>(message.size() - sizeof(uint32_t));
+                memcpy(&message[0], &payloadSize, sizeof(payloadSize));
+
+                //_exit() drops buffered output, and a later test may crash the worker before it gets there
+                fflush(nullptr);
+                if(!WriteAll(resultFd, message.data(), message.size())) break;
+            }
+            //Skip static destructors and atexit handlers, those belong to the parent
+            fflush(nullptr);
+            _exit(0);
+        }
+
+        string DescribeExitStatus(int status)
+        {
+            if(WIFSIGNALED(status))
+            {
+                const int signalNumber = WTERMSIG(status);
+                const char* signalName = strsignal(signalNumber);
+                return "Terminated by signal " + to_string(signalNumber) +
+                    " (" + (signalName != nullptr? signalName : "unknown") + ")";
+            }
+            if(WIFEXITED(status))
+            {
+                return "Exited with status " + to_string(WEXITSTATUS(status));
+            }
+            return "Terminated for an unknown reason";
+        }
+
+        class WorkerSet
+        {
+            vector<WorkerProcess> workers;
+            const ForkedWorkerPool::TRunTask& runTask;
+            const ForkedWorkerPool::TMakeFailure& makeFailure;
+
+        public:
+            WorkerSet(size_t nWorkers, const ForkedWorkerPool::TRunTask& _runTask, const ForkedWorkerPool::TMakeFailure& _makeFailure)
+            : workers(nWorkers)
+            , runTask{_runTask}
+            , makeFailure{_makeFailure}
+            {}
+
+            vector<WorkerProcess>& Workers() { return workers; }
+
+            void Spawn(size_t workerIndex)
+            {
+                //Held until both parent-side ends are registered, so that no other pool
+                //forks a child in between which would not know to close them
+                unique_lock<mutex> pipesLock(workerPipesLock);
+
+                int taskPipe[2];
+                int resultPipe[2];
+                if(pipe(taskPipe) != 0) throw runtime_error("unable to create worker task pipe");
+                if(pipe(resultPipe) != 0)
+                {
+                    close(taskPipe[0]);
+                    close(taskPipe[1]);
+                    throw runtime_error("unable to create worker result pipe");
+                }
+
+                //Unflushed stdio buffers would otherwise be written out twice
+                fflush(nullptr);
+                const pid_t pid = fork();
+                if(pid < 0)
+                {
+                    for(int fd: {taskPipe[0], taskPipe[1], resultPipe[0], resultPipe[1]}) close(fd);
+                    throw runtime_error("unable to fork test worker process");
+                }
+
+                if(pid == 0)
+                {
+                    //Drop every pipe end belonging to sibling workers (and to workers of other pools), 
+                    //otherwise a sibling's death would never be seen as EOF by the parent
+                    for(int& fd: workerPipeFds) CloseFd(fd);
+                    workerPipeFds.clear();
+                    for(WorkerProcess& sibling: workers)
+                    {
+                        sibling.taskFd = -1;
+                        sibling.resultFd = -1;
+                    }
+                    close(taskPipe[1]);
+                    close(resultPipe[0]);
+
+                    //This child may start pools of its own
+                    pipesLock.unlock();
+                    ChildLoop(taskPipe[0], resultPipe[1], runTask, makeFailure);
+                }
+
+                close(taskPipe[0]);
+                close(resultPipe[1]);
+                workerPipeFds.push_back(taskPipe[1]);
+                workerPipeFds.push_back(resultPipe[0]);
+
+                WorkerProcess& worker = workers[workerIndex];
+                worker.pid = pid;
+                worker.taskFd = taskPipe[1];
+                worker.resultFd = resultPipe[0];
+                worker.currentTask = noTask;
+            }
+
+            //Closes the pipes and reaps the child, returning a description of how it ended
+            string Reap(size_t workerIndex)
+            {
+                WorkerProcess& worker = workers[workerIndex];
+                ReleaseWorkerPipe(worker.taskFd);
+                ReleaseWorkerPipe(worker.resultFd);
+
+                int status = 0;
+                while(waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+                worker.pid = -1;
+                return DescribeExitStatus(status);
+            }
+
+            ~WorkerSet()
+            {
+                for(size_t i = 0; i < workers.size(); i++)
+                {
+                    if(workers[i].pid <= 0) continue;
+                    //Only reached mid-test when Run() is left by an exception, waiting on a test which hangs would never return
+                    if(workers[i].currentTask != noTask) kill(workers[i].pid, SIGKILL);
+                    Reap(i);
+                }
+            }
+        };
+
+        //Writes to a pipe whose reader has died must fail with EPIPE instead of killing the parent
+        class IgnoreSigPipe
+        {
+            struct sigaction previous;
+        public:
+            IgnoreSigPipe()
+            {
+                struct sigaction ignore;
+                memset(&ignore, 0, sizeof(ignore));
+                ignore.sa_handler = SIG_IGN;
+                sigaction(SIGPIPE, &ignore, &previous);
+            }
+            ~IgnoreSigPipe()
+            {
+                sigaction(SIGPIPE, &previous, nullptr);
+            }
+        };
+    }
+
+    void ForkedWorkerPool::Run(
+        const vector<size_t>& taskOrder,
+        const TRunTask& runTask,
+        const TMakeFailure& makeFailure,
+        const TOnResult& onResult,
+        const TGetTimeout& getTimeoutMillis,
+        const TMakeFailure& makeTimeout,
+        const TIsCancelled& isCancelled)
+    {
+        IgnoreSigPipe sigPipeGuard;
+        WorkerSet workerSet(min(nWorkers, max<size_t>(taskOrder.size(), 1)), runTask, makeFailure);
+        vector<WorkerProcess>& workers = workerSet.Workers();
+
+        for(size_t i = 0; i < workers.size(); i++)
+        {
+            workerSet.Spawn(i);
+        }
+
+        size_t nextTask = 0;
+        size_t nInFlight = 0;
+
+        auto recordFailure = [&](size_t workerIndex, const TMakeFailure& makeResult, const string& reason)
+        {
+            WorkerProcess& worker = workers[workerIndex];
+            TestResults failure = makeResult(worker.currentTask, reason);
+            failure.executionTimeNanos = chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - worker.taskStartTime).count();
+            failure.executionTimeMillis = failure.executionTimeNanos / 1000000;
+
+            onResult(worker.currentTask, move(failure));
+            worker.currentTask = noTask;
+            nInFlight--;
+        };
+
+        auto dispatch = [&](size_t workerIndex)
+        {
+            WorkerProcess& worker = workers[workerIndex];
+            const uint64_t taskIndex = taskOrder[nextTask++];
+
+            worker.currentTask = static_cast<size_t>(taskIndex);
+            worker.taskStartTime = chrono::steady_clock::now();
+            worker.timeoutMillis = getTimeoutMillis? getTimeoutMillis(worker.currentTask) : 0;
+            nInFlight++;
+
+            if(!WriteAll(worker.taskFd, reinterpret_cast<const char*>(&taskIndex), sizeof(taskIndex)))
+            {
+                //The child died between tasks, the task itself never started
+                workerSet.Reap(workerIndex);
+                workerSet.Spawn(workerIndex);
+                nextTask--;
+                nInFlight--;
+            }
+        };
+
+        string message;
+        vector<pollfd> pollFds;
+        vector<size_t> pollWorkers;
+        while(nextTask < taskOrder.size() || nInFlight > 0)
+        {
+            if(isCancelled && isCancelled())
+            {
+                //Idle workers are reaped (and see EOF) once the WorkerSet goes out of scope
+                for(WorkerProcess& worker: workers)
+                {
+                    if(worker.currentTask != noTask) kill(worker.pid, SIGKILL);
+                }
+                break;
+            }
+
+            for(size_t i = 0; i < workers.size() && nextTask < taskOrder.size(); i++)
+            {
+                if(workers[i].currentTask == noTask) dispatch(i);
+            }
+
+            pollFds.clear();
+            pollWorkers.clear();
+            for(size_t i = 0; i < workers.size(); i++)
+            {
+                if(workers[i].currentTask == noTask) continue;
+                pollFds.push_back(pollfd{workers[i].resultFd, POLLIN, 0});
+                pollWorkers.push_back(i);
+            }
+            if(pollFds.empty()) continue;
+
+            //Wake up in time for the earliest deadline of any running task
+            int pollTimeoutMillis = -1;
+            const auto now = chrono::steady_clock::now();
+            for(const size_t workerIndex: pollWorkers)
+            {
+                const WorkerProcess& worker = workers[workerIndex];
+                if(worker.timeoutMillis <= 0) continue;
+
+                const int64_t remainingMillis = worker.timeoutMillis - 
+                    chrono::duration_cast<chrono::milliseconds>(now - worker.taskStartTime).count();
+                const int clampedMillis = static_cast<int>(min<int64_t>(max<int64_t>(remainingMillis, 0), INT32_MAX));
+                if(pollTimeoutMillis < 0 || clampedMillis < pollTimeoutMillis) pollTimeoutMillis = clampedMillis;
+            }
+
+            if(poll(pollFds.data(), pollFds.size(), pollTimeoutMillis) < 0)
+            {
+                if(errno == EINTR) continue;
+                throw runtime_error("failed to poll test worker processes");
+            }
+
+            for(size_t p = 0; p < pollFds.size(); p++)
+            {
+                if(pollFds[p].revents == 0) continue;
+                const size_t workerIndex = pollWorkers[p];
+                WorkerProcess& worker = workers[workerIndex];
+
+                uint32_t payloadSize = 0;
+                bool received = ReadAll(worker.resultFd, reinterpret_cast<char*>(&payloadSize), sizeof(payloadSize));
+                if(received)
+                {
+                    message.resize(payloadSize);
+                    received = payloadSize == 0 || ReadAll(worker.resultFd, &message[0], payloadSize);
+                }
+
+                if(!received)
+                {
+                    recordFailure(workerIndex, makeFailure, workerSet.Reap(workerIndex));
+                    workerSet.Spawn(workerIndex);
+                    continue;
+                }
+
+                onResult(worker.currentTask, DeserializeTestResults(message.data(), message.size()));
+                worker.currentTask = noTask;
+                nInFlight--;
+            }
+
+            //Results which arrived in time have been taken above, whatever is still running past its deadline is abandoned
+            const auto pollEndTime = chrono::steady_clock::now();
+            for(const size_t workerIndex: pollWorkers)
+            {
+                WorkerProcess& worker = workers[workerIndex];
+                if(worker.currentTask == noTask || worker.timeoutMillis <= 0) continue;
+
+                const int64_t elapsedMillis = chrono::duration_cast<chrono::milliseconds>(pollEndTime - worker.taskStartTime).count();
+                if(elapsedMillis < worker.timeoutMillis) continue;
+
+                kill(worker.pid, SIGKILL);
+                workerSet.Reap(workerIndex);
+                recordFailure(
+                    workerIndex,
+                    makeTimeout? makeTimeout : makeFailure,
+                    "Killed after running for " + to_string(elapsedMillis) + " ms, exceeding its " + to_string(worker.timeoutMillis) + " ms timeout"
+                );
+                workerSet.Spawn(workerIndex);
+            }
+        }
+    }
+#else
+    void ForkedWorkerPool::Run(
+        const vector<size_t>&,
+        const TRunTask&,
+        const TMakeFailure&,
+        const TOnResult&,
+        const TGetTimeout&,
+        const TMakeFailure&,
+        const TIsCancelled&)
+    {
+        throw runtime_error("process isolation requires fork(), which is not available on this platform");
+    }
+#endif
+#pragma endregion
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "CTest.h"
+
+namespace CTest
+{
+    using namespace std;
+
+    //Runs tasks in a pool of forked child processes (POSIX only).
+    //Each child receives task indices over a pipe, runs them in its own address space
+    //and sends the resulting TestResults back to the parent in a compact binary form.
+    //A child that dies mid-task is reported through makeFailure() and replaced by a fresh child,
+    //so the remaining tasks still run. A child which overruns its task's timeout is killed,
+    //reported through makeTimeout() and replaced the same way.
+    //Once isCancelled() returns true no further tasks are started, and the workers still running a task
+    //are killed without reporting a result.
+    class ForkedWorkerPool
+    {
+        size_t nWorkers;
+
+    public:
+        using TRunTask = function<TestResults(size_t taskIndex)>;
+        using TMakeFailure = function<TestResults(size_t taskIndex, const string& reason)>;
+        using TOnResult = function<void(size_t taskIndex, TestResults&& result)>;
+        using TGetTimeout = function<int64_t(size_t taskIndex)>; //Milliseconds, 0 for no limit
+        using TIsCancelled = function<bool()>;
+
+        ForkedWorkerPool(size_t nWorkers);
+
+        static bool IsSupported();
+
+        //runTask is only ever invoked inside a child process, onResult and makeFailure only in the parent.
+        //Throws runtime_error if the platform cannot fork or the pipes/children cannot be created.
+        void Run(
+            const vector<size_t>& taskOrder,
+            const TRunTask& runTask,
+            const TMakeFailure& makeFailure,
+            const TOnResult& onResult,
+            const TGetTimeout& getTimeoutMillis = nullptr,
+            const TMakeFailure& makeTimeout = nullptr,
+            const TIsCancelled& isCancelled = nullptr);
+    };
+
+    void SerializeTestResults(const TestResults& results, string& buffer);
+    TestResults DeserializeTestResults(const char* data, size_t size);
+}
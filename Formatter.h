@@ -1,13 +1,247 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
-#include <vector>
+#include <type_traits>
 
 #include "StringConverter.h"
 
 
 namespace CTest
 {
+    //Appends a single %t argument straight into the output buffer.
+    //bool, integers and string-likes are handled without intermediate strings,
+    //everything else goes through StrConverter::str_converter
+    namespace FormatAppend
+    {
+        struct BoolArgument {};
+        struct SignedArgument {};
+        struct UnsignedArgument {};
+        struct CStringArgument {};
+        struct StdStringArgument {};
+        struct ConvertedArgument {};
+
+        template<typename T>
+        using ArgumentKind =
+            std::conditional_t<std::is_same<T, bool>::value, BoolArgument,
+            std::conditional_t<std::is_integral<T>::value && std::is_signed<T>::value, SignedArgument,
+            std::conditional_t<std::is_integral<T>::value, UnsignedArgument,
+            std::conditional_t<std::is_same<T, const char*>::value || std::is_same<T, char*>::value, CStringArgument,
+            std::conditional_t<std::is_same<T, std::string>::value, StdStringArgument,
+            ConvertedArgument>>>>>;
+
+        //Writes 2 digits per step from a "00010203...99" table, right to left
+        inline void AppendUnsigned(std::string& out, unsigned long long value)
+        {
+            static const char digitPairs[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+
+            char buffer[20];
+            char* const end = buffer + sizeof(buffer);
+            char* begin = end;
+            while(value >= 100)
+            {
+                const size_t pair = static_cast<size_t>(value % 100) * 2;
+                value /= 100;
+                *--begin = digitPairs[pair + 1];
+                *--begin = digitPairs[pair];
+            }
+            if(value >= 10)
+            {
+                const size_t pair = static_cast<size_t>(value) * 2;
+                *--begin = digitPairs[pair + 1];
+                *--begin = digitPairs[pair];
+            }
+            else
+            {
+                *--begin = static_cast<char>('0' + value);
+            }
+            out.append(begin, end);
+        }
+
+        inline void AppendSigned(std::string& out, long long value)
+        {
+            if(value < 0)
+            {
+                out.push_back('-');
+                //Negate as unsigned, -LLONG_MIN does not fit into a long long
+                AppendUnsigned(out, 0ULL - static_cast<unsigned long long>(value));
+            }
+            else
+            {
+                AppendUnsigned(out, static_cast<unsigned long long>(value));
+            }
+        }
+
+        inline size_t CountDigits(unsigned long long value)
+        {
+            size_t nDigits = 1;
+            for(; value >= 10; value /= 10) nDigits++;
+            return nDigits;
+        }
+
+        template<typename T>
+        void AppendValue(std::string& out, const T& value, BoolArgument) { out += value? "true" : "false"; }
+
+        template<typename T>
+        void AppendValue(std::string& out, const T& value, SignedArgument) { AppendSigned(out, value); }
+
+        template<typename T>
+        void AppendValue(std::string& out, const T& value, UnsignedArgument) { AppendUnsigned(out, value); }
+
+        template<typename T>
+        void AppendValue(std::string& out, const char* value, CStringArgument) { out += value; }
+
+        template<typename T>
+        void AppendValue(std::string& out, const std::string& value, StdStringArgument) { out += value; }
+
+        template<typename T>
+        void AppendValue(std::string& out, const T& value, ConvertedArgument)
+        {
+            out += StrConverter::str_converter<T>::get(value);
+        }
+
+        template<typename T>
+        void AppendValue(std::string& out, const T& value)
+        {
+            using TValue = std::decay_t<T>;
+            AppendValue<TValue>(out, value, ArgumentKind<TValue>{});
+        }
+
+        //Exact number of characters AppendValue() will write where that is cheap to
+        //work out, 0 for types that need a conversion first
+        template<typename T>
+        size_t LengthHint(const T& value, BoolArgument) { return value? 4 : 5; }
+
+        template<typename T>
+        size_t LengthHint(const T& value, SignedArgument)
+        {
+            const long long signedValue = value;
+            return signedValue < 0?
+                1 + CountDigits(0ULL - static_cast<unsigned long long>(signedValue)) :
+                CountDigits(static_cast<unsigned long long>(signedValue));
+        }
+
+        template<typename T>
+        size_t LengthHint(const T& value, UnsignedArgument) { return CountDigits(value); }
+
+        template<typename T>
+        size_t LengthHint(const char* value, CStringArgument) { return std::char_traits<char>::length(value); }
+
+        template<typename T>
+        size_t LengthHint(const std::string& value, StdStringArgument) { return value.size(); }
+
+        template<typename T>
+        size_t LengthHint(const T&, ConvertedArgument) { return 0; }
+
+        template<typename T>
+        size_t LengthHint(const T& value)
+        {
+            using TValue = std::decay_t<T>;
+            return LengthHint<TValue>(value, ArgumentKind<TValue>{});
+        }
+
+        //Type-erased argument, lets the runtime parser live outside of the variadic template
+        struct FormatArgument
+        {
+            const void* value;
+            void (*append)(std::string& out, const void* value);
+        };
+
+        template<typename T>
+        FormatArgument MakeFormatArgument(const T& value)
+        {
+            return FormatArgument{
+                &value,
+                [](std::string& out, const void* erasedValue)
+                {
+                    AppendValue(out, *static_cast<const T*>(erasedValue));
+                }
+            };
+        }
+
+        inline void AppendFormatted(
+            std::string& out,
+            const char* format,
+            size_t formatLength,
+            const FormatArgument* arguments,
+            size_t nArguments)
+        {
+            size_t currentTokenIndex = 0;
+            size_t i = 0;
+            while(i < formatLength)
+            {
+                //Bulk copy everything up to the next %
+                const void* percent = std::char_traits<char>::find(format + i, formatLength - i, '%');
+                const size_t literalEnd = percent != nullptr?
+                    static_cast<size_t>(static_cast<const char*>(percent) - format) :
+                    formatLength;
+                out.append(format + i, literalEnd - i);
+                if(literalEnd == formatLength) break;
+
+                const size_t nextIdx = literalEnd + 1;
+                const char nextChar = nextIdx < formatLength? format[nextIdx] : '\0';
+                if(nextChar == '%')
+                {
+                    out.push_back('%');
+                    i = nextIdx + 1;
+                }
+                else if(nextChar == 't')
+                {
+                    if(currentTokenIndex < nArguments)
+                    {
+                        const FormatArgument& argument = arguments[currentTokenIndex];
+                        argument.append(out, argument.value);
+                        currentTokenIndex++;
+                    }
+                    else
+                    {
+                        out += "[missing token]";
+                    }
+                    i = nextIdx + 1;
+                }
+                else
+                {
+                    out += "[t or % expected after %]";
+                    i = nextIdx;
+                }
+            }
+        }
+    }
+
+    //Appends the formatted output to 'out' instead of returning a new string,
+    //reusing one buffer across calls avoids any per-call allocations
+    template<typename ...TArgs>
+    void cfmt_to(std::string& out, const char* format, TArgs&&... args)
+    {
+        using namespace FormatAppend;
+        const FormatArgument arguments[sizeof...(TArgs) + 1] = {
+            MakeFormatArgument(args)...,
+            FormatArgument{nullptr, nullptr}
+        };
+        AppendFormatted(out, format, std::char_traits<char>::length(format), arguments, sizeof...(TArgs));
+    }
+
+    template<typename ...TArgs>
+    void cfmt_to(std::string& out, const std::string& format, TArgs&&... args)
+    {
+        using namespace FormatAppend;
+        const FormatArgument arguments[sizeof...(TArgs) + 1] = {
+            MakeFormatArgument(args)...,
+            FormatArgument{nullptr, nullptr}
+        };
+        AppendFormatted(out, format.data(), format.size(), arguments, sizeof...(TArgs));
+    }
+
     //Like printf, but using %t to represent placeholders instead
     //i.e. tfmt("%t bottles of %t on the wall, take %t down, %t to go", 99, "beer" 1, 98)
     //The type provided in the argument list must either be a type that
@@ -17,56 +251,200 @@ namespace CTest
     template<typename ...TArgs>
     std::string cfmt(const std::string& format, TArgs&&... args)
     {
-        std::vector<std::string> tokens = {
-            (StrConverter::str_converter<TArgs>::get(args))...
-        };
-
-        size_t currentTokenIndex = 0;
         std::string output;
-        for(size_t i = 0; i < format.size(); i++)
+        cfmt_to(output, format, std::forward<TArgs>(args)...);
+        return output;
+    }
+
+    //Compile-time parsing support for CFMT(), C++14 constexpr so everything below
+    //is evaluated by the compiler for string literal format strings
+    namespace FormatParsing
+    {
+        constexpr size_t npos = static_cast<size_t>(-1);
+
+        //Number of %t tokens, or npos if a % is followed by anything other than t or %
+        constexpr size_t CountSlots(const char* format)
         {
-            const char current = format.at(i); 
-            if(current != '%')
+            size_t nSlots = 0;
+            for(size_t i = 0; format[i] != '\0'; i++)
             {
-                output.push_back(current);
+                if(format[i] != '%') continue;
+
+                const char next = format[i + 1];
+                if(next == 't') nSlots++;
+                else if(next != '%') return npos;
+                i++;
             }
-            else
+            return nSlots;
+        }
+
+        //Each %t is a piece of its own, literal text is split after the first % of every %%
+        constexpr size_t CountPieces(const char* format)
+        {
+            size_t nPieces = 0;
+            bool inLiteral = false;
+            for(size_t i = 0; format[i] != '\0'; i++)
             {
-                const size_t nextIdx = i + 1;
-                bool validTokenAfterPercent = false;
+                if(format[i] == '%' && format[i + 1] == 't')
+                {
+                    nPieces++;
+                    inLiteral = false;
+                    i++;
+                }
+                else if(format[i] == '%' && format[i + 1] == '%')
+                {
+                    if(!inLiteral) nPieces++;
+                    inLiteral = false;
+                    i++;
+                }
+                else
+                {
+                    if(!inLiteral) nPieces++;
+                    inLiteral = true;
+                }
+            }
+            return nPieces;
+        }
 
-                if(nextIdx < format.size())
+        template<size_t NPieces>
+        struct FormatPieces
+        {
+            //slot pieces have isSlot set and no text
+            size_t offset[NPieces];
+            size_t length[NPieces];
+            bool isSlot[NPieces];
+            size_t literalLength;
+
+            constexpr FormatPieces()
+            : offset{}
+            , length{}
+            , isSlot{}
+            , literalLength{0}
+            {}
+        };
+
+        template<size_t NPieces>
+        constexpr FormatPieces<NPieces> ParsePieces(const char* format)
+        {
+            FormatPieces<NPieces> pieces;
+            size_t current = 0;
+            bool inLiteral = false;
+
+            for(size_t i = 0; format[i] != '\0'; i++)
+            {
+                if(format[i] == '%' && format[i + 1] == 't')
                 {
-                    const char nextChar = format.at(nextIdx);
-                    if(nextChar == '%')
-                    {
-                        i++;
-                        validTokenAfterPercent = true;
-                        output.push_back('%');        
-                    }
-                    else if(nextChar == 't')
-                    {
-                        i++;
-                        validTokenAfterPercent = true; 
-                        
-                        if(currentTokenIndex < tokens.size())
-                        {
-                            output += tokens.at(currentTokenIndex);
-                            currentTokenIndex++;
-                        }
-                        else
-                        {
-                            output += "[missing token]";
-                        }
-                    }
+                    pieces.isSlot[current++] = true;
+                    inLiteral = false;
+                    i++;
+                    continue;
+                }
+
+                if(!inLiteral)
+                {
+                    pieces.offset[current++] = i;
                 }
+                pieces.length[current - 1]++;
+                pieces.literalLength++;
 
-                if(!validTokenAfterPercent)
+                if(format[i] == '%')
                 {
-                    output += "[t or % expected after %]"; 
+                    //Keep the first % of %%, then start a fresh piece after the second
+                    inLiteral = false;
+                    i++;
+                }
+                else
+                {
+                    inLiteral = true;
                 }
             }
+            return pieces;
         }
-        return output;
+
+        //Holds a dummy element so that formats without any %t do not need a zero-sized array
+        template<size_t NPieces>
+        struct PieceStorage
+        {
+            using type = FormatPieces<NPieces>;
+        };
+
+        template<>
+        struct PieceStorage<0>
+        {
+            using type = FormatPieces<1>;
+        };
     }
-}
\ No newline at end of file
+
+    //Format string parsed at compile time, created by the CFMT() macro.
+    //TLiteral supplies the format string via a constexpr static Get() function.
+    template<typename TLiteral>
+    class CompiledFormat
+    {
+        static constexpr size_t nSlots = FormatParsing::CountSlots(TLiteral::Get());
+        static_assert(nSlots != FormatParsing::npos, "CFMT: % must be followed by t or another %");
+
+        static constexpr size_t nPieces = FormatParsing::CountPieces(TLiteral::Get());
+        using TPieces = typename FormatParsing::PieceStorage<nPieces>::type;
+        static constexpr TPieces pieces = FormatParsing::ParsePieces<(nPieces > 0? nPieces : 1)>(TLiteral::Get());
+
+    public:
+        template<typename ...TArgs>
+        void AppendTo(std::string& out, TArgs&&... args) const
+        {
+            static_assert(sizeof...(TArgs) == nSlots, "CFMT: number of arguments does not match the number of %t tokens");
+
+            using namespace FormatAppend;
+            const FormatArgument arguments[sizeof...(TArgs) + 1] = {
+                MakeFormatArgument(args)...,
+                FormatArgument{nullptr, nullptr}
+            };
+            const size_t lengthHints[sizeof...(TArgs) + 1] = { LengthHint(args)..., 0 };
+
+            size_t outputLength = out.size() + pieces.literalLength;
+            for(const size_t lengthHint: lengthHints) outputLength += lengthHint;
+            if(outputLength > out.capacity()) out.reserve(outputLength);
+
+            const char* format = TLiteral::Get();
+            size_t currentToken = 0;
+            for(size_t i = 0; i < nPieces; i++)
+            {
+                if(pieces.isSlot[i])
+                {
+                    const FormatArgument& argument = arguments[currentToken++];
+                    argument.append(out, argument.value);
+                }
+                else
+                {
+                    out.append(format + pieces.offset[i], pieces.length[i]);
+                }
+            }
+        }
+
+        template<typename ...TArgs>
+        std::string operator()(TArgs&&... args) const
+        {
+            std::string output;
+            AppendTo(output, std::forward<TArgs>(args)...);
+            return output;
+        }
+    };
+
+    template<typename TLiteral>
+    constexpr typename CompiledFormat<TLiteral>::TPieces CompiledFormat<TLiteral>::pieces;
+
+    //i.e. cfmt_to(line, CFMT("%t/%t"), nPassed, nTotal)
+    template<typename TLiteral, typename ...TArgs>
+    void cfmt_to(std::string& out, const CompiledFormat<TLiteral>& format, TArgs&&... args)
+    {
+        format.AppendTo(out, std::forward<TArgs>(args)...);
+    }
+}
+
+//Like cfmt(), but the format string literal is parsed at compile time.
+//Malformed formats and a wrong number of arguments are compile errors.
+//i.e. CFMT("%t bottles of %t")(99, "beer")
+#define CFMT(LPSTR_FORMAT) \
+    ([]{ \
+        struct FormatLiteral { static constexpr const char* Get() { return LPSTR_FORMAT; } }; \
+        return CTest::CompiledFormat<FormatLiteral>{}; \
+    }())
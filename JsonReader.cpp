@@ -0,0 +1,334 @@
+#include "JsonReader.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+JsonParseError::JsonParseError(const string& message, size_t _offset)
+: runtime_error{message + " at offset " + to_string(_offset)}
+, offset{_offset}
+{}
+
+JsonReader::JsonReader(char* _text, size_t _size)
+: text{_text}
+, size{_size}
+{}
+
+void JsonReader::Fail(const char* message) const
+{
+    throw JsonParseError(message, position);
+}
+
+void JsonReader::SkipWhitespace()
+{
+    while(position < size)
+    {
+        const char c = text[position];
+        if(c != ' ' && c != '\n' && c != '\r' && c != '\t') return;
+        position++;
+    }
+}
+
+JsonToken JsonReader::Next()
+{
+    SkipWhitespace();
+
+    if(afterKey)
+    {
+        if(position == size || text[position] != ':') Fail("expected ':' after object key");
+        position++;
+        afterKey = false;
+        SkipWhitespace();
+        return ReadValue();
+    }
+
+    if(containers.empty())
+    {
+        if(position == size) return JsonToken::End;
+        return ReadValue();
+    }
+
+    const bool inObject = containers.back() == '{';
+    if(position == size) Fail(inObject? "unterminated object" : "unterminated array");
+
+    //Checked before the separator, so a trailing comma is rejected
+    if(text[position] == (inObject? '}' : ']'))
+    {
+        position++;
+        containers.pop_back();
+        firstInContainer = false;
+        return inObject? JsonToken::EndObject : JsonToken::EndArray;
+    }
+
+    if(!firstInContainer)
+    {
+        if(text[position] != ',') Fail(inObject? "expected ',' or '}'" : "expected ',' or ']'");
+        position++;
+        SkipWhitespace();
+    }
+    firstInContainer = false;
+
+    if(!inObject) return ReadValue();
+
+    if(position == size || text[position] != '"') Fail("expected object key");
+    ReadString();
+    afterKey = true;
+    return JsonToken::Key;
+}
+
+void JsonReader::SkipValue()
+{
+    size_t depth = 0;
+    do
+    {
+        switch(Next())
+        {
+            case JsonToken::BeginObject:
+            case JsonToken::BeginArray:
+                depth++;
+                break;
+            case JsonToken::EndObject:
+            case JsonToken::EndArray:
+                if(depth == 0) Fail("no value to skip");
+                depth--;
+                break;
+            case JsonToken::End:
+                Fail("no value to skip");
+            default:
+                break;
+        }
+    } while(depth > 0);
+}
+
+JsonToken JsonReader::ReadValue()
+{
+    if(position == size) Fail("expected a value");
+
+    firstInContainer = false;
+    switch(text[position])
+    {
+        case '{':
+            position++;
+            containers.push_back('{');
+            firstInContainer = true;
+            return JsonToken::BeginObject;
+        case '[':
+            position++;
+            containers.push_back('[');
+            firstInContainer = true;
+            return JsonToken::BeginArray;
+        case '"':
+            ReadString();
+            return JsonToken::String;
+        case 't':
+            ReadLiteral("true", 4);
+            boolValue = true;
+            return JsonToken::Boolean;
+        case 'f':
+            ReadLiteral("false", 5);
+            boolValue = false;
+            return JsonToken::Boolean;
+        case 'n':
+            ReadLiteral("null", 4);
+            return JsonToken::Null;
+        default:
+            return ReadNumber();
+    }
+}
+
+void JsonReader::ReadLiteral(const char* literal, size_t length)
+{
+    if(size - position < length || memcmp(text + position, literal, length) != 0) Fail("invalid literal");
+    position += length;
+}
+
+uint32_t JsonReader::ReadHexQuad()
+{
+    if(size - position < 4) Fail("truncated \\u escape");
+
+    uint32_t value = 0;
+    for(size_t i = 0; i < 4; i++)
+    {
+        const char c = text[position++];
+        value <<= 4;
+        if(c >= '0' && c <= '9') value |= static_cast<uint32_t>(c - '0');
+        else if(c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+        else if(c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+        else Fail("invalid \\u escape");
+    }
+    return value;
+}
+
+//Unescapes into the buffer, starting where the opening quote was.
+//The decoded string is never longer than its escaped form, so writing never overtakes reading.
+void JsonReader::ReadString()
+{
+    const size_t begin = ++position;
+
+    //Strings without escapes are the common case & stay where they are
+    while(position < size)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[position]);
+        if(c == '"' || c == '\\' || c < 0x20) break;
+        position++;
+    }
+    size_t written = position;
+
+    while(true)
+    {
+        if(position == size) Fail("unterminated string");
+
+        const unsigned char c = static_cast<unsigned char>(text[position]);
+        if(c == '"')
+        {
+            position++;
+            break;
+        }
+        if(c < 0x20) Fail("control character in string");
+        if(c != '\\')
+        {
+            text[written++] = text[position++];
+            continue;
+        }
+
+        if(++position == size) Fail("unterminated string");
+        const char escaped = text[position++];
+        switch(escaped)
+        {
+            case '"':  text[written++] = '"';  break;
+            case '\\': text[written++] = '\\'; break;
+            case '/':  text[written++] = '/';  break;
+            case 'b':  text[written++] = '\b'; break;
+            case 'f':  text[written++] = '\f'; break;
+            case 'n':  text[written++] = '\n'; break;
+            case 'r':  text[written++] = '\r'; break;
+            case 't':  text[written++] = '\t'; break;
+            case 'u':
+            {
+                uint32_t codePoint = ReadHexQuad();
+                if(codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    //Surrogate pair, a lone half becomes U+FFFD like invalid UTF-8 does in the writer
+                    if(size - position >= 6 && text[position] == '\\' && text[position + 1] == 'u')
+                    {
+                        const size_t lowStart = position;
+                        position += 2;
+                        const uint32_t low = ReadHexQuad();
+                        if(low >= 0xDC00 && low <= 0xDFFF)
+                        {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        else
+                        {
+                            position = lowStart;
+                            codePoint = 0xFFFD;
+                        }
+                    }
+                    else
+                    {
+                        codePoint = 0xFFFD;
+                    }
+                }
+                else if(codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+                {
+                    codePoint = 0xFFFD;
+                }
+
+                //At most 4 bytes out for the 6 (or 12) read
+                if(codePoint < 0x80)
+                {
+                    text[written++] = static_cast<char>(codePoint);
+                }
+                else if(codePoint < 0x800)
+                {
+                    text[written++] = static_cast<char>(0xC0 | (codePoint >> 6));
+                    text[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                }
+                else if(codePoint < 0x10000)
+                {
+                    text[written++] = static_cast<char>(0xE0 | (codePoint >> 12));
+                    text[written++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                    text[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                }
+                else
+                {
+                    text[written++] = static_cast<char>(0xF0 | (codePoint >> 18));
+                    text[written++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                    text[written++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                    text[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                }
+                break;
+            }
+            default:
+                position--;
+                Fail("invalid escape");
+        }
+    }
+
+    stringValue = JsonStringRef(text + begin, written - begin);
+}
+
+JsonToken JsonReader::ReadNumber()
+{
+    const size_t begin = position;
+    bool isInteger = true;
+
+    auto skipDigits = [this]()
+    {
+        const size_t start = position;
+        while(position < size && text[position] >= '0' && text[position] <= '9') position++;
+        return position - start;
+    };
+
+    if(text[position] == '-') position++;
+    if(position < size && text[position] == '0')
+    {
+        position++;
+    }
+    else if(skipDigits() == 0)
+    {
+        position = begin;
+        Fail("expected a value");
+    }
+
+    if(position < size && text[position] == '.')
+    {
+        position++;
+        isInteger = false;
+        if(skipDigits() == 0) Fail("expected digits after '.'");
+    }
+    if(position < size && (text[position] == 'e' || text[position] == 'E'))
+    {
+        position++;
+        isInteger = false;
+        if(position < size && (text[position] == '+' || text[position] == '-')) position++;
+        if(skipDigits() == 0) Fail("expected exponent digits");
+    }
+
+    //The buffer is not null-terminated, strtoll & strtod get a copy
+    char digits[64];
+    const size_t length = position - begin;
+    if(length >= sizeof(digits))
+    {
+        position = begin;
+        Fail("number too long");
+    }
+    memcpy(digits, text + begin, length);
+    digits[length] = '\0';
+
+    if(isInteger)
+    {
+        errno = 0;
+        const long long value = strtoll(digits, nullptr, 10);
+        if(errno != ERANGE)
+        {
+            integerValue = value;
+            doubleValue = static_cast<double>(value);
+            return JsonToken::Integer;
+        }
+    }
+
+    doubleValue = strtod(digits, nullptr);
+    return JsonToken::Double;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "JsonWriter.h"
+
+//Counterpart to the writer, for reading the reports back.
+//Single pass pull parser working in place: strings are unescaped inside the caller's buffer and handed out
+//as JsonStringRef, so reading a document never copies a string or builds a tree. Containers are tracked
+//on an explicit stack instead of by recursion, deeply nested input cannot overflow the call stack.
+//The buffer may hold several top-level values one after another, i.e. JSON Lines.
+//Bytes above 0x7F are passed through without checking they are valid UTF-8.
+
+enum class JsonToken
+{
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    Key,
+    String,
+    Integer,
+    Double,     //Also integers too large for int64_t
+    Boolean,
+    Null,
+    End         //Nothing but whitespace left
+};
+
+class JsonParseError : public std::runtime_error
+{
+    size_t offset;
+public:
+    JsonParseError(const std::string& message, size_t offset);
+
+    //Position in the buffer where parsing stopped
+    size_t GetOffset() const { return offset; }
+};
+
+class JsonReader
+{
+    char* text;
+    size_t size;
+    size_t position = 0;
+    std::vector<char> containers;   //'{' or '[' per open container
+    bool firstInContainer = false;
+    bool afterKey = false;
+
+    JsonStringRef stringValue{"", 0};
+    int64_t integerValue = 0;
+    double doubleValue = 0.0;
+    bool boolValue = false;
+
+    [[noreturn]] void Fail(const char* message) const;
+    void SkipWhitespace();
+    JsonToken ReadValue();
+    void ReadString();
+    JsonToken ReadNumber();
+    void ReadLiteral(const char* literal, size_t length);
+    uint32_t ReadHexQuad();
+public:
+    //The buffer is modified while reading & has to outlive every string handed out
+    JsonReader(char* text, size_t size);
+
+    //Throws JsonParseError on malformed input
+    JsonToken Next();
+
+    //Reads the value following a Key (or the next element of an array) without returning it,
+    //containers are skipped as a whole
+    void SkipValue();
+
+    //Valid after a Key or String token, until the buffer is modified
+    JsonStringRef GetString() const { return stringValue; }
+    int64_t GetInteger() const { return integerValue; }
+    //Also valid after an Integer token
+    double GetDouble() const { return doubleValue; }
+    bool GetBool() const { return boolValue; }
+
+    size_t GetDepth() const { return containers.size(); }
+    size_t GetOffset() const { return position; }
+};
@@ -1,7 +1,20 @@
 #include <assert.h>
 #include "jsonWriter.h"
-#include <map>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CANARY_JSON_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define CANARY_JSON_SSE2 0
+#endif
 
 using namespace std; 
 
@@ -23,98 +36,476 @@ string StrJoin(const vector<string>& strings, const string& delimiter)
 }
 
 
-string EscapeJsonString(const string& str)
+#pragma region Escaping
+namespace
 {
-    const static map<char, string> escapeChars{
-        {'"', R"_(\")_"},
-        {'\\',R"_(\\)_"},
-        {'/',R"_(\/)_"},
-        {'\b',R"_(\b)_"},
-        {'\f',R"_(\f)_"},
-        {'\n',R"_(\n)_"},
-        {'\r',R"_(\r)_"},
-        {'\t',R"_(\t)_"}
-        //\u sequence completely ignored.
+    //Character written after the backslash for every byte value, 0 if the byte is copied as is.
+    //'u' marks control characters written as \u00XX
+    struct EscapeTable
+    {
+        char escapeAs[256];
+
+        constexpr EscapeTable()
+        : escapeAs{}
+        {
+            for(int c = 0; c < 0x20; c++) escapeAs[c] = 'u';
+            escapeAs[static_cast<unsigned char>('"')] = '"';
+            escapeAs[static_cast<unsigned char>('\\')] = '\\';
+            escapeAs[static_cast<unsigned char>('/')] = '/';
+            escapeAs[static_cast<unsigned char>('\b')] = 'b';
+            escapeAs[static_cast<unsigned char>('\f')] = 'f';
+            escapeAs[static_cast<unsigned char>('\n')] = 'n';
+            escapeAs[static_cast<unsigned char>('\r')] = 'r';
+            escapeAs[static_cast<unsigned char>('\t')] = 't';
+        }
     };
 
-    string escaped;
-    for(const char c: str)
+    constexpr EscapeTable escapeTable;
+
+#if CANARY_JSON_SSE2
+    int CountTrailingZeros(unsigned int mask)
     {
-        if(escapeChars.count(c) == 0)
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+#endif
+
+    //Index of the first byte at or after 'start' which cannot be copied verbatim
+    size_t FindNextSpecialByte(const unsigned char* data, size_t start, size_t size, bool stopAtNonAscii)
+    {
+        size_t i = start;
+#if CANARY_JSON_SSE2
+        //16 bytes at a time, most report strings have no escapes at all
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i slash = _mm_set1_epi8('/');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+        for(; i + 16 <= size; i += 16)
         {
-            //non-escaped character
-            escaped.push_back(c);
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, slash));
+            //unsigned chunk <= 0x1F
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+
+            unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(special));
+            if(stopAtNonAscii) mask |= static_cast<unsigned int>(_mm_movemask_epi8(chunk));
+            if(mask != 0) return i + static_cast<size_t>(CountTrailingZeros(mask));
         }
-        else
+#endif
+        for(; i < size; i++)
         {
-            escaped += escapeChars.at(c);
+            if(escapeTable.escapeAs[data[i]] != 0) return i;
+            if(stopAtNonAscii && data[i] >= 0x80) return i;
         }
+        return size;
+    }
+
+    //Length of the well-formed UTF-8 sequence starting at 'data', 0 if it is malformed.
+    //Overlong encodings, surrogates and code points above U+10FFFF are rejected.
+    size_t ValidUtf8SequenceLength(const unsigned char* data, size_t remaining)
+    {
+        const unsigned char lead = data[0];
+        size_t length = 0;
+        unsigned char minSecond = 0x80;
+        unsigned char maxSecond = 0xBF;
+
+        if(lead >= 0xC2 && lead <= 0xDF) length = 2;
+        else if(lead == 0xE0) { length = 3; minSecond = 0xA0; }
+        else if(lead == 0xED) { length = 3; maxSecond = 0x9F; }
+        else if(lead >= 0xE1 && lead <= 0xEF) length = 3;
+        else if(lead == 0xF0) { length = 4; minSecond = 0x90; }
+        else if(lead >= 0xF1 && lead <= 0xF3) length = 4;
+        else if(lead == 0xF4) { length = 4; maxSecond = 0x8F; }
+        else return 0;
+
+        if(remaining < length) return 0;
+        if(data[1] < minSecond || data[1] > maxSecond) return 0;
+        for(size_t i = 2; i < length; i++)
+        {
+            if((data[i] & 0xC0) != 0x80) return 0;
+        }
+        return length;
     }
-    return escaped;
 }
 
-#pragma region Boolean
- std::string JsonBoolean::serialize() 
- {
-    return value? "true": "false";
- }
-#pragma endregion
+void AppendEscapedJsonString(string& output, const char* str, size_t size, Utf8Handling utf8)
+{
+    static const char hexDigits[] = "0123456789abcdef";
 
-#pragma region Integer
- std::string JsonInteger::serialize() 
- {
-    return to_string(value);
- }
-#pragma endregion
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(str);
+    const bool validateUtf8 = utf8 == Utf8Handling::ReplaceInvalid;
+
+    size_t i = 0;
+    while(true)
+    {
+        //Bulk copy the run of bytes that need no escaping
+        const size_t next = FindNextSpecialByte(data, i, size, validateUtf8);
+        output.append(str + i, next - i);
+        if(next == size) return;
+
+        const unsigned char c = data[next];
+        if(c >= 0x80)
+        {
+            const size_t length = ValidUtf8SequenceLength(data + next, size - next);
+            if(length == 0)
+            {
+                output += "\\ufffd";
+                i = next + 1;
+            }
+            else
+            {
+                output.append(str + next, length);
+                i = next + length;
+            }
+            continue;
+        }
+
+        const char escapeAs = escapeTable.escapeAs[c];
+        output.push_back('\\');
+        output.push_back(escapeAs);
+        if(escapeAs == 'u')
+        {
+            output.push_back('0');
+            output.push_back('0');
+            output.push_back(hexDigits[c >> 4]);
+            output.push_back(hexDigits[c & 0xF]);
+        }
+        i = next + 1;
+    }
+}
+
+void AppendEscapedJsonString(string& output, const string& str, Utf8Handling utf8)
+{
+    AppendEscapedJsonString(output, str.data(), str.size(), utf8);
+}
 
-#pragma region String
-std::string JsonString::serialize()
+string EscapeJsonString(const string& str, Utf8Handling utf8)
 {
-    return "\"" + EscapeJsonString(value) + "\"";
+    string escaped;
+    AppendEscapedJsonString(escaped, str, utf8);
+    return escaped;
 }
 #pragma endregion
 
-#pragma region JsonArray
-std::string JsonArray::serialize()
+#pragma region Serialization
+namespace
 {
-    vector<string> elements;
-    for(unique_ptr<JsonNode>& pNode: values)
+    //Output buffer which is optionally drained into a stream
+    //whenever it grows past flushThreshold
+    class JsonSink
     {
-        assert(pNode != nullptr);
-        elements.emplace_back(pNode->serialize());
+        string& buffer;
+        ostream* stream;
+        static constexpr size_t flushThreshold = 64 * 1024;
+    public:
+        JsonSink(string& _buffer, ostream* _stream)
+        : buffer{_buffer}
+        , stream{_stream}
+        {}
+
+        string& Buffer() { return buffer; }
+
+        void Put(char c) { buffer.push_back(c); }
+        void Put(const char* text) { buffer.append(text); }
+
+        void Checkpoint()
+        {
+            if(stream != nullptr && buffer.size() >= flushThreshold) Flush();
+        }
+
+        void Flush()
+        {
+            if(stream == nullptr) return;
+            stream->write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    };
+
+    void AppendInteger(string& output, int64_t value)
+    {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* current = end;
+
+        //Work with the magnitude as unsigned so that INT64_MIN does not overflow
+        uint64_t magnitude = value < 0? 
+            0ULL - static_cast<uint64_t>(value) : 
+            static_cast<uint64_t>(value);
+        do
+        {
+            *--current = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while(magnitude != 0);
+
+        if(value < 0) *--current = '-';
+        output.append(current, end);
+    }
+
+    void AppendDouble(string& output, double value)
+    {
+        if(!isfinite(value))
+        {
+            output.push_back('0');
+            return;
+        }
+
+        char digits[32];
+        const int length = snprintf(digits, sizeof(digits), "%.15g", value);
+        output.append(digits, static_cast<size_t>(length));
     }
 
-    return "[" + StrJoin(elements, ",") + "]";
+    void WriteScalar(const JsonNode& node, JsonSink& sink)
+    {
+        switch(node.GetType())
+        {
+            case JsonType::Boolean:
+                sink.Put(static_cast<const JsonBoolean&>(node).GetValue()? "true" : "false");
+                break;
+            case JsonType::Integer:
+                AppendInteger(sink.Buffer(), static_cast<const JsonInteger&>(node).GetValue());
+                break;
+            case JsonType::Double:
+                AppendDouble(sink.Buffer(), static_cast<const JsonDouble&>(node).GetValue());
+                break;
+            case JsonType::String:
+                sink.Put('"');
+                AppendEscapedJsonString(sink.Buffer(), static_cast<const JsonString&>(node).GetValue());
+                sink.Put('"');
+                break;
+            default:
+                assert(false && "not a scalar node");
+        }
+    }
+
+    //Explicit stack instead of recursion so deeply nested trees cannot overflow the call stack
+    void WriteJson(const JsonNode& root, JsonSink& sink, JsonStyle style)
+    {
+        struct Frame
+        {
+            const JsonNode* container;
+            size_t nextChild;
+        };
+
+        const bool pretty = style == JsonStyle::Pretty;
+        vector<Frame> stack;
+        const JsonNode* pending = &root;
+
+        while(true)
+        {
+            if(pending != nullptr)
+            {
+                if(pending->GetType() == JsonType::Object)
+                {
+                    sink.Put(pretty? "{\n" : "{");
+                    stack.emplace_back(Frame{pending, 0});
+                }
+                else if(pending->GetType() == JsonType::Array)
+                {
+                    sink.Put('[');
+                    stack.emplace_back(Frame{pending, 0});
+                }
+                else
+                {
+                    WriteScalar(*pending, sink);
+                }
+                pending = nullptr;
+                sink.Checkpoint();
+            }
+
+            if(stack.empty()) break;
+
+            Frame& top = stack.back();
+            if(top.container->GetType() == JsonType::Object)
+            {
+                const vector<JsonKeyValue>& attributes = 
+                    static_cast<const JsonObject*>(top.container)->GetAttributes();
+
+                if(top.nextChild == attributes.size())
+                {
+                    sink.Put(pretty? "\n}" : "}");
+                    stack.pop_back();
+                    continue;
+                }
+
+                if(top.nextChild > 0) sink.Put(pretty? ",\n" : ",");
+                const JsonKeyValue& keyValue = attributes[top.nextChild++];
+                assert(keyValue.value != nullptr);
+
+                sink.Put('"');
+                AppendEscapedJsonString(sink.Buffer(), keyValue.key);
+                sink.Put("\":");
+                pending = keyValue.value.get();
+            }
+            else
+            {
+                const vector<unique_ptr<JsonNode>>& elements = 
+                    static_cast<const JsonArray*>(top.container)->GetElements();
+
+                if(top.nextChild == elements.size())
+                {
+                    sink.Put(']');
+                    stack.pop_back();
+                    continue;
+                }
+
+                if(top.nextChild > 0) sink.Put(',');
+                pending = elements[top.nextChild++].get();
+                assert(pending != nullptr);
+            }
+        }
+    }
+
+    void WriteScalar(const JsonDocument& document, JsonDocument::NodeId node, JsonSink& sink)
+    {
+        switch(document.GetType(node))
+        {
+            case JsonType::Boolean:
+                sink.Put(document.GetBool(node)? "true" : "false");
+                break;
+            case JsonType::Integer:
+                AppendInteger(sink.Buffer(), document.GetInteger(node));
+                break;
+            case JsonType::Double:
+                AppendDouble(sink.Buffer(), document.GetDouble(node));
+                break;
+            case JsonType::String:
+            {
+                const JsonStringRef value = document.GetString(node);
+                sink.Put('"');
+                AppendEscapedJsonString(sink.Buffer(), value.GetData(), value.GetSize());
+                sink.Put('"');
+                break;
+            }
+            default:
+                assert(false && "not a scalar node");
+        }
+    }
+
+    //Same output as the JsonNode version, following the sibling links instead of child vectors
+    void WriteJson(const JsonDocument& document, JsonSink& sink, JsonStyle style)
+    {
+        using NodeId = JsonDocument::NodeId;
+        struct Frame
+        {
+            NodeId container;
+            NodeId nextChild;
+            bool isObject;
+            bool first;
+        };
+
+        const bool pretty = style == JsonStyle::Pretty;
+        vector<Frame> stack;
+        NodeId pending = document.GetRoot();
+
+        while(true)
+        {
+            if(pending != JsonDocument::noNode)
+            {
+                const JsonType type = document.GetType(pending);
+                if(type == JsonType::Object || type == JsonType::Array)
+                {
+                    const bool isObject = type == JsonType::Object;
+                    if(isObject) sink.Put(pretty? "{\n" : "{");
+                    else sink.Put('[');
+                    stack.emplace_back(Frame{pending, document.GetFirstChild(pending), isObject, true});
+                }
+                else
+                {
+                    WriteScalar(document, pending, sink);
+                }
+                pending = JsonDocument::noNode;
+                sink.Checkpoint();
+            }
+
+            if(stack.empty()) break;
+
+            Frame& top = stack.back();
+            if(top.nextChild == JsonDocument::noNode)
+            {
+                if(top.isObject) sink.Put(pretty? "\n}" : "}");
+                else sink.Put(']');
+                stack.pop_back();
+                continue;
+            }
+
+            pending = top.nextChild;
+            top.nextChild = document.GetNextSibling(pending);
+            if(top.isObject)
+            {
+                if(!top.first) sink.Put(pretty? ",\n" : ",");
+                const JsonStringRef key = document.GetKey(pending);
+                sink.Put('"');
+                AppendEscapedJsonString(sink.Buffer(), key.GetData(), key.GetSize());
+                sink.Put("\":");
+            }
+            else if(!top.first)
+            {
+                sink.Put(',');
+            }
+            top.first = false;
+        }
+    }
 }
 
-void JsonArray::AddElement(std::unique_ptr<JsonNode> nextElement)
+void SerializeJson(const JsonNode& root, string& output, JsonStyle style)
 {
-    assert(nextElement != nullptr);
-    values.emplace_back(move(nextElement));
+    JsonSink sink(output, nullptr);
+    WriteJson(root, sink, style);
 }
-#pragma endregion
 
-#pragma region Object
-
-string JsonObject::serialize() 
+void SerializeJson(const JsonNode& root, ostream& output, JsonStyle style)
 {
     string buffer;
-    buffer += "{\n";
+    JsonSink sink(buffer, &output);
+    WriteJson(root, sink, style);
+    sink.Flush();
+}
 
-    vector<string> elements;
-    for(JsonKeyValue& keyValue: attributes)
-    {        
-        assert(keyValue.value != nullptr);
-        string line = '"' + keyValue.key + "\":" + keyValue.value->serialize();
-        elements.emplace_back(move(line));
-    }
+string JsonNode::serialize(JsonStyle style) const
+{
+    string output;
+    SerializeJson(*this, output, style);
+    return output;
+}
 
-    buffer += StrJoin(elements, ",\n");
+void SerializeJson(const JsonDocument& document, string& output, JsonStyle style)
+{
+    JsonSink sink(output, nullptr);
+    WriteJson(document, sink, style);
+}
 
-    buffer += "\n}";
-    return buffer;
+void SerializeJson(const JsonDocument& document, ostream& output, JsonStyle style)
+{
+    string buffer;
+    JsonSink sink(buffer, &output);
+    WriteJson(document, sink, style);
+    sink.Flush();
 }
 
+string JsonDocument::serialize(JsonStyle style) const
+{
+    string output;
+    SerializeJson(*this, output, style);
+    return output;
+}
+#pragma endregion
+
+#pragma region JsonArray
+void JsonArray::AddElement(std::unique_ptr<JsonNode> nextElement)
+{
+    assert(nextElement != nullptr);
+    values.emplace_back(move(nextElement));
+}
+#pragma endregion
+
+#pragma region Object
+
 bool JsonObject::keyAlreadyExists(const std::string& key)
 {
     //Assuming JSON objects are fairly small,
@@ -135,7 +526,7 @@ void JsonObject::AddBool(std::string key, bool boolValue)
     if(keyAlreadyExists(key)) throw invalid_argument("key already exists");
 
     attributes.emplace_back(JsonKeyValue{
-        key,
+        move(key),
         make_unique<JsonBoolean>(boolValue)
     });
 }
@@ -145,8 +536,8 @@ void JsonObject::AddString(std::string key, std::string strValue)
     if(keyAlreadyExists(key)) throw invalid_argument("key already exists");
 
     attributes.emplace_back(JsonKeyValue{
-        key,
-        make_unique<JsonString>(strValue)
+        move(key),
+        make_unique<JsonString>(move(strValue))
     });
 }
 
@@ -155,19 +546,255 @@ void JsonObject::AddInteger(std::string key, int64_t intValue)
     if(keyAlreadyExists(key)) throw invalid_argument("key already exists");
 
     attributes.emplace_back(JsonKeyValue{
-        key,
+        move(key),
         make_unique<JsonInteger>(intValue)
     });
 }
 
+void JsonObject::AddDouble(std::string key, double doubleValue)
+{
+    if(keyAlreadyExists(key)) throw invalid_argument("key already exists");
+
+    attributes.emplace_back(JsonKeyValue{
+        move(key),
+        make_unique<JsonDouble>(doubleValue)
+    });
+}
+
 void JsonObject::AddNode(std::string key, std::unique_ptr<JsonNode> node)
 {
     if(keyAlreadyExists(key)) throw invalid_argument("key already exists");
 
     attributes.emplace_back(JsonKeyValue{
-        key,
+        move(key),
         move(node)
     });
 }
 
-#pragma endregion 
\ No newline at end of file
+#pragma endregion 
+
+#pragma region JsonDocument
+namespace
+{
+    //FNV-1a, only used to bucket object keys
+    uint64_t HashKey(JsonStringRef key)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for(size_t i = 0; i < key.GetSize(); i++)
+        {
+            hash ^= static_cast<unsigned char>(key.GetData()[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+constexpr JsonDocument::NodeId JsonDocument::noNode;
+constexpr uint32_t JsonDocument::keyIndexThreshold;
+
+JsonDocument::JsonDocument(JsonType rootType)
+{
+    Clear(rootType);
+}
+
+void JsonDocument::Clear(JsonType rootType)
+{
+    if(rootType != JsonType::Object && rootType != JsonType::Array)
+    {
+        throw invalid_argument("document root must be an object or an array");
+    }
+
+    nodes.clear();
+    characters.clear();
+    for(size_t i = 0; i < nKeyIndexes; i++) keyIndexes[i].clear();
+    nKeyIndexes = 0;
+    NewNode(rootType);
+}
+
+void JsonDocument::Reserve(size_t nNodes, size_t nCharacters)
+{
+    nodes.reserve(nNodes);
+    characters.reserve(nCharacters);
+}
+
+JsonDocument::StoredString JsonDocument::Store(JsonStringRef text)
+{
+    if(characters.size() + text.GetSize() > 0xFFFFFFFFu)
+    {
+        throw length_error("JSON document exceeds 4GB of string data");
+    }
+
+    const StoredString stored{
+        static_cast<uint32_t>(characters.size()),
+        static_cast<uint32_t>(text.GetSize())
+    };
+    characters.append(text.GetData(), text.GetSize());
+    return stored;
+}
+
+JsonDocument::NodeId JsonDocument::NewNode(JsonType type)
+{
+    if(nodes.size() >= noNode) throw length_error("JSON document has too many nodes");
+
+    Node node;
+    node.type = type;
+    node.nextSibling = noNode;
+    node.key = StoredString{0, 0};
+    node.value.container = ContainerLinks{noNode, noNode, 0, noNode};
+
+    nodes.push_back(node);
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+void JsonDocument::LinkChild(NodeId container, NodeId child)
+{
+    ContainerLinks& links = nodes[container].value.container;
+    if(links.lastChild == noNode) links.firstChild = child;
+    else nodes[links.lastChild].nextSibling = child;
+
+    links.lastChild = child;
+    links.childCount++;
+}
+
+JsonDocument::NodeId JsonDocument::FindMember(NodeId object, JsonStringRef key) const
+{
+    assert(GetType(object) == JsonType::Object);
+
+    const ContainerLinks& links = nodes[object].value.container;
+    if(links.keyIndex != noNode)
+    {
+        const KeyIndex& index = keyIndexes[links.keyIndex];
+        const auto candidates = index.equal_range(HashKey(key));
+        for(auto it = candidates.first; it != candidates.second; ++it)
+        {
+            if(GetKey(it->second) == key) return it->second;
+        }
+        return noNode;
+    }
+
+    for(NodeId member = links.firstChild; member != noNode; member = nodes[member].nextSibling)
+    {
+        if(GetKey(member) == key) return member;
+    }
+    return noNode;
+}
+
+JsonDocument::NodeId JsonDocument::NewMember(NodeId object, JsonStringRef key, JsonType type)
+{
+    if(GetType(object) != JsonType::Object) throw invalid_argument("not an object node");
+    if(FindMember(object, key) != noNode) throw invalid_argument("key already exists");
+
+    const StoredString storedKey = Store(key);
+    const NodeId member = NewNode(type);
+    nodes[member].key = storedKey;
+    LinkChild(object, member);
+
+    //Small objects are scanned, larger ones switch over to a hashed index
+    ContainerLinks& links = nodes[object].value.container;
+    if(links.keyIndex != noNode)
+    {
+        keyIndexes[links.keyIndex].emplace(HashKey(key), member);
+    }
+    else if(links.childCount >= keyIndexThreshold)
+    {
+        links.keyIndex = static_cast<uint32_t>(nKeyIndexes);
+        if(nKeyIndexes == keyIndexes.size()) keyIndexes.emplace_back();
+        nKeyIndexes++;
+
+        KeyIndex& index = keyIndexes[links.keyIndex];
+        index.reserve(links.childCount * 2);
+        for(NodeId existing = links.firstChild; existing != noNode; existing = nodes[existing].nextSibling)
+        {
+            index.emplace(HashKey(GetKey(existing)), existing);
+        }
+    }
+    return member;
+}
+
+JsonDocument::NodeId JsonDocument::NewElement(NodeId array, JsonType type)
+{
+    if(GetType(array) != JsonType::Array) throw invalid_argument("not an array node");
+
+    const NodeId element = NewNode(type);
+    LinkChild(array, element);
+    return element;
+}
+
+JsonDocument::NodeId JsonDocument::AddBool(NodeId object, JsonStringRef key, bool value)
+{
+    const NodeId member = NewMember(object, key, JsonType::Boolean);
+    nodes[member].value.boolValue = value;
+    return member;
+}
+
+JsonDocument::NodeId JsonDocument::AddInteger(NodeId object, JsonStringRef key, int64_t value)
+{
+    const NodeId member = NewMember(object, key, JsonType::Integer);
+    nodes[member].value.integerValue = value;
+    return member;
+}
+
+JsonDocument::NodeId JsonDocument::AddDouble(NodeId object, JsonStringRef key, double value)
+{
+    const NodeId member = NewMember(object, key, JsonType::Double);
+    nodes[member].value.doubleValue = value;
+    return member;
+}
+
+JsonDocument::NodeId JsonDocument::AddString(NodeId object, JsonStringRef key, JsonStringRef value)
+{
+    const NodeId member = NewMember(object, key, JsonType::String);
+    const StoredString storedValue = Store(value);
+    nodes[member].value.stringValue = storedValue;
+    return member;
+}
+
+JsonDocument::NodeId JsonDocument::AddObject(NodeId object, JsonStringRef key)
+{
+    return NewMember(object, key, JsonType::Object);
+}
+
+JsonDocument::NodeId JsonDocument::AddArray(NodeId object, JsonStringRef key)
+{
+    return NewMember(object, key, JsonType::Array);
+}
+
+JsonDocument::NodeId JsonDocument::AppendBool(NodeId array, bool value)
+{
+    const NodeId element = NewElement(array, JsonType::Boolean);
+    nodes[element].value.boolValue = value;
+    return element;
+}
+
+JsonDocument::NodeId JsonDocument::AppendInteger(NodeId array, int64_t value)
+{
+    const NodeId element = NewElement(array, JsonType::Integer);
+    nodes[element].value.integerValue = value;
+    return element;
+}
+
+JsonDocument::NodeId JsonDocument::AppendDouble(NodeId array, double value)
+{
+    const NodeId element = NewElement(array, JsonType::Double);
+    nodes[element].value.doubleValue = value;
+    return element;
+}
+
+JsonDocument::NodeId JsonDocument::AppendString(NodeId array, JsonStringRef value)
+{
+    const NodeId element = NewElement(array, JsonType::String);
+    const StoredString storedValue = Store(value);
+    nodes[element].value.stringValue = storedValue;
+    return element;
+}
+
+JsonDocument::NodeId JsonDocument::AppendObject(NodeId array)
+{
+    return NewElement(array, JsonType::Object);
+}
+
+JsonDocument::NodeId JsonDocument::AppendArray(NodeId array)
+{
+    return NewElement(array, JsonType::Array);
+}
+#pragma endregion
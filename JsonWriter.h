@@ -2,9 +2,13 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <unordered_map>
 
 //Bare-bones JSON writer meant only for outputting a report for the unit tests
-//Does *not* support unicode characters, or any of the null-ish values
+//Does *not* support any of the null-ish values. Strings are treated as UTF-8,
+//control characters are always written as escapes
 
 class JsonNode;
 
@@ -12,21 +16,35 @@ enum class JsonType
 {
     Boolean,
     Integer,
+    Double,
     String,
     Object,
     Array
 };
 
+enum class Utf8Handling
+{
+    ReplaceInvalid, //Malformed UTF-8 bytes are written as \ufffd so the output is always valid JSON
+    Passthrough     //Bytes above 0x7F are copied as is
+};
+
+enum class JsonStyle
+{
+    Pretty,     //One object member per line
+    Compact     //No whitespace at all, i.e. for JSON Lines output
+};
+
 class JsonNode
 {
 protected:
     JsonType nodeType;
-    std::unique_ptr<JsonNode> value;
 public:
     JsonNode(JsonType type) : nodeType{type}
     {}
 
-    virtual std::string serialize() = 0;
+    JsonType GetType() const { return nodeType; }
+
+    std::string serialize(JsonStyle style = JsonStyle::Pretty) const;
 
     virtual ~JsonNode() = default;
 };
@@ -40,7 +58,7 @@ public:
     , value{_value}
     {}
 
-    std::string serialize() override;
+    bool GetValue() const { return value; }
 };
 
 class JsonInteger : public JsonNode
@@ -52,7 +70,20 @@ public:
     , value{_value}
     {}
 
-    std::string serialize() override;
+    int64_t GetValue() const { return value; }
+};
+
+//Non-finite values have no JSON representation and are written as 0
+class JsonDouble : public JsonNode
+{
+    double value = 0.0;
+public:
+    JsonDouble(double _value)
+    : JsonNode{JsonType::Double}
+    , value{_value}
+    {}
+
+    double GetValue() const { return value; }
 };
 
 class JsonString: public JsonNode
@@ -61,10 +92,10 @@ class JsonString: public JsonNode
 public:
     JsonString(std::string _value)
     : JsonNode{JsonType::String}
-    , value{_value}
+    , value{std::move(_value)}
     {}
 
-    std::string serialize() override;
+    const std::string& GetValue() const { return value; }
 };
 
 class JsonArray: public JsonNode
@@ -75,7 +106,7 @@ public:
     : JsonNode{JsonType::Array}
     {}
 
-    std::string serialize() override;
+    const std::vector<std::unique_ptr<JsonNode>>& GetElements() const { return values; }
 
     void AddElement(std::unique_ptr<JsonNode> nextElement);
 };
@@ -95,11 +126,12 @@ public:
     JsonObject() : JsonNode(JsonType::Object)
     {}
 
-    std::string serialize() override;
+    const std::vector<JsonKeyValue>& GetAttributes() const { return attributes; }
 
     void AddBool(std::string key, bool value);
     void AddString(std::string key, std::string value);
     void AddInteger(std::string key, int64_t value);
+    void AddDouble(std::string key, double value);
     void AddNode(std::string key, std::unique_ptr<JsonNode> node); //Array & Object
 };
 
@@ -113,6 +145,12 @@ struct json_type_map<T, std::enable_if_t<std::is_integral<T>::value>>
 };
 
 
+template<typename T>
+struct json_type_map<T, std::enable_if_t<std::is_floating_point<T>::value>>
+{ 
+    using type = JsonDouble;
+};
+
 template<>
 struct json_type_map<bool>
 {
@@ -146,6 +184,9 @@ namespace
 
         static_assert(is_same<json_type_map<bool>::type, JsonBoolean>::value, "bool should map to bool");
 
+        static_assert(is_same<json_type_map<double>::type, JsonDouble>::value, "double should map to double");
+        static_assert(is_same<json_type_map<float>::type, JsonDouble>::value, "float should map to double");
+
         static_assert(is_same<json_type_map<string>::type, JsonString>::value, "string should map to string");
         static_assert(is_same<json_type_map<decltype("string literal")>::type, JsonString>::value, "string literal should map to string");
 
@@ -193,4 +234,163 @@ std::unique_ptr<JsonArray> make_json_array(TArgs&&... args)
 }
 
 
-std::string StrJoin(const vector<std::string>& strings, const std::string& delimiter);
\ No newline at end of file
+std::string StrJoin(const vector<std::string>& strings, const std::string& delimiter);
+
+//Escapes 'str' for use inside a JSON string literal (without the surrounding quotes)
+void AppendEscapedJsonString(std::string& output, const std::string& str, Utf8Handling utf8 = Utf8Handling::ReplaceInvalid);
+void AppendEscapedJsonString(std::string& output, const char* str, size_t size, Utf8Handling utf8 = Utf8Handling::ReplaceInvalid);
+std::string EscapeJsonString(const std::string& str, Utf8Handling utf8 = Utf8Handling::ReplaceInvalid);
+
+//Non-owning view of a range of characters, stands in for std::string_view (C++17)
+class JsonStringRef
+{
+    const char* data;
+    size_t size;
+public:
+    JsonStringRef(const char* _data, size_t _size)
+    : data{_data}
+    , size{_size}
+    {}
+
+    JsonStringRef(const char* text)
+    : data{text}
+    , size{std::char_traits<char>::length(text)}
+    {}
+
+    JsonStringRef(const std::string& text)
+    : data{text.data()}
+    , size{text.size()}
+    {}
+
+    const char* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+    std::string ToString() const { return std::string(data, size); }
+
+    bool operator==(JsonStringRef other) const
+    {
+        return size == other.size && std::char_traits<char>::compare(data, other.data, size) == 0;
+    }
+    bool operator!=(JsonStringRef other) const { return !(*this == other); }
+};
+
+//Alternative to the JsonNode tree which keeps a whole document in a few contiguous buffers.
+//Nodes live in one vector and refer to each other by index, keys and string values are
+//copied into one shared character buffer. Building a document therefore only allocates
+//when one of those buffers grows, and Clear() keeps their capacity for reuse.
+//Objects with many members get a hashed key index of their own for the duplicate-key check,
+//Clear() empties those indexes but keeps them (& their buckets) for the next objects indexed.
+class JsonDocument
+{
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId noNode = 0xFFFFFFFFu;
+    static constexpr uint32_t keyIndexThreshold = 16;
+
+    //The root is an empty object or array
+    explicit JsonDocument(JsonType rootType = JsonType::Object);
+
+    void Clear(JsonType rootType = JsonType::Object);
+    void Reserve(size_t nNodes, size_t nCharacters);
+
+    NodeId GetRoot() const { return 0; }
+    size_t GetNodeCount() const { return nodes.size(); }
+
+    //Keys and string values are copied in, they must not refer to this document's own strings
+
+    //Object members, throws invalid_argument if 'key' already exists in 'object'
+    NodeId AddBool(NodeId object, JsonStringRef key, bool value);
+    NodeId AddInteger(NodeId object, JsonStringRef key, int64_t value);
+    NodeId AddDouble(NodeId object, JsonStringRef key, double value);
+    NodeId AddString(NodeId object, JsonStringRef key, JsonStringRef value);
+    NodeId AddObject(NodeId object, JsonStringRef key);
+    NodeId AddArray(NodeId object, JsonStringRef key);
+
+    //Array elements
+    NodeId AppendBool(NodeId array, bool value);
+    NodeId AppendInteger(NodeId array, int64_t value);
+    NodeId AppendDouble(NodeId array, double value);
+    NodeId AppendString(NodeId array, JsonStringRef value);
+    NodeId AppendObject(NodeId array);
+    NodeId AppendArray(NodeId array);
+
+    JsonType GetType(NodeId node) const { return nodes[node].type; }
+    bool GetBool(NodeId node) const { return nodes[node].value.boolValue; }
+    int64_t GetInteger(NodeId node) const { return nodes[node].value.integerValue; }
+    double GetDouble(NodeId node) const { return nodes[node].value.doubleValue; }
+    JsonStringRef GetString(NodeId node) const { return Resolve(nodes[node].value.stringValue); }
+
+    //Key of an object member
+    JsonStringRef GetKey(NodeId node) const { return Resolve(nodes[node].key); }
+
+    //Children of an object or array in insertion order, terminated by noNode
+    NodeId GetFirstChild(NodeId container) const { return nodes[container].value.container.firstChild; }
+    NodeId GetNextSibling(NodeId node) const { return nodes[node].nextSibling; }
+    size_t GetChildCount(NodeId container) const { return nodes[container].value.container.childCount; }
+
+    //noNode if 'object' has no member called 'key'
+    NodeId FindMember(NodeId object, JsonStringRef key) const;
+
+    std::string serialize(JsonStyle style = JsonStyle::Pretty) const;
+
+private:
+    struct StoredString
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct ContainerLinks
+    {
+        NodeId firstChild;
+        NodeId lastChild;
+        uint32_t childCount;
+        uint32_t keyIndex; //into keyIndexes, noNode until the object reaches keyIndexThreshold
+    };
+
+    union NodeValue
+    {
+        bool boolValue;
+        int64_t integerValue;
+        double doubleValue;
+        StoredString stringValue;
+        ContainerLinks container;
+    };
+
+    struct Node
+    {
+        JsonType type;
+        NodeId nextSibling;
+        StoredString key;
+        NodeValue value;
+    };
+
+    //Key hash -> member of a single indexed object
+    using KeyIndex = std::unordered_multimap<uint64_t, NodeId>;
+
+    std::vector<Node> nodes;
+    std::string characters;
+    //One per indexed object, only the first nKeyIndexes are in use
+    std::vector<KeyIndex> keyIndexes;
+    size_t nKeyIndexes = 0;
+
+    JsonStringRef Resolve(StoredString text) const
+    {
+        return JsonStringRef(characters.data() + text.offset, text.length);
+    }
+
+    StoredString Store(JsonStringRef text);
+    NodeId NewNode(JsonType type);
+    void LinkChild(NodeId container, NodeId child);
+    NodeId NewMember(NodeId object, JsonStringRef key, JsonType type);
+    NodeId NewElement(NodeId array, JsonType type);
+};
+
+//Serializes the tree rooted at 'root' without recursion, appending straight onto 'output'.
+//Reuse the same output buffer across calls to avoid reallocating it.
+void SerializeJson(const JsonNode& root, std::string& output, JsonStyle style = JsonStyle::Pretty);
+
+//As above, but streams the output in fixed-size chunks so the whole document is never held in memory
+void SerializeJson(const JsonNode& root, std::ostream& output, JsonStyle style = JsonStyle::Pretty);
+
+void SerializeJson(const JsonDocument& document, std::string& output, JsonStyle style = JsonStyle::Pretty);
+void SerializeJson(const JsonDocument& document, std::ostream& output, JsonStyle style = JsonStyle::Pretty);
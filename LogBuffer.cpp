@@ -0,0 +1,62 @@
+#include "LogBuffer.h"
+
+namespace CTest
+{
+    LogBuffer::LogBuffer(size_t _capacity)
+    : capacity{_capacity}
+    {}
+
+    LogBuffer::Entry& LogBuffer::NextEntry()
+    {
+        //Grows up to the capacity, only a test which actually logs that much pays for the slots
+        if(capacity == 0 || entries.size() < capacity)
+        {
+            entries.emplace_back();
+            return entries.back();
+        }
+
+        Entry& overwritten = entries[oldest];
+        oldest = (oldest + 1) % entries.size();
+        nDropped++;
+        return overwritten;
+    }
+
+    void LogBuffer::Push(const string& message)
+    {
+        Entry& entry = NextEntry();
+        entry.format = nullptr;
+        entry.render = nullptr;
+        entry.message.assign(message);
+    }
+
+    size_t LogBuffer::Size() const
+    {
+        return entries.size();
+    }
+
+    void LogBuffer::MoveTo(vector<string>& logs)
+    {
+        logs.reserve(logs.size() + entries.size());
+        for(size_t i = 0; i < entries.size(); i++)
+        {
+            Entry& entry = entries[(oldest + i) % entries.size()];
+            if(entry.render != nullptr)
+            {
+                string message;
+                entry.render(message, entry.format, &entry.arguments);
+                logs.emplace_back(move(message));
+            }
+            else
+            {
+                logs.emplace_back(move(entry.message));
+            }
+        }
+        Discard();
+    }
+
+    void LogBuffer::Discard()
+    {
+        entries.clear();
+        oldest = 0;
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Formatter.h"
+
+namespace CTest
+{
+    using namespace std;
+
+    //Copies of a log's arguments, trivially copyable as long as every argument is
+    namespace DeferredLog
+    {
+        template<typename ...TValues>
+        struct ArgumentPack;
+
+        template<>
+        struct ArgumentPack<>
+        {};
+
+        template<typename TValue, typename ...TRest>
+        struct ArgumentPack<TValue, TRest...>
+        {
+            TValue value;
+            ArgumentPack<TRest...> rest;
+        };
+
+        inline ArgumentPack<> MakePack() { return ArgumentPack<>{}; }
+
+        template<typename TValue, typename ...TRest>
+        ArgumentPack<decay_t<TValue>, decay_t<TRest>...> MakePack(const TValue& value, const TRest&... rest)
+        {
+            return ArgumentPack<decay_t<TValue>, decay_t<TRest>...>{value, MakePack(rest...)};
+        }
+
+        inline void CollectArguments(const ArgumentPack<>&, FormatAppend::FormatArgument*)
+        {}
+
+        template<typename TValue, typename ...TRest>
+        void CollectArguments(const ArgumentPack<TValue, TRest...>& pack, FormatAppend::FormatArgument* arguments)
+        {
+            *arguments = FormatAppend::MakeFormatArgument(pack.value);
+            CollectArguments(pack.rest, arguments + 1);
+        }
+
+        constexpr bool AllOf() { return true; }
+
+        template<typename ...TRest>
+        constexpr bool AllOf(bool first, TRest... rest) { return first && AllOf(rest...); }
+
+        //Pointers (i.e. a char* into a buffer the test reuses) may no longer be valid by the time the log is formatted
+        template<typename TValue>
+        constexpr bool IsDeferrable()
+        {
+            return is_trivially_copyable<TValue>::value && !is_pointer<TValue>::value;
+        }
+    }
+
+    //Fixed-capacity ring of a single test's logs, keeping the most recent ones.
+    //Logs with only trivially copyable arguments (numbers, enums, small structs) store the format & a copy of
+    //their arguments inline, and are only formatted if they end up in the results. Every other log is formatted
+    //straight away into its slot's string. Once the ring is full, slots are overwritten in place & their
+    //strings keep their capacity, so a test logging in a loop neither allocates nor grows its memory.
+    class LogBuffer
+    {
+    public:
+        static constexpr size_t inlineArgumentBytes = 48;
+
+    private:
+        struct Entry
+        {
+            const char* format = nullptr;
+            //Formats the stored arguments, null when 'message' already holds the formatted log
+            void (*render)(string& out, const char* format, const void* arguments) = nullptr;
+            string message;
+            typename aligned_storage<inlineArgumentBytes, alignof(max_align_t)>::type arguments;
+        };
+
+        vector<Entry> entries;
+        size_t capacity;
+        size_t oldest = 0;
+        size_t nDropped = 0;
+
+        Entry& NextEntry();
+
+        template<typename ...TValues>
+        static void RenderArguments(string& out, const char* format, const void* arguments)
+        {
+            FormatAppend::FormatArgument collected[sizeof...(TValues) + 1];
+            DeferredLog::CollectArguments(*static_cast<const DeferredLog::ArgumentPack<TValues...>*>(arguments), collected);
+            FormatAppend::AppendFormatted(out, format, char_traits<char>::length(format), collected, sizeof...(TValues));
+        }
+
+        template<typename ...TArgs>
+        void StoreArguments(Entry& entry, true_type, const TArgs&... args)
+        {
+            using TPack = DeferredLog::ArgumentPack<decay_t<TArgs>...>;
+            new(&entry.arguments) TPack(DeferredLog::MakePack(args...));
+            entry.render = &RenderArguments<decay_t<TArgs>...>;
+        }
+
+        template<typename ...TArgs>
+        void StoreArguments(Entry& entry, false_type, const TArgs&... args)
+        {
+            entry.message.clear();
+            cfmt_to(entry.message, entry.format, args...);
+            entry.render = nullptr;
+        }
+
+    public:
+        //0 keeps every log
+        explicit LogBuffer(size_t capacity);
+
+        void Push(const string& message);
+
+        //The format is kept until the log is formatted, i.e. a string literal
+        template<typename ...TArgs>
+        void Push(const char* format, const TArgs&... args)
+        {
+            using TPack = DeferredLog::ArgumentPack<decay_t<TArgs>...>;
+            using TDeferrable = integral_constant<bool,
+                DeferredLog::AllOf(DeferredLog::IsDeferrable<decay_t<TArgs>>()...) &&
+                sizeof(TPack) <= inlineArgumentBytes &&
+                alignof(TPack) <= alignof(max_align_t)>;
+
+            Entry& entry = NextEntry();
+            entry.format = format;
+            StoreArguments(entry, TDeferrable{}, args...);
+        }
+
+        size_t Size() const;
+
+        //Older logs overwritten once the buffer was full
+        size_t GetDroppedCount() const { return nDropped; }
+
+        //Formats the logs still held onto the end of 'logs', oldest first, then empties the buffer
+        void MoveTo(vector<string>& logs);
+
+        //Empties the buffer without formatting anything, the drop count is kept
+        void Discard();
+    };
+}
@@ -0,0 +1,139 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#define CANARY_HAS_PERF_EVENTS 1
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define CANARY_HAS_PERF_EVENTS 0
+#endif
+
+namespace CTest
+{
+#if CANARY_HAS_PERF_EVENTS
+    namespace
+    {
+        uint64_t CacheMissConfig(uint64_t cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+
+        int OpenEvent(PerfEvent event, int groupFd)
+        {
+            perf_event_attr attributes;
+            memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.disabled = groupFd == -1? 1 : 0;   //Members follow the leader being enabled & disabled
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            switch(event)
+            {
+                case PerfEvent::cycles:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case PerfEvent::instructions:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case PerfEvent::branchMisses:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+                    break;
+                case PerfEvent::l1dReadMisses:
+                    attributes.type = PERF_TYPE_HW_CACHE;
+                    attributes.config = CacheMissConfig(PERF_COUNT_HW_CACHE_L1D);
+                    break;
+                case PerfEvent::llcReadMisses:
+                    attributes.type = PERF_TYPE_HW_CACHE;
+                    attributes.config = CacheMissConfig(PERF_COUNT_HW_CACHE_LL);
+                    break;
+            }
+
+            //This thread (0) on whichever CPU it runs (-1)
+            return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0));
+        }
+    }
+
+    PerfCounterGroup::PerfCounterGroup()
+    {
+        //The first event that opens leads the group, so that every count covers the same instructions
+        for(size_t i = 0; i < nPerfEvents; i++)
+        {
+            fds[i] = OpenEvent(static_cast<PerfEvent>(i), leaderFd);
+            if(leaderFd == -1) leaderFd = fds[i];
+        }
+    }
+
+    PerfCounterGroup::~PerfCounterGroup()
+    {
+        //Members before the leader
+        for(size_t i = nPerfEvents; i-- > 0;)
+        {
+            if(fds[i] != -1) close(fds[i]);
+        }
+    }
+
+    void PerfCounterGroup::Start()
+    {
+        if(leaderFd == -1) return;
+        ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    bool PerfCounterGroup::Stop(int64_t (&counts)[nPerfEvents])
+    {
+        for(int64_t& count: counts) count = -1;
+        if(leaderFd == -1) return false;
+
+        ioctl(leaderFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        //{nr, time_enabled, time_running, values[nr]}, values in the order the events were opened
+        uint64_t data[3 + nPerfEvents];
+        const ssize_t nRead = read(leaderFd, data, sizeof(data));
+        if(nRead < static_cast<ssize_t>(3 * sizeof(uint64_t))) return false;
+
+        const uint64_t nValues = data[0];
+        const uint64_t timeEnabled = data[1];
+        const uint64_t timeRunning = data[2];
+        if(nValues > nPerfEvents || nRead < static_cast<ssize_t>((3 + nValues) * sizeof(uint64_t))) return false;
+        if(timeRunning == 0) return false;
+
+        //Only running part of the time means the kernel multiplexed the group with other counters
+        const double scale = static_cast<double>(timeEnabled) / static_cast<double>(timeRunning);
+        size_t value = 0;
+        for(size_t i = 0; i < nPerfEvents && value < nValues; i++)
+        {
+            if(fds[i] == -1) continue;
+            counts[i] = static_cast<int64_t>(static_cast<double>(data[3 + value]) * scale + 0.5);
+            value++;
+        }
+        return true;
+    }
+#else
+    PerfCounterGroup::PerfCounterGroup()
+    {
+        for(int& fd: fds) fd = -1;
+    }
+
+    PerfCounterGroup::~PerfCounterGroup() = default;
+
+    void PerfCounterGroup::Start() {}
+
+    bool PerfCounterGroup::Stop(int64_t (&counts)[nPerfEvents])
+    {
+        for(int64_t& count: counts) count = -1;
+        return false;
+    }
+#endif
+
+    bool PerfCounterGroup::IsOpen() const
+    {
+        return leaderFd != -1;
+    }
+}
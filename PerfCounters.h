@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace CTest
+{
+    enum class PerfEvent
+    {
+        cycles,
+        instructions,
+        branchMisses,
+        l1dReadMisses,
+        llcReadMisses
+    };
+
+    const size_t nPerfEvents = 5;
+
+    //Hardware performance counters of the calling thread, read with perf_event_open (Linux only).
+    //Only user-space events are counted, which an unprivileged process may do up to perf_event_paranoid 2.
+    //Events the kernel refuses to open (unsupported by the CPU or hypervisor, forbidden by perf_event_paranoid
+    //or a container's seccomp policy) are left out of the group; on other platforms none are ever opened.
+    class PerfCounterGroup
+    {
+        int fds[nPerfEvents];
+        int leaderFd = -1;
+
+    public:
+        PerfCounterGroup();
+        ~PerfCounterGroup();
+
+        PerfCounterGroup(const PerfCounterGroup&) = delete;
+        PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+        //False when no event at all could be opened
+        bool IsOpen() const;
+
+        void Start();
+
+        //Counts since Start(), indexed by PerfEvent and -1 for the events left out.
+        //Scaled up if the kernel had to multiplex the counters. False when the group could not be read
+        //or was never scheduled onto the CPU's counters.
+        bool Stop(int64_t (&counts)[nPerfEvents]);
+    };
+}
@@ -0,0 +1,165 @@
+#include "PerformanceBaselines.h"
+#include "StateFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+namespace CTest
+{
+    namespace
+    {
+        const char* const baselinesHeader = "canary-performance-baselines";
+
+        double Median(vector<double> samples)
+        {
+            if(samples.empty()) return 0.0;
+
+            const size_t middle = samples.size() / 2;
+            nth_element(samples.begin(), samples.begin() + middle, samples.end());
+            if(samples.size() % 2 != 0) return samples[middle];
+
+            //The lower middle is the largest of the lower half
+            const double lowerMiddle = *max_element(samples.begin(), samples.begin() + middle);
+            return (lowerMiddle + samples[middle]) / 2.0;
+        }
+
+        bool ParseNonNegative(const string& field, size_t nameLength, double& value)
+        {
+            const char* const begin = field.c_str() + nameLength;
+            char* end = nullptr;
+            value = strtod(begin, &end);
+            return end != begin && *end == '\0' && value >= 0.0;
+        }
+    }
+
+    vector<double> GetTimingSamples(const TestResults& results)
+    {
+        if(results.isBenchmark) return results.benchmark.nanosPerIterationSamples;
+        if(results.isRepeated) return results.repeat.wallNanosSamples;
+        return {static_cast<double>(results.executionTimeNanos)};
+    }
+
+    double ScaledMedianAbsoluteDeviation(const vector<double>& samples, double median)
+    {
+        vector<double> deviations;
+        deviations.reserve(samples.size());
+        for(const double sample: samples) deviations.push_back(fabs(sample - median));
+        return 1.4826 * Median(move(deviations));
+    }
+
+    PerformanceBaselines PerformanceBaselines::Load(const string& path)
+    {
+        PerformanceBaselines baselines;
+
+        ifstream file(path);
+        if(!file) return baselines;
+
+        string line;
+        if(!getline(file, line) || line != baselinesHeader) return baselines;
+
+        string groupName;
+        string methodName;
+        while(getline(file, line))
+        {
+            const vector<string> fields = StateFile::SplitFields(line);
+            if(fields.size() < 2) continue;
+            if(!StateFile::Unescape(fields[0], groupName) || !StateFile::Unescape(fields[1], methodName)) continue;
+
+            Entry entry;
+            bool hasMedian = false;
+            for(size_t i = 2; i < fields.size(); i++)
+            {
+                const string& field = fields[i];
+                double value = 0.0;
+                if(field.compare(0, 8, "samples=") == 0 && ParseNonNegative(field, 8, value))
+                {
+                    entry.nSamples = static_cast<size_t>(value);
+                }
+                else if(field.compare(0, 7, "median=") == 0 && ParseNonNegative(field, 7, value))
+                {
+                    entry.medianNanos = value;
+                    hasMedian = true;
+                }
+                else if(field.compare(0, 4, "mad=") == 0 && ParseNonNegative(field, 4, value))
+                {
+                    entry.madNanos = value;
+                }
+            }
+            if(hasMedian) baselines.entries[StateFile::MakeTestKey(groupName, methodName)] = entry;
+        }
+        return baselines;
+    }
+
+    void PerformanceBaselines::Save(const string& path) const
+    {
+        const string temporaryPath = path + ".tmp";
+        {
+            ofstream file(temporaryPath, ios::trunc);
+            if(!file) throw runtime_error("unable to write performance baselines file " + temporaryPath);
+
+            string line;
+            file << baselinesHeader << '\n';
+            for(const auto& keyEntry: entries)
+            {
+                line.clear();
+                StateFile::AppendTestKey(line, keyEntry.first);
+
+                //Sub-nanosecond digits matter for the per-iteration times of fast benchmarks
+                const Entry& entry = keyEntry.second;
+                char fields[128];
+                snprintf(fields, sizeof(fields), "\tsamples=%zu\tmedian=%.3f\tmad=%.3f\n", entry.nSamples, entry.medianNanos, entry.madNanos);
+                line += fields;
+                file << line;
+            }
+
+            if(!file.flush()) throw runtime_error("unable to write performance baselines file " + temporaryPath);
+        }
+
+        StateFile::ReplaceFile(temporaryPath, path, "performance baselines");
+    }
+
+    void PerformanceBaselines::Record(const TestResults& results)
+    {
+        const vector<double> samples = GetTimingSamples(results);
+        if(samples.empty()) return;
+
+        Entry& entry = entries[StateFile::MakeTestKey(results.groupName, results.methodName)];
+        entry.nSamples = samples.size();
+        entry.medianNanos = Median(samples);
+        entry.madNanos = ScaledMedianAbsoluteDeviation(samples, entry.medianNanos);
+        modified = true;
+    }
+
+    PerformanceBaselines::Comparison PerformanceBaselines::Compare(const TestResults& results, const BaselineOptions& options) const
+    {
+        Comparison comparison;
+        const Entry* baseline = Find(results.groupName, results.methodName);
+        const vector<double> samples = GetTimingSamples(results);
+        if(baseline == nullptr || samples.empty()) return comparison;
+
+        comparison.hasBaseline = true;
+        comparison.baseline = *baseline;
+        comparison.nSamples = samples.size();
+        comparison.medianNanos = Median(samples);
+
+        //Noisy tests are given room by their MAD, very steady ones still need to slow down noticeably
+        const double allowedSlowdown = max(
+            options.madFactor * baseline->madNanos,
+            options.minRelativeSlowdown * baseline->medianNanos
+        );
+        comparison.limitNanos = baseline->medianNanos + allowedSlowdown;
+        comparison.conclusive = baseline->nSamples >= options.minSamples && comparison.nSamples >= options.minSamples;
+        comparison.regressed = comparison.conclusive && comparison.medianNanos > comparison.limitNanos;
+        return comparison;
+    }
+
+    const PerformanceBaselines::Entry* PerformanceBaselines::Find(const string& groupName, const string& methodName) const
+    {
+        const auto found = entries.find(StateFile::MakeTestKey(groupName, methodName));
+        return found != entries.end()? &found->second : nullptr;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CTest.h"
+
+namespace CTest
+{
+    using namespace std;
+
+    //Timing samples of a test in nanoseconds: the per-iteration times of a benchmark, the wall time of every
+    //iteration of a repeated test, otherwise its single wall time
+    vector<double> GetTimingSamples(const TestResults& results);
+
+    //Median absolute deviation, scaled by 1.4826 so that it estimates the standard deviation of normally
+    //distributed samples while ignoring outliers
+    double ScaledMedianAbsoluteDeviation(const vector<double>& samples, double median);
+
+    //Reference timings of every test, keyed by group & method name, persisted in a small local state file
+    //(see RunOptions::baseline) and compared against later runs to catch performance regressions
+    class PerformanceBaselines
+    {
+    public:
+        struct Entry
+        {
+            size_t nSamples = 0;
+            double medianNanos = 0.0;
+            double madNanos = 0.0;      //Scaled median absolute deviation of the samples
+        };
+
+        struct Comparison
+        {
+            bool hasBaseline = false;   //Nothing else is filled in unless set
+            Entry baseline;
+            size_t nSamples = 0;        //Of the compared run
+            double medianNanos = 0.0;
+            double limitNanos = 0.0;    //Slowest median still put down to noise
+            bool conclusive = false;    //Unset when either side has fewer than options.minSamples samples
+            bool regressed = false;     //Never set by an inconclusive comparison
+        };
+
+    private:
+        unordered_map<string, Entry> entries;
+        bool modified = false;
+
+    public:
+        //A missing file holds no baselines, i.e. before the first run.
+        //Lines which cannot be parsed are skipped.
+        static PerformanceBaselines Load(const string& path);
+
+        //Throws runtime_error if the file cannot be written
+        void Save(const string& path) const;
+
+        //Replaces the test's baseline with the timings of this run
+        void Record(const TestResults& results);
+
+        //The run regressed once its median exceeds the baseline median by both more than options.madFactor
+        //scaled MADs of the baseline and more than options.minRelativeSlowdown of the baseline median.
+        //Nothing is judged unless the baseline and the run both have options.minSamples samples.
+        Comparison Compare(const TestResults& results, const BaselineOptions& options) const;
+
+        //nullptr for tests without a baseline
+        const Entry* Find(const string& groupName, const string& methodName) const;
+
+        //Whether Record() changed anything since the baselines were loaded
+        bool IsModified() const { return modified; }
+
+        size_t Size() const { return entries.size(); }
+    };
+}
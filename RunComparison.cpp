@@ -0,0 +1,347 @@
+#include "RunComparison.h"
+#include "JsonReader.h"
+#include "StateFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace CTest
+{
+    //Defined with the reports
+    string GetAssertTypeName(const AssertType enType);
+
+    namespace
+    {
+        [[noreturn]] void ThrowNotAReport(const string& what)
+        {
+            throw runtime_error("not a test results report: " + what);
+        }
+
+        void ExpectToken(JsonReader& reader, JsonToken expected, JsonStringRef key)
+        {
+            if(reader.Next() != expected) ThrowNotAReport("unexpected value for \"" + key.ToString() + "\"");
+        }
+
+        //Keys point into the buffer in front of the value, reading on leaves them intact
+        int64_t ReadInteger(JsonReader& reader, JsonStringRef key)
+        {
+            const JsonToken token = reader.Next();
+            if(token == JsonToken::Integer) return reader.GetInteger();
+            if(token == JsonToken::Double) return static_cast<int64_t>(reader.GetDouble());
+            ThrowNotAReport("expected a number for \"" + key.ToString() + "\"");
+        }
+
+        double ReadDouble(JsonReader& reader, JsonStringRef key)
+        {
+            const JsonToken token = reader.Next();
+            if(token != JsonToken::Integer && token != JsonToken::Double)
+            {
+                ThrowNotAReport("expected a number for \"" + key.ToString() + "\"");
+            }
+            return reader.GetDouble();
+        }
+
+        bool ReadBool(JsonReader& reader, JsonStringRef key)
+        {
+            ExpectToken(reader, JsonToken::Boolean, key);
+            return reader.GetBool();
+        }
+
+        string ReadString(JsonReader& reader, JsonStringRef key)
+        {
+            ExpectToken(reader, JsonToken::String, key);
+            return reader.GetString().ToString();
+        }
+
+        AssertType ParseAssertType(JsonStringRef name)
+        {
+            for(int type = static_cast<int>(AssertType::plain_assert); type <= static_cast<int>(AssertType::time_budget); type++)
+            {
+                if(name == GetAssertTypeName(static_cast<AssertType>(type))) return static_cast<AssertType>(type);
+            }
+            return AssertType::plain_assert;
+        }
+
+        //The summary members shared by the benchmark & repeat objects
+        bool ReadStatisticsMember(JsonReader& reader, JsonStringRef key, SampleStatistics& statistics)
+        {
+            if(key == "min-nanos") statistics.min = ReadDouble(reader, key);
+            else if(key == "median-nanos") statistics.median = ReadDouble(reader, key);
+            else if(key == "mean-nanos") statistics.mean = ReadDouble(reader, key);
+            else if(key == "p99-nanos") statistics.p99 = ReadDouble(reader, key);
+            else if(key == "stddev-nanos") statistics.stddev = ReadDouble(reader, key);
+            else return false;
+            return true;
+        }
+
+        void ReadBenchmark(JsonReader& reader, BenchmarkStatistics& benchmark)
+        {
+            ExpectToken(reader, JsonToken::BeginObject, "benchmark");
+            while(reader.Next() == JsonToken::Key)
+            {
+                const JsonStringRef key = reader.GetString();
+                if(key == "iterations-per-sample") benchmark.iterationsPerSample = static_cast<uint64_t>(ReadInteger(reader, key));
+                else if(key == "samples") benchmark.nanosPerIteration.nSamples = static_cast<size_t>(ReadInteger(reader, key));
+                else if(!ReadStatisticsMember(reader, key, benchmark.nanosPerIteration)) reader.SkipValue();
+            }
+        }
+
+        void ReadAllocations(JsonReader& reader, AllocationStatistics& allocations)
+        {
+            ExpectToken(reader, JsonToken::BeginObject, "allocations");
+            while(reader.Next() == JsonToken::Key)
+            {
+                const JsonStringRef key = reader.GetString();
+                if(key == "count") allocations.nAllocations = static_cast<uint64_t>(ReadInteger(reader, key));
+                else if(key == "bytes") allocations.allocatedBytes = static_cast<uint64_t>(ReadInteger(reader, key));
+                else if(key == "peak-live-bytes") allocations.peakLiveBytes = ReadInteger(reader, key);
+                else if(key == "leaked-bytes") allocations.leakedBytes = ReadInteger(reader, key);
+                else reader.SkipValue();
+            }
+        }
+
+        //Events the machine could not count were left out & stay at -1
+        void ReadHardwareCounters(JsonReader& reader, HardwareCounterStatistics& counters)
+        {
+            ExpectToken(reader, JsonToken::BeginObject, "hardware-counters");
+            while(reader.Next() == JsonToken::Key)
+            {
+                const JsonStringRef key = reader.GetString();
+                if(key == "cycles") counters.cycles = ReadInteger(reader, key);
+                else if(key == "instructions") counters.instructions = ReadInteger(reader, key);
+                else if(key == "branch-misses") counters.branchMisses = ReadInteger(reader, key);
+                else if(key == "l1d-read-misses") counters.l1dReadMisses = ReadInteger(reader, key);
+                else if(key == "llc-read-misses") counters.llcReadMisses = ReadInteger(reader, key);
+                else reader.SkipValue();
+            }
+        }
+
+        void ReadRepeat(JsonReader& reader, RepeatStatistics& repeat)
+        {
+            ExpectToken(reader, JsonToken::BeginObject, "repeat");
+            while(reader.Next() == JsonToken::Key)
+            {
+                const JsonStringRef key = reader.GetString();
+                if(key == "iterations") repeat.nIterations = static_cast<size_t>(ReadInteger(reader, key));
+                else if(key == "failed-iterations") repeat.nFailedIterations = static_cast<size_t>(ReadInteger(reader, key));
+                else if(key == "first-failed-iteration") repeat.firstFailedIteration = static_cast<size_t>(ReadInteger(reader, key));
+                else if(!ReadStatisticsMember(reader, key, repeat.wallNanos)) reader.SkipValue();
+            }
+            repeat.wallNanos.nSamples = repeat.nIterations;
+        }
+
+        void ReadAssertions(JsonReader& reader, vector<AssertResult>& assertionResults)
+        {
+            ExpectToken(reader, JsonToken::BeginArray, "assertions");
+            JsonToken token;
+            while((token = reader.Next()) == JsonToken::BeginObject)
+            {
+                AssertResult assertResult{AssertType::plain_assert, false, "", ""};
+                while(reader.Next() == JsonToken::Key)
+                {
+                    const JsonStringRef key = reader.GetString();
+                    if(key == "type")
+                    {
+                        ExpectToken(reader, JsonToken::String, key);
+                        assertResult.assertType = ParseAssertType(reader.GetString());
+                    }
+                    else if(key == "passed") assertResult.passed = ReadBool(reader, key);
+                    else if(key == "description") assertResult.description = ReadString(reader, key);
+                    else if(key == "details") assertResult.additionalDetails = ReadString(reader, key);
+                    else reader.SkipValue();
+                }
+                assertionResults.push_back(move(assertResult));
+            }
+            if(token != JsonToken::EndArray) ThrowNotAReport("expected assertion objects");
+        }
+
+        void ReadLogs(JsonReader& reader, vector<string>& logs)
+        {
+            ExpectToken(reader, JsonToken::BeginArray, "logs");
+            JsonToken token;
+            while((token = reader.Next()) == JsonToken::String)
+            {
+                logs.push_back(reader.GetString().ToString());
+            }
+            if(token != JsonToken::EndArray) ThrowNotAReport("expected log strings");
+        }
+
+        //Returns whether 'key' is one of a test's own members, i.e. not one of the counts the report works out
+        //from the asserts (those are worked out again from the asserts read) & not an unknown one
+        bool ReadTestMember(JsonReader& reader, JsonStringRef key, TestResults& results)
+        {
+            if(key == "name") results.methodName = ReadString(reader, key);
+            else if(key == "group") results.groupName = ReadString(reader, key);
+            else if(key == "test-time-millis") results.executionTimeMillis = ReadInteger(reader, key);
+            else if(key == "test-time-nanos") results.executionTimeNanos = ReadInteger(reader, key);
+            else if(key == "thread-cpu-time-nanos") results.threadCpuTimeNanos = ReadInteger(reader, key);
+            else if(key == "process-cpu-time-nanos") results.processCpuTimeNanos = ReadInteger(reader, key);
+            else if(key == "benchmark")
+            {
+                results.isBenchmark = true;
+                ReadBenchmark(reader, results.benchmark);
+            }
+            else if(key == "allocations")
+            {
+                results.hasAllocationStatistics = true;
+                ReadAllocations(reader, results.allocations);
+            }
+            else if(key == "hardware-counters")
+            {
+                results.hasHardwareCounters = true;
+                ReadHardwareCounters(reader, results.hardwareCounters);
+            }
+            else if(key == "repeat")
+            {
+                results.isRepeated = true;
+                ReadRepeat(reader, results.repeat);
+            }
+            else if(key == "assertions") ReadAssertions(reader, results.assertionResults);
+            else if(key == "logs") ReadLogs(reader, results.logs);
+            else if(key == "dropped-logs") results.nDroppedLogs = static_cast<size_t>(ReadInteger(reader, key));
+            else
+            {
+                reader.SkipValue();
+                return false;
+            }
+            return true;
+        }
+
+        TestResults MakeEmptyResults()
+        {
+            TestResults results;
+            results.executionTimeMillis = 0;
+            return results;
+        }
+
+        void ReadTestList(JsonReader& reader, vector<TestResults>& results)
+        {
+            ExpectToken(reader, JsonToken::BeginArray, "test-results");
+            JsonToken token;
+            while((token = reader.Next()) == JsonToken::BeginObject)
+            {
+                results.push_back(MakeEmptyResults());
+                while(reader.Next() == JsonToken::Key)
+                {
+                    ReadTestMember(reader, reader.GetString(), results.back());
+                }
+            }
+            if(token != JsonToken::EndArray) ThrowNotAReport("expected test objects");
+        }
+
+        double GetComparedNanos(const TestResults& results)
+        {
+            if(results.isBenchmark) return results.benchmark.nanosPerIteration.median;
+            if(results.isRepeated) return results.repeat.wallNanos.median;
+            return static_cast<double>(results.executionTimeNanos);
+        }
+
+        bool Passed(const TestResults& results)
+        {
+            return results.GetNumberOfPassedAndFailedCases().second == 0;
+        }
+    }
+
+    vector<TestResults> ParseJsonTestResults(char* json, size_t size)
+    {
+        JsonReader reader(json, size);
+        vector<TestResults> results;
+
+        //A report is a single object holding "test-results", JSON Lines are one test object after another
+        JsonToken token;
+        while((token = reader.Next()) != JsonToken::End)
+        {
+            if(token != JsonToken::BeginObject) ThrowNotAReport("expected an object");
+
+            TestResults line = MakeEmptyResults();
+            bool isTest = false;
+            while(reader.Next() == JsonToken::Key)
+            {
+                const JsonStringRef key = reader.GetString();
+                if(key == "test-results") ReadTestList(reader, results);
+                else if(ReadTestMember(reader, key, line)) isTest = true;
+            }
+            if(isTest) results.push_back(move(line));
+        }
+        return results;
+    }
+
+    vector<TestResults> ParseJsonTestResults(string json)
+    {
+        return ParseJsonTestResults(&json[0], json.size());
+    }
+
+    vector<TestResults> LoadJsonTestResults(const string& path)
+    {
+        ifstream file(path, ios::binary | ios::ate);
+        if(!file) throw runtime_error("unable to read test results file " + path);
+
+        string json(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        if(!file.read(&json[0], static_cast<streamsize>(json.size()))) throw runtime_error("unable to read test results file " + path);
+
+        return ParseJsonTestResults(&json[0], json.size());
+    }
+
+    double TestTimeDelta::RelativeDelta() const
+    {
+        return baseNanos > 0.0? DeltaNanos() / baseNanos : 0.0;
+    }
+
+    RunComparison CompareRuns(const vector<TestResults>& baseRun, const vector<TestResults>& currentRun)
+    {
+        struct BaseTest
+        {
+            const TestResults* results;
+            bool matched;
+        };
+
+        unordered_map<string, BaseTest> baseTests;
+        baseTests.reserve(baseRun.size());
+        for(const TestResults& results: baseRun)
+        {
+            baseTests.emplace(StateFile::MakeTestKey(results.groupName, results.methodName), BaseTest{&results, false});
+        }
+
+        RunComparison comparison;
+        for(const TestResults& results: currentRun)
+        {
+            TestId id{results.groupName, results.methodName};
+            const auto found = baseTests.find(StateFile::MakeTestKey(results.groupName, results.methodName));
+            if(found == baseTests.end())
+            {
+                comparison.added.push_back(move(id));
+                continue;
+            }
+
+            BaseTest& baseTest = found->second;
+            baseTest.matched = true;
+
+            const bool passedBefore = Passed(*baseTest.results);
+            const bool passedNow = Passed(results);
+            if(passedBefore && !passedNow) comparison.newlyFailing.push_back(id);
+            else if(!passedBefore && passedNow) comparison.newlyPassing.push_back(id);
+
+            comparison.timeDeltas.push_back(TestTimeDelta{move(id), GetComparedNanos(*baseTest.results), GetComparedNanos(results)});
+        }
+
+        for(const TestResults& results: baseRun)
+        {
+            BaseTest& baseTest = baseTests.at(StateFile::MakeTestKey(results.groupName, results.methodName));
+            if(baseTest.matched) continue;
+
+            //Also keeps a test listed twice in the base run from being reported twice
+            baseTest.matched = true;
+            comparison.removed.push_back(TestId{results.groupName, results.methodName});
+        }
+
+        stable_sort(
+            comparison.timeDeltas.begin(),
+            comparison.timeDeltas.end(),
+            [](const TestTimeDelta& a, const TestTimeDelta& b){ return a.DeltaNanos() > b.DeltaNanos(); }
+        );
+        return comparison;
+    }
+}
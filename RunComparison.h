@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CTest.h"
+
+//Reads JSON reports back & compares two runs, so CI gates can check a run against an earlier one in-process
+namespace CTest
+{
+    using namespace std;
+
+    //Reads a report written by JsonifyTestResults/WriteJsonReport, or the lines written by JsonLinesReporter.
+    //Parses in place, the buffer is modified. Benchmark & repeat statistics come back without their samples,
+    //the report only holds their summaries. Asserts of a type this version does not know read as plain asserts.
+    //Throws JsonParseError on malformed JSON & runtime_error on JSON which is not a report.
+    vector<TestResults> ParseJsonTestResults(char* json, size_t size);
+    vector<TestResults> ParseJsonTestResults(string json);
+
+    //Throws runtime_error if the file cannot be read
+    vector<TestResults> LoadJsonTestResults(const string& path);
+
+    struct TestId
+    {
+        string groupName;
+        string methodName;
+    };
+
+    //Times are a benchmark's median per iteration, a repeated test's median iteration, else the test's wall time
+    struct TestTimeDelta
+    {
+        TestId test;
+        double baseNanos = 0.0;
+        double currentNanos = 0.0;
+
+        double DeltaNanos() const { return currentNanos - baseNanos; }
+        double RelativeDelta() const;   //0 when the base time is 0
+    };
+
+    //Lists keep the order of the current run, removed tests that of the base run
+    struct RunComparison
+    {
+        vector<TestId> newlyFailing;    //Passed in the base run
+        vector<TestId> newlyPassing;    //Failed in the base run
+        vector<TestId> added;           //Only in the current run, whether passing or not
+        vector<TestId> removed;         //Only in the base run
+        vector<TestTimeDelta> timeDeltas;   //Every test in both runs, biggest slowdown first
+    };
+
+    //Tests are matched by group & method name
+    RunComparison CompareRuns(const vector<TestResults>& baseRun, const vector<TestResults>& currentRun);
+}
@@ -0,0 +1,89 @@
+#include "StateFile.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace CTest
+{
+    namespace StateFile
+    {
+        string MakeTestKey(const string& groupName, const string& methodName)
+        {
+            string key = groupName;
+            key.push_back('\0');
+            key += methodName;
+            return key;
+        }
+
+        void AppendEscaped(string& line, const string& value)
+        {
+            for(const char c: value)
+            {
+                switch(c)
+                {
+                    case '\\': line += "\\\\"; break;
+                    case '\t': line += "\\t"; break;
+                    case '\n': line += "\\n"; break;
+                    case '\r': line += "\\r"; break;
+                    default: line.push_back(c);
+                }
+            }
+        }
+
+        bool Unescape(const string& escaped, string& value)
+        {
+            value.clear();
+            for(size_t i = 0; i < escaped.size(); i++)
+            {
+                if(escaped[i] != '\\')
+                {
+                    value.push_back(escaped[i]);
+                    continue;
+                }
+
+                if(++i == escaped.size()) return false;
+                switch(escaped[i])
+                {
+                    case '\\': value.push_back('\\'); break;
+                    case 't': value.push_back('\t'); break;
+                    case 'n': value.push_back('\n'); break;
+                    case 'r': value.push_back('\r'); break;
+                    default: return false;
+                }
+            }
+            return true;
+        }
+
+        vector<string> SplitFields(const string& line)
+        {
+            vector<string> fields(1);
+            for(const char c: line)
+            {
+                if(c == '\t') fields.emplace_back();
+                else fields.back().push_back(c);
+            }
+            return fields;
+        }
+
+        void AppendTestKey(string& line, const string& key)
+        {
+            const size_t separator = key.find('\0');
+            AppendEscaped(line, key.substr(0, separator));
+            line.push_back('\t');
+            AppendEscaped(line, key.substr(separator + 1));
+        }
+
+        void ReplaceFile(const string& temporaryPath, const string& path, const string& kind)
+        {
+            //rename() does not replace an existing file on every platform
+            if(rename(temporaryPath.c_str(), path.c_str()) != 0)
+            {
+                remove(path.c_str());
+                if(rename(temporaryPath.c_str(), path.c_str()) != 0)
+                {
+                    throw runtime_error("unable to replace " + kind + " file " + path);
+                }
+            }
+        }
+    }
+}
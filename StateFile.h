@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//Shared by the small local state files kept between runs (see TestHistory.h & PerformanceBaselines.h).
+//One test per line: <group> TAB <method> followed by TAB separated name=value fields,
+//with backslashes, tabs & line breaks escaped inside a field. Readers ignore unknown fields,
+//so newer fields can be added without breaking older files.
+namespace CTest
+{
+    using namespace std;
+
+    namespace StateFile
+    {
+        //'\0' keeps {"ab", "c"} & {"a", "bc"} apart
+        string MakeTestKey(const string& groupName, const string& methodName);
+
+        void AppendEscaped(string& line, const string& value);
+        bool Unescape(const string& escaped, string& value);
+        vector<string> SplitFields(const string& line);
+
+        //Appends <group> TAB <method> of a key made by MakeTestKey
+        void AppendTestKey(string& line, const string& key);
+
+        //Moves the completely written temporaryPath over path, so an interrupted save never leaves
+        //a truncated file behind. Throws runtime_error naming the 'kind' of file if it cannot.
+        void ReplaceFile(const string& temporaryPath, const string& path, const string& kind);
+    }
+}
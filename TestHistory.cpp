@@ -0,0 +1,128 @@
+#include "TestHistory.h"
+#include "StateFile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+namespace CTest
+{
+    constexpr double TestHistory::durationSmoothing;
+
+    namespace
+    {
+        const char* const historyHeader = "canary-test-history";
+    }
+
+    TestHistory TestHistory::Load(const string& path)
+    {
+        TestHistory history;
+
+        ifstream file(path);
+        if(!file) return history;
+
+        string line;
+        if(!getline(file, line) || line != historyHeader) return history;
+
+        string groupName;
+        string methodName;
+        while(getline(file, line))
+        {
+            const vector<string> fields = StateFile::SplitFields(line);
+            if(fields.size() < 2) continue;
+            if(!StateFile::Unescape(fields[0], groupName) || !StateFile::Unescape(fields[1], methodName)) continue;
+
+            Entry entry;
+            for(size_t i = 2; i < fields.size(); i++)
+            {
+                const string& field = fields[i];
+                if(field == "failed=1")
+                {
+                    entry.failedLastRun = true;
+                }
+                else if(field.compare(0, 6, "nanos=") == 0)
+                {
+                    char* end = nullptr;
+                    const double averageNanos = strtod(field.c_str() + 6, &end);
+                    if(end != field.c_str() + 6 && *end == '\0' && averageNanos >= 0.0)
+                    {
+                        entry.hasDuration = true;
+                        entry.averageNanos = averageNanos;
+                    }
+                }
+            }
+            history.entries[StateFile::MakeTestKey(groupName, methodName)] = entry;
+        }
+        return history;
+    }
+
+    void TestHistory::Save(const string& path) const
+    {
+        const string temporaryPath = path + ".tmp";
+        {
+            ofstream file(temporaryPath, ios::trunc);
+            if(!file) throw runtime_error("unable to write test history file " + temporaryPath);
+
+            string line;
+            file << historyHeader << '\n';
+            for(const auto& keyEntry: entries)
+            {
+                line.clear();
+                StateFile::AppendTestKey(line, keyEntry.first);
+                const Entry& entry = keyEntry.second;
+                line += entry.failedLastRun? "\tfailed=1" : "\tfailed=0";
+                if(entry.hasDuration)
+                {
+                    char nanos[48];
+                    snprintf(nanos, sizeof(nanos), "\tnanos=%.0f", entry.averageNanos);
+                    line += nanos;
+                }
+                line.push_back('\n');
+                file << line;
+            }
+
+            if(!file.flush()) throw runtime_error("unable to write test history file " + temporaryPath);
+        }
+
+        StateFile::ReplaceFile(temporaryPath, path, "test history");
+    }
+
+    void TestHistory::Record(const TestResults& results)
+    {
+        size_t nPassed = 0;
+        size_t nFailed = 0;
+        tie(nPassed, nFailed) = results.GetNumberOfPassedAndFailedCases();
+
+        Entry& entry = entries[StateFile::MakeTestKey(results.groupName, results.methodName)];
+        entry.failedLastRun = nFailed > 0;
+
+        const double nanos = static_cast<double>(results.executionTimeNanos);
+        entry.averageNanos = entry.hasDuration?
+            (1.0 - durationSmoothing) * entry.averageNanos + durationSmoothing * nanos :
+            nanos;
+        entry.hasDuration = true;
+    }
+
+    const TestHistory::Entry* TestHistory::Find(const string& groupName, const string& methodName) const
+    {
+        const auto found = entries.find(StateFile::MakeTestKey(groupName, methodName));
+        return found != entries.end()? &found->second : nullptr;
+    }
+
+    bool TestHistory::FailedLastRun(const string& groupName, const string& methodName) const
+    {
+        const Entry* entry = Find(groupName, methodName);
+        return entry != nullptr && entry->failedLastRun;
+    }
+
+    double TestHistory::ExpectedNanos(const string& groupName, const string& methodName) const
+    {
+        const Entry* entry = Find(groupName, methodName);
+        return entry != nullptr && entry->hasDuration?
+            entry->averageNanos :
+            numeric_limits<double>::infinity();
+    }
+}
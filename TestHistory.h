@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CTest.h"
+
+namespace CTest
+{
+    using namespace std;
+
+    //Outcome & average duration of every test in previous runs, keyed by group & method name,
+    //persisted in a small local state file between runs (see RunOptions::historyFile)
+    class TestHistory
+    {
+    public:
+        struct Entry
+        {
+            bool failedLastRun = false;
+
+            //Exponential moving average of the wall time, only meaningful when hasDuration is set
+            bool hasDuration = false;
+            double averageNanos = 0.0;
+        };
+
+        //Weight of the latest run in averageNanos
+        static constexpr double durationSmoothing = 0.3;
+
+    private:
+        unordered_map<string, Entry> entries;
+
+    public:
+        //A missing file is an empty history, i.e. on the very first run.
+        //Lines which cannot be parsed are skipped.
+        static TestHistory Load(const string& path);
+
+        //Writes to a temporary file first, so an interrupted save never leaves a truncated history behind.
+        //Throws runtime_error if the file cannot be written.
+        void Save(const string& path) const;
+
+        //Tests which did not run keep their previous entry
+        void Record(const TestResults& results);
+
+        //nullptr for tests without any recorded run
+        const Entry* Find(const string& groupName, const string& methodName) const;
+
+        bool FailedLastRun(const string& groupName, const string& methodName) const;
+
+        //Tests without a recorded duration are expected to be long, so that they are never the one left running at the end
+        double ExpectedNanos(const string& groupName, const string& methodName) const;
+
+        size_t Size() const { return entries.size(); }
+    };
+}
@@ -0,0 +1,82 @@
+#include "Watchdog.h"
+
+#include <algorithm>
+
+namespace CTest
+{
+    Watchdog::Watchdog(TOnExpired _onExpired)
+    : onExpired{move(_onExpired)}
+    {
+        //Started last, once every member it touches has been constructed
+        watcher = thread(&Watchdog::WatchLoop, this);
+    }
+
+    Watchdog::~Watchdog()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wakeUp.notify_one();
+        watcher.join();
+    }
+
+    void Watchdog::Start(size_t taskIndex, int64_t timeoutMillis)
+    {
+        const auto now = chrono::steady_clock::now();
+        {
+            lock_guard<mutex> guard(lock);
+            runningTasks[taskIndex] = RunningTask{now, now + chrono::milliseconds(timeoutMillis)};
+        }
+        //The new deadline may be earlier than the one being waited for
+        wakeUp.notify_one();
+    }
+
+    void Watchdog::Finish(size_t taskIndex)
+    {
+        //No need to wake the watcher, it just finds one deadline fewer when it next wakes
+        lock_guard<mutex> guard(lock);
+        runningTasks.erase(taskIndex);
+    }
+
+    void Watchdog::WatchLoop()
+    {
+        unique_lock<mutex> guard(lock);
+        while(!stopping)
+        {
+            if(runningTasks.empty())
+            {
+                wakeUp.wait(guard);
+                continue;
+            }
+
+            //Only as many tasks as there are workers are ever running, a linear scan is enough
+            const auto earliest = min_element(
+                runningTasks.begin(),
+                runningTasks.end(),
+                [](const pair<const size_t, RunningTask>& lhs, const pair<const size_t, RunningTask>& rhs)
+                {
+                    return lhs.second.deadline < rhs.second.deadline;
+                }
+            );
+
+            //Copied, Finish() may erase the task while the lock is released by the wait
+            const auto deadline = earliest->second.deadline;
+            const auto now = chrono::steady_clock::now();
+            if(now < deadline)
+            {
+                wakeUp.wait_until(guard, deadline);
+                continue;
+            }
+
+            const size_t taskIndex = earliest->first;
+            const int64_t elapsedNanos =
+                chrono::duration_cast<chrono::nanoseconds>(now - earliest->second.startTime).count();
+            runningTasks.erase(earliest);
+
+            guard.unlock();
+            onExpired(taskIndex, elapsedNanos);
+            guard.lock();
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace CTest
+{
+    using namespace std;
+
+    //Background thread watching the deadlines of running tasks.
+    //onExpired(taskIndex, elapsedNanos) is invoked on the watchdog thread once a started task
+    //overruns its timeout without having been finished. It may end the process; if it returns,
+    //the task is no longer watched.
+    class Watchdog
+    {
+    public:
+        using TOnExpired = function<void(size_t taskIndex, int64_t elapsedNanos)>;
+
+    private:
+        struct RunningTask
+        {
+            chrono::steady_clock::time_point startTime;
+            chrono::steady_clock::time_point deadline;
+        };
+
+        TOnExpired onExpired;
+        mutex lock;
+        condition_variable wakeUp;
+        unordered_map<size_t, RunningTask> runningTasks;
+        bool stopping = false;
+        thread watcher;
+
+        void WatchLoop();
+
+    public:
+        explicit Watchdog(TOnExpired onExpired);
+        ~Watchdog();
+
+        Watchdog(const Watchdog&) = delete;
+        Watchdog& operator=(const Watchdog&) = delete;
+
+        void Start(size_t taskIndex, int64_t timeoutMillis);
+        void Finish(size_t taskIndex);
+    };
+}
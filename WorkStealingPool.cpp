@@ -0,0 +1,113 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace CTest
+{
+    WorkStealingPool::WorkStealingPool(size_t nWorkers)
+    {
+        const size_t nQueues = max<size_t>(nWorkers, 1);
+        for(size_t i = 0; i < nQueues; i++)
+        {
+            queues.emplace_back(make_unique<WorkerQueue>());
+        }
+    }
+
+    size_t WorkStealingPool::WorkerCount() const
+    {
+        return queues.size();
+    }
+
+    bool WorkStealingPool::PopOwnTask(size_t workerIndex, size_t& taskIndex)
+    {
+        WorkerQueue& queue = *queues[workerIndex];
+        lock_guard<mutex> guard(queue.lock);
+        if(queue.taskIndices.empty()) return false;
+
+        taskIndex = queue.taskIndices.front();
+        queue.taskIndices.pop_front();
+        return true;
+    }
+
+    bool WorkStealingPool::StealTask(size_t thiefIndex, size_t& taskIndex)
+    {
+        //Start with the next worker along rather than always worker 0
+        //to spread contention when several workers run dry at once
+        for(size_t offset = 1; offset < queues.size(); offset++)
+        {
+            WorkerQueue& victim = *queues[(thiefIndex + offset) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if(victim.taskIndices.empty()) continue;
+
+            taskIndex = victim.taskIndices.back();
+            victim.taskIndices.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void WorkStealingPool::WorkerLoop(size_t workerIndex, const function<void(size_t)>& task)
+    {
+        size_t taskIndex = 0;
+        //No new tasks are queued once Run() has started,
+        //so a worker which finds every queue empty can stop for good
+        while(PopOwnTask(workerIndex, taskIndex) || StealTask(workerIndex, taskIndex))
+        {
+            task(taskIndex);
+        }
+    }
+
+    void WorkStealingPool::Run(const vector<size_t>& taskOrder, const function<void(size_t)>& task)
+    {
+        for(size_t i = 0; i < taskOrder.size(); i++)
+        {
+            queues[i % queues.size()]->taskIndices.push_back(taskOrder[i]);
+        }
+
+        mutex exceptionLock;
+        exception_ptr firstException;
+        atomic<bool> failed{false};
+
+        auto guardedTask = [&](size_t taskIndex)
+        {
+            if(failed.load()) return;
+            try
+            {
+                task(taskIndex);
+            }
+            catch(...)
+            {
+                lock_guard<mutex> guard(exceptionLock);
+                if(!firstException) firstException = current_exception();
+                failed.store(true);
+            }
+        };
+        const function<void(size_t)> workerTask = guardedTask;
+
+        vector<thread> helpers;
+        for(size_t i = 1; i < queues.size(); i++)
+        {
+            helpers.emplace_back([this, i, &workerTask]{ WorkerLoop(i, workerTask); });
+        }
+        //The calling thread doubles as worker 0
+        WorkerLoop(0, workerTask);
+
+        for(thread& helper: helpers)
+        {
+            helper.join();
+        }
+
+        if(firstException) rethrow_exception(firstException);
+    }
+
+    size_t ResolveWorkerCount(size_t requestedJobs)
+    {
+        if(requestedJobs != 0) return requestedJobs;
+
+        const size_t hardwareThreads = thread::hardware_concurrency();
+        return hardwareThreads != 0? hardwareThreads : 1;
+    }
+}
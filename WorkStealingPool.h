@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace CTest
+{
+    using namespace std;
+
+    //Fixed-size pool of worker threads for running a known batch of independent tasks.
+    //Tasks are dealt round-robin into one deque per worker, each worker drains its own deque
+    //from the front and steals from the back of the other workers' deques once it runs dry,
+    //so a few slow tasks do not leave the remaining workers idle.
+    class WorkStealingPool
+    {
+        struct WorkerQueue
+        {
+            mutex lock;
+            deque<size_t> taskIndices;
+        };
+
+        vector<unique_ptr<WorkerQueue>> queues;
+
+        bool PopOwnTask(size_t workerIndex, size_t& taskIndex);
+        bool StealTask(size_t thiefIndex, size_t& taskIndex);
+        void WorkerLoop(size_t workerIndex, const function<void(size_t)>& task);
+
+    public:
+        WorkStealingPool(size_t nWorkers);
+
+        size_t WorkerCount() const;
+
+        //Invokes task(i) once for every index in taskOrder, blocking until all tasks have completed.
+        //Tasks are started roughly in the order given. The first exception thrown by a task
+        //is rethrown on the calling thread once every worker has stopped.
+        void Run(const vector<size_t>& taskOrder, const function<void(size_t)>& task);
+    };
+
+    //0 requests one worker per hardware thread
+    size_t ResolveWorkerCount(size_t requestedJobs);
+}
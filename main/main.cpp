@@ -6,7 +6,12 @@ using namespace std;
 
 int main()
 {
-    const auto testResults = CTest::Canary::Instance().RunAllTests();
+    CTest::RunOptions options;
+    options.detailVerbosity = CTest::TextLogVerbosity::alwaysPrintAdditionalDetails;
+    //Fixtures are only meant to be run by the tests which check them (see tests\fixture_toggle.h)
+    CTest::TestQuery query;
+    query.excludeTags = {"fixture"};
+    const auto testResults = CTest::Canary::Instance().RunQuery(query, options);
 
     const string txtReport = CTest::FormatAsText(testResults, CTest::TextLogVerbosity::alwaysPrintAdditionalDetails);
     const string jsonReport = CTest::JsonifyTestResults(testResults);
@@ -0,0 +1,113 @@
+#include "..\CTest.h"
+#include "..\AllocationTracking.h"
+#include "..\JsonWriter.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST_GROUPED_METHOD(Allocation_Fixture_Vector, "allocation fixture")
+{
+    vector<int> values(1000);
+    //Short enough for the small string optimization, so the only allocation is the vector's
+    test.assert(values.size() == 1000, "1) sized");
+}
+
+TEST_GROUPED_METHOD(Allocation_Counters_Per_Scope, "allocation")
+{
+    if(!CTest::IsAllocationTrackingEnabled()) return;
+
+    CTest::AllocationCounters outer;
+    CTest::AllocationCounters inner;
+    unique_ptr<int[]> leaked;
+    {
+        const CTest::AllocationScope outerScope(outer);
+        {
+            const CTest::AllocationScope innerScope(inner);
+            leaked.reset(new int[16]);
+
+            //volatile, otherwise the new/delete pair may be optimized away entirely
+            int* volatile block = new int[256];
+            delete[] block;
+        }
+        {
+            const CTest::AllocationTrackingPause pause;
+            int* volatile block = new int[4];
+            delete[] block;
+        }
+    }
+
+    test.assert(inner.nAllocations == 2 && inner.nDeallocations == 1, "1) Allocations & deallocations counted");
+    test.assert_eq(inner.allocatedBytes, uint64_t(272 * sizeof(int)), "2) Bytes counted");
+    test.assert_eq(inner.liveBytes, int64_t(16 * sizeof(int)), "3) Unfreed bytes still live");
+    test.assert_eq(inner.peakLiveBytes, int64_t(272 * sizeof(int)), "4) Peak live bytes");
+    test.assert(outer.nAllocations == inner.nAllocations && outer.allocatedBytes == inner.allocatedBytes, "5) Counted against enclosing scopes too");
+}
+
+TEST_GROUPED_METHOD(Allocation_Statistics_Recorded, "allocation")
+{
+    const auto results = CTest::Canary::Instance().RunTestGroup("allocation fixture");
+    test.assert_eq(results.size(), size_t(1), "1) Fixture ran");
+    if(results.size() != 1) return;
+
+    const CTest::TestResults& result = results.front();
+    if(!CTest::IsAllocationTrackingEnabled())
+    {
+        test.assert(!result.hasAllocationStatistics, "2) Nothing recorded without CANARY_TRACK_ALLOCATIONS");
+        return;
+    }
+
+    test.assert(result.hasAllocationStatistics, "2) Statistics recorded");
+    test.assert(
+        result.allocations.nAllocations == 1 &&
+        result.allocations.allocatedBytes == 1000 * sizeof(int) &&
+        result.allocations.peakLiveBytes == int64_t(1000 * sizeof(int)) &&
+        result.allocations.leakedBytes == 0,
+        "3) Only the test's own allocation counted, not the recorded asserts"
+    );
+    test.assert(
+        CTest::JsonifyTestResults(results).find("\"peak-live-bytes\":4000") != string::npos,
+        "4) Statistics in JSON report"
+    );
+    test.assert(
+        CTest::FormatAsText(results).find("Allocations: 1 (4000 bytes)") != string::npos,
+        "5) Statistics in text report"
+    );
+}
+
+TEST_GROUPED_METHOD(Allocation_Budget_Asserts, "allocation")
+{
+    CTest::TestResults results;
+    CTest::Tester tester(results);
+
+    tester.assert_max_allocations(0, []{ int onStack[4] = {}; (void)onStack; }, "no allocations");
+    tester.assert_max_allocations(1, []{ vector<int> values(10); values.resize(1000); }, "reallocates");
+    tester.assert_max_peak_bytes(100, []{ vector<char> buffer(1000); }, "over budget");
+
+    test.assert_eq(results.assertionResults.size(), size_t(3), "1) Asserts recorded");
+    if(results.assertionResults.size() != 3) return;
+
+    if(!CTest::IsAllocationTrackingEnabled())
+    {
+        test.assert(
+            !results.assertionResults[0].passed &&
+            results.assertionResults[0].additionalDetails.find("CANARY_TRACK_ALLOCATIONS") != string::npos,
+            "2) Budgets fail when they cannot be checked"
+        );
+        return;
+    }
+
+    test.assert(results.assertionResults[0].passed, "2) Allocation free code within budget");
+    test.assert(
+        !results.assertionResults[1].passed &&
+        results.assertionResults[1].assertType == CTest::AssertType::allocation_budget &&
+        results.assertionResults[1].additionalDetails == "Allocations: 2 |Maximum: 1",
+        "3) Allocation count over budget"
+    );
+    test.assert(
+        !results.assertionResults[2].passed &&
+        results.assertionResults[2].additionalDetails == "Peak live bytes: 1000 |Maximum: 100",
+        "4) Peak bytes over budget"
+    );
+}
@@ -86,4 +86,156 @@ TEST_GROUPED_METHOD(GroupMethodFilteredCorrectly, "group B")
         methodNames == vector<string>{"GroupA_Method_1", "GroupA_Method_2"}, 
         "2) Grouped results correctly filtered"
     );
-}
\ No newline at end of file
+}
+struct CountedConversions
+{
+    int value;
+    static int nConversions;
+    bool operator==(const CountedConversions& other) const {return value == other.value;}
+    bool operator!=(const CountedConversions& other) const {return value != other.value;}
+    bool operator<(const CountedConversions& other) const {return value < other.value;}
+};
+int CountedConversions::nConversions = 0;
+
+std::string to_string(const CountedConversions& counted)
+{
+    CountedConversions::nConversions++;
+    return "counted-" + to_string(counted.value);
+}
+
+TEST_METHOD(Check_Expression_Decomposition)
+{
+    using CTest::TestResults;
+    using CTest::Tester;
+    using CTest::TextLogVerbosity;
+    {
+        TestResults results;
+        Tester tester(results, nullptr, TextLogVerbosity::alwaysPrintAdditionalDetails);
+
+        const int one = 1;
+        tester.check((CTest::ExpressionDecomposer() <= one + 1) == 2, "one + 1 == 2");
+        tester.check((CTest::ExpressionDecomposer() <= string("a")) < string("b"), "a < b");
+        tester.check((CTest::ExpressionDecomposer() <= one) >= 2, "one >= 2");
+        tester.check(CTest::ExpressionDecomposer() <= (one == 1), "one == 1");
+
+        test.assert_eq(results.assertionResults.size(), size_t(4), "1) Check recorded");
+        if(results.assertionResults.size() != 4) return;
+
+        test.assert(
+            results.assertionResults[0].passed && 
+            results.assertionResults[0].additionalDetails == "Expansion: 2 == 2" &&
+            results.assertionResults[0].assertType == CTest::AssertType::check,
+            "2) Passing comparison expanded"
+        );
+        test.assert(
+            results.assertionResults[1].passed && results.assertionResults[1].additionalDetails == "Expansion: a < b",
+            "3) String comparison expanded"
+        );
+        test.assert(
+            !results.assertionResults[2].passed && results.assertionResults[2].additionalDetails == "Expansion: 1 >= 2",
+            "4) Failing comparison expanded"
+        );
+        test.assert(
+            results.assertionResults[3].passed && results.assertionResults[3].additionalDetails == "Expansion: true",
+            "5) Plain boolean expanded"
+        );
+    }
+
+    {
+        TestResults results;
+        Tester tester(results);
+
+        CountedConversions::nConversions = 0;
+        for(int i = 0; i < 100; i++)
+        {
+            tester.check((CTest::ExpressionDecomposer() <= CountedConversions{i}) == CountedConversions{i}, "equal");
+            tester.assert_eq(CountedConversions{i}, CountedConversions{i}, "equal");
+            tester.assert_neq(CountedConversions{i}, CountedConversions{i + 1}, "not equal");
+        }
+        test.assert_eq(CountedConversions::nConversions, 0, "6) Passing asserts do not format their values");
+
+        tester.check((CTest::ExpressionDecomposer() <= CountedConversions{2}) < CountedConversions{1}, "less");
+        tester.assert_eq(CountedConversions{1}, CountedConversions{2}, "equal");
+        test.assert_eq(CountedConversions::nConversions, 4, "7) Failing asserts format their values");
+        test.assert(
+            results.assertionResults.back().additionalDetails == "Actual: counted-1 |Expected: counted-2",
+            "8) Failing assert_eq details"
+        );
+    }
+
+    {
+        TestResults results;
+        Tester tester(results, nullptr, TextLogVerbosity::neverPrintAdditionalDetails);
+        tester.assert_eq(1, 2, "never");
+        tester.check((CTest::ExpressionDecomposer() <= 3) < 1, "never");
+        test.assert(
+            results.assertionResults.back().additionalDetails == "Expansion: 3 < 1",
+            "9) Failures recorded even if their details are never printed"
+        );
+        test.assert(
+            CTest::JsonifyTestResults(vector<TestResults>{results}).find("Actual: 1 |Expected: 2") != string::npos,
+            "10) Failure details in the JSON report"
+        );
+        tester.assert_eq(1, 1, "never");
+        test.assert(results.assertionResults.back().additionalDetails.empty(), "11) Passing asserts record nothing");
+    }
+
+    const vector<int> values{1, 2, 3};
+    CHECK(values.size() == size_t(3));
+    CHECK(values.front() < values.back());
+    CHECK(!values.empty());
+}
+
+TEST_METHOD(Require_Stops_Test_Method)
+{
+    using CTest::TestResults;
+    using CTest::Tester;
+
+    auto runBody = [](TestResults& results, const function<void(Tester&)>& body)
+    {
+        Tester tester(results);
+        try
+        {
+            body(tester);
+        }
+        catch(const CTest::AbortTestMethod&)
+        {
+            return true;
+        }
+        return false;
+    };
+
+    TestResults passing;
+    const bool passingStopped = runBody(passing, [](Tester& tester)
+    {
+        tester.require(true, "holds");
+        tester.require_eq(1, 1, "equal");
+        tester.require_neq(1, 2, "not equal");
+        tester.require_nothrow([]{}, "does not throw");
+    });
+    test.assert(!passingStopped && passing.assertionResults.size() == 4, "1) Passing requires carry on");
+
+    TestResults failing;
+    const bool failingStopped = runBody(failing, [](Tester& tester)
+    {
+        tester.require_eq(1, 2, "not equal");
+        tester.assert(true, "never reached");
+    });
+    test.assert(failingStopped, "2) Failing require stops the test");
+    test.assert(
+        failing.assertionResults.size() == 1 && 
+        !failing.assertionResults[0].passed && 
+        failing.assertionResults[0].assertType == CTest::AssertType::assert_equals,
+        "3) Failure recorded like the non-fatal assert"
+    );
+
+    TestResults nested;
+    const bool nestedStopped = runBody(nested, [](Tester& tester)
+    {
+        tester.assert_throw([&tester]{ tester.require(false, "inner"); }, "outer");
+    });
+    test.assert(
+        nestedStopped && nested.assertionResults.size() == 1,
+        "4) A require failing inside assert_throw is not mistaken for the expected exception"
+    );
+}
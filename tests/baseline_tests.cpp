@@ -0,0 +1,185 @@
+#include "..\CTest.h"
+#include "..\PerformanceBaselines.h"
+#include ".\fixture_toggle.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static FixtureToggle baselineFixtureFails;
+
+TEST_FIXTURE_METHOD(Baseline_Fixture_Passing, "baseline fixture")
+{
+    test.assert(true, "Always passes");
+}
+
+TEST_FIXTURE_METHOD(Baseline_Fixture_Toggled, "baseline fixture")
+{
+    test.assert(!baselineFixtureFails.IsSet(), "Fails while baselineFixtureFails is set");
+}
+
+namespace
+{
+    CTest::TestResults MakeBenchmarkResults(const vector<double>& nanosPerIterationSamples)
+    {
+        CTest::TestResults results;
+        results.groupName = "group\twith\\escapes";
+        results.methodName = "Benchmark";
+        results.isBenchmark = true;
+        results.benchmark.nanosPerIterationSamples = nanosPerIterationSamples;
+        return results;
+    }
+
+    const CTest::AssertResult* FindRegressionAssert(const CTest::TestResults& results)
+    {
+        for(const CTest::AssertResult& assertResult: results.assertionResults)
+        {
+            if(assertResult.assertType == CTest::AssertType::performance_regression) return &assertResult;
+        }
+        return nullptr;
+    }
+}
+
+TEST_GROUPED_METHOD(Baseline_Median_Mad_Rule, "baseline")
+{
+    const string path = "canary_baselines_rule.tmp";
+
+    //Median 100, absolute deviations {0, 0, 2, 2, 10} -> MAD 2, scaled 2.9652
+    CTest::PerformanceBaselines recorded;
+    recorded.Record(MakeBenchmarkResults({98.0, 100.0, 100.0, 102.0, 110.0}));
+    recorded.Save(path);
+
+    const CTest::PerformanceBaselines baselines = CTest::PerformanceBaselines::Load(path);
+    remove(path.c_str());
+
+    const CTest::PerformanceBaselines::Entry* entry = baselines.Find("group\twith\\escapes", "Benchmark");
+    test.assert(entry != nullptr && entry->nSamples == 5 && entry->medianNanos == 100.0, "1) Baseline saved & loaded");
+    if(entry == nullptr) return;
+    test.assert(entry->madNanos > 2.96 && entry->madNanos < 2.97, "2) Scaled MAD");
+
+    CTest::BaselineOptions options;
+    options.madFactor = 3.0;
+    options.minRelativeSlowdown = 0.05;
+    options.minSamples = 3;
+
+    //The limit is 100 + max(3 * 2.9652, 5) = 108.9
+    const auto withinNoise = baselines.Compare(MakeBenchmarkResults({107.0, 108.0, 150.0}), options);
+    test.assert(withinNoise.hasBaseline && !withinNoise.regressed, "3) Outlier within noise");
+    test.assert(withinNoise.limitNanos > 108.8 && withinNoise.limitNanos < 109.0, "4) Limit from the MAD");
+
+    const auto slower = baselines.Compare(MakeBenchmarkResults({109.0, 110.0, 111.0}), options);
+    test.assert(slower.regressed && slower.medianNanos == 110.0, "5) Median beyond the limit regressed");
+
+    options.minRelativeSlowdown = 0.2;
+    test.assert(!baselines.Compare(MakeBenchmarkResults({109.0, 110.0, 111.0}), options).regressed, "6) Relative slowdown floor");
+
+    CTest::TestResults unknown = MakeBenchmarkResults({1.0});
+    unknown.methodName = "Unknown";
+    test.assert(!baselines.Compare(unknown, options).hasBaseline, "7) Unknown test has no baseline");
+
+    const auto tooFew = baselines.Compare(MakeBenchmarkResults({500.0, 500.0}), options);
+    test.assert(tooFew.hasBaseline && !tooFew.conclusive && !tooFew.regressed, "8) Too few samples in the run");
+
+    //A single earlier measurement says nothing about the test's jitter
+    CTest::PerformanceBaselines single;
+    single.Record(MakeBenchmarkResults({100.0}));
+    const auto singleRun = single.Compare(MakeBenchmarkResults({150.0}), CTest::BaselineOptions{});
+    test.assert(singleRun.hasBaseline && !singleRun.conclusive && !singleRun.regressed, "9) Too few samples in the baseline");
+}
+
+TEST_GROUPED_METHOD(Baseline_Run_Records_And_Compares, "baseline")
+{
+    const string path = "canary_baselines_run.tmp";
+    remove(path.c_str());
+
+    CTest::RunOptions options;
+    options.baseline.file = path;
+
+    vector<CTest::TestResults> firstRun;
+    {
+        const FixtureToggle::Scope failing(baselineFixtureFails);
+        firstRun = CTest::Canary::Instance().RunTestGroup("baseline fixture", options);
+    }
+    const CTest::PerformanceBaselines recorded = CTest::PerformanceBaselines::Load(path);
+    test.assert_eq(recorded.Size(), size_t(1), "1) Only the passing test gets a baseline");
+    test.assert(
+        firstRun.size() == 2 && FindRegressionAssert(firstRun[0]) == nullptr && FindRegressionAssert(firstRun[1]) == nullptr,
+        "2) Nothing compared on the first run"
+    );
+
+    //Far below anything the fixture can run in, the toggled test still has no baseline
+    auto writeBaseline = [&path](size_t nSamples)
+    {
+        ofstream file(path, ios::trunc);
+        file << "canary-performance-baselines\n";
+        file << "baseline fixture\tBaseline_Fixture_Passing\tsamples=" << nSamples << "\tmedian=0.001\tmad=0.000\n";
+    };
+
+    //A single run against a single earlier run is not compared, the baseline is only refreshed
+    writeBaseline(1);
+    const auto singleRun = CTest::Canary::Instance().RunTestGroup("baseline fixture", options);
+    const CTest::PerformanceBaselines afterSingleRun = CTest::PerformanceBaselines::Load(path);
+    const CTest::PerformanceBaselines::Entry* refreshed = afterSingleRun.Find("baseline fixture", "Baseline_Fixture_Passing");
+    test.assert(
+        singleRun.size() == 2 && FindRegressionAssert(singleRun[0]) == nullptr && FindRegressionAssert(singleRun[1]) == nullptr,
+        "3) Single-sample run not failed against a single-sample baseline"
+    );
+    test.assert(refreshed != nullptr && refreshed->medianNanos > 0.001, "4) Single-sample baseline replaced");
+
+    writeBaseline(5);
+    options.repeat.count = 5;
+    const auto comparedRun = CTest::Canary::Instance().RunTestGroup("baseline fixture", options);
+    const CTest::AssertResult* regression = nullptr;
+    for(const CTest::TestResults& result: comparedRun)
+    {
+        if(result.methodName == "Baseline_Fixture_Passing") regression = FindRegressionAssert(result);
+    }
+    test.assert(regression != nullptr && !regression->passed, "5) Slower than its baseline fails");
+    test.assert(
+        regression != nullptr && regression->additionalDetails.find("|Baseline median: 0.00ns") != string::npos,
+        "6) Medians in the details"
+    );
+    test.assert(
+        CTest::JsonifyTestResults(comparedRun).find("\"type\":\"regression\"") != string::npos,
+        "7) Regression in JSON report"
+    );
+
+    options.baseline.mode = CTest::BaselineMode::update;
+    const auto updateRun = CTest::Canary::Instance().RunTestGroup("baseline fixture", options);
+    const CTest::PerformanceBaselines updated = CTest::PerformanceBaselines::Load(path);
+    remove(path.c_str());
+
+    const CTest::PerformanceBaselines::Entry* entry = updated.Find("baseline fixture", "Baseline_Fixture_Passing");
+    test.assert(entry != nullptr && entry->medianNanos > 0.001 && updated.Size() == 2, "8) Update replaces & adds baselines");
+    test.assert(
+        updateRun.size() == 2 && FindRegressionAssert(updateRun[0]) == nullptr && FindRegressionAssert(updateRun[1]) == nullptr,
+        "9) Nothing compared while updating"
+    );
+}
+
+TEST_GROUPED_METHOD(Time_Budget_Asserts, "baseline")
+{
+    CTest::TestResults results;
+    CTest::Tester tester(results);
+
+    size_t nCalls = 0;
+    tester.assert_max_median_nanos(1000000000, [&nCalls]{ nCalls++; }, "within budget", 5);
+    tester.assert_max_median_nanos(1, []{ this_thread::sleep_for(chrono::microseconds(100)); }, "over budget", 3);
+
+    test.assert_eq(nCalls, size_t(6), "1) Warm-up call & samples");
+    test.assert_eq(results.assertionResults.size(), size_t(2), "2) Asserts recorded");
+    if(results.assertionResults.size() != 2) return;
+
+    test.assert(results.assertionResults[0].passed, "3) Within budget");
+    test.assert(
+        !results.assertionResults[1].passed &&
+        results.assertionResults[1].assertType == CTest::AssertType::time_budget &&
+        results.assertionResults[1].additionalDetails.find("|Maximum: 1ns (3 samples)") != string::npos,
+        "4) Over budget"
+    );
+    test.assert_throw([&tester]{ tester.assert_max_median_nanos(1, []{}, "no samples", 0); }, "5) At least 1 sample");
+}
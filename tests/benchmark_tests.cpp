@@ -0,0 +1,64 @@
+#include "..\CTest.h"
+#include "..\Benchmark.h"
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+BENCHMARK_GROUPED_METHOD(Benchmark_Fixture_Accumulate, "benchmark fixture")
+{
+    vector<int> values(256);
+    iota(values.begin(), values.end(), 0);
+
+    while(bench.KeepRunning())
+    {
+        CTest::DoNotOptimize(accumulate(values.begin(), values.end(), 0));
+    }
+
+    test.assert_eq(accumulate(values.begin(), values.end(), 0), 32640, "Setup outside of the timed loop");
+}
+
+TEST_GROUPED_METHOD(Benchmark_Statistics_Recorded, "benchmark")
+{
+    const auto results = CTest::Canary::Instance().RunTestGroup("benchmark fixture");
+    test.assert_eq(results.size(), size_t(1), "1) Benchmark registered alongside tests");
+    if(results.size() != 1) return;
+
+    const CTest::TestResults& result = results.front();
+    const CTest::SampleStatistics& nanosPerIteration = result.benchmark.nanosPerIteration;
+
+    test.assert(result.isBenchmark, "2) Result flagged as benchmark");
+    test.assert(result.benchmark.iterationsPerSample >= 1, "3) Iterations calibrated");
+    test.assert_eq(nanosPerIteration.nSamples, CTest::BenchmarkRunner::nSamples, "4) All samples recorded");
+    test.assert(
+        nanosPerIteration.min > 0.0 &&
+        nanosPerIteration.min <= nanosPerIteration.median &&
+        nanosPerIteration.median <= nanosPerIteration.p99,
+        "5) min <= median <= p99"
+    );
+    test.assert_eq(result.assertionResults.size(), size_t(1), "6) Asserts only kept from the first invocation");
+
+    test.assert(
+        CTest::JsonifyTestResults(results).find("\"median-nanos\":") != string::npos,
+        "7) Statistics in JSON report"
+    );
+    test.assert(
+        CTest::FormatAsText(results).find("Benchmark: min ") != string::npos,
+        "8) Statistics in text report"
+    );
+}
+
+TEST_GROUPED_METHOD(Sample_Statistics, "benchmark")
+{
+    const CTest::SampleStatistics statistics = CTest::ComputeSampleStatistics({4.0, 1.0, 3.0, 2.0});
+
+    test.assert_eq(statistics.nSamples, size_t(4), "1) Sample count");
+    test.assert(statistics.min == 1.0, "2) Minimum");
+    test.assert(statistics.median == 2.5, "3) Median of even sample count");
+    test.assert(statistics.mean == 2.5, "4) Mean");
+    test.assert(statistics.p99 == 4.0, "5) Nearest-rank p99");
+    test.assert(statistics.stddev > 1.29 && statistics.stddev < 1.30, "6) Sample standard deviation");
+
+    const CTest::SampleStatistics empty = CTest::ComputeSampleStatistics({});
+    test.assert(empty.nSamples == 0 && empty.median == 0.0, "7) No samples");
+}
@@ -0,0 +1,95 @@
+#include "..\CTest.h"
+#include "..\BinaryResults.h"
+#include "..\JsonWriter.h"
+#include ".\report_fixture.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST_GROUPED_METHOD(Binary_Results_Round_Trip, "binary results")
+{
+    const vector<CTest::TestResults> results = MakeReportFixtureResults("binary");
+
+    ostringstream output;
+    CTest::WriteBinaryResults(results, output);
+    const string encoded = output.str();
+
+    const CTest::BinaryResultsReader reader(encoded.data(), encoded.size());
+    test.assert_eq(reader.GetTestCount(), size_t(3), "1) Every test indexed");
+    test.assert(!reader.IsTruncated(), "2) Complete");
+    test.assert(
+        JsonifyTestResults(reader.ReadAll()) == JsonifyTestResults(results),
+        "3) Same JSON report as the original results"
+    );
+
+    //"binary", 3 method names, 2 descriptions, 3 details, 2 logs
+    test.assert_eq(reader.GetStringCount(), size_t(11), "4) Repeated strings stored once");
+
+    const CTest::BinaryTestView plain = reader.GetTest(0);
+    test.assert(plain.GetMethodName() == "Plain" && plain.GetGroupName() == "binary", "5) Names read in place");
+    test.assert(plain.GetAssertCount() == 3 && !plain.AllPassed() && !plain.GetAssert(1).Passed(), "6) Assert entries");
+    test.assert(plain.GetAssert(2).GetDescription() == "shared description", "7) Assert strings");
+    test.assert(plain.GetLogCount() == 2 && plain.GetLog(1) == "second \"log\"\n", "8) Logs");
+    test.assert(plain.GetExecutionTimeNanos() == 12345678 && !plain.IsBenchmark(), "9) Times & flags");
+    test.assert(reader.GetTest(1).AllPassed() && reader.GetTest(1).IsBenchmark(), "10) Statistics flags");
+    test.assert(reader.GetTest(2).GetDroppedLogCount() == 7 && plain.GetDroppedLogCount() == 0, "11) Dropped log counts");
+}
+
+TEST_GROUPED_METHOD(Binary_Results_Truncated_Run, "binary results")
+{
+    const vector<CTest::TestResults> results = MakeReportFixtureResults("binary");
+
+    ostringstream output;
+    CTest::BinaryResultsWriter writer(output);
+    writer.Write(results[0]);
+    const size_t firstTestEnd = output.str().size();
+    writer.Write(results[1]);
+    const string encoded = output.str();
+
+    //As if the run was killed while writing the second test
+    const CTest::BinaryResultsReader reader(encoded.data(), encoded.size() - 3);
+    test.assert(reader.IsTruncated(), "1) Truncation detected");
+    test.assert(
+        reader.GetTestCount() == 1 && reader.GetTest(0).GetMethodName() == "Plain",
+        "2) Tests before the cut still read"
+    );
+    test.assert(encoded.size() - 3 > firstTestEnd, "3) Cut inside the second test");
+
+    const string notBinary = "{\"test-results\":[]}";
+    test.assert_throw([&notBinary]{ CTest::BinaryResultsReader(notBinary.data(), notBinary.size()); }, "4) Rejects other formats");
+
+    string corrupt = encoded.substr(0, firstTestEnd);
+    corrupt[corrupt.size() - 1] = '\x7f';   //Last log id, far beyond the strings written
+    test.assert_throw([&corrupt]{ CTest::BinaryResultsReader(corrupt.data(), corrupt.size()); }, "5) Rejects unknown string ids");
+}
+
+TEST_GROUPED_METHOD(Binary_Results_Mapped_File, "binary results")
+{
+    const string path = "canary_binary_results.tmp";
+    const vector<CTest::TestResults> results = MakeReportFixtureResults("binary");
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        CTest::BinaryResultsWriter writer(file);
+        for(const CTest::TestResults& result: results) writer.OnTestEnd(result);
+    }
+
+    {
+        const CTest::BinaryResultsReader reader = CTest::BinaryResultsReader::Open(path);
+        test.assert_eq(reader.GetTestCount(), size_t(3), "1) Mapped file indexed");
+        test.assert(
+            CTest::ConvertBinaryResultsToText(reader) == CTest::FormatAsText(results),
+            "2) Text converter"
+        );
+
+        ostringstream json;
+        CTest::ConvertBinaryResultsToJson(reader, json, JsonStyle::Compact);
+        test.assert(json.str() == CTest::JsonifyTestResults(results, JsonStyle::Compact), "3) JSON converter");
+    }
+    remove(path.c_str());
+
+    test.assert_throw([&path]{ CTest::BinaryResultsReader::Open(path); }, "4) Missing file");
+}
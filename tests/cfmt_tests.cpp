@@ -1,6 +1,7 @@
 #include "..\CTest.h"
 #include "..\formatter.h"
 #include ".\mock_udf.h"
+#include <limits>
 
 using namespace std;
 
@@ -25,4 +26,50 @@ TEST_METHOD(Formatter_Test)
     test.assert(cfmt("%t", UDF_With_Tostring{}) == "user-defined-tostring", "user-defined to_string for User-Defined Data Types");
 
     test.assert(cfmt("%t%% %%%t", 100, 100) == "100% %100", "No ambiguity between token and escaped percent");
-}
\ No newline at end of file
+}
+TEST_METHOD(Compiled_Formatter_Test)
+{
+    using namespace CTest;
+
+    test.assert_eq(CFMT("Escaped %%")(), string("Escaped %"), "1) Percent correctly escaped");
+    test.assert_eq(CFMT("%%%% Escaped %%%%")(), string("%% Escaped %%"), "2) Percent correctly escaped");
+    test.assert_eq(CFMT("")(), string(""), "3) Empty format");
+
+    test.assert_eq(CFMT("%t dog")(1), string("1 dog"), "int substitution");
+    test.assert_eq(CFMT("%t|%t")(true, false), string("true|false"), "bool reflected as string literal");
+    test.assert_eq(CFMT("%t %tdog")(1, string("cat")), string("1 catdog"), "int, string substitution");
+    test.assert_eq(CFMT("%t")(UDF_With_Tostring{}), string("user-defined-tostring"), "user-defined to_string");
+    test.assert_eq(CFMT("%t%% %%%t")(100, 100), string("100% %100"), "No ambiguity between token and escaped percent");
+
+    const string text = "token";
+    test.assert_eq(CFMT("%t%t")(text, text), cfmt("%t%t", text, text), "Matches runtime cfmt");
+}
+
+TEST_METHOD(Formatter_Append_Test)
+{
+    using namespace CTest;
+
+    string buffer = "prefix:";
+    cfmt_to(buffer, "%t|%t|%t", 0, -7, 1234567890123ULL);
+    test.assert_eq(buffer, string("prefix:0|-7|1234567890123"), "1) Appends to existing contents");
+
+    buffer.clear();
+    cfmt_to(buffer, "%t %t", numeric_limits<long long>::min(), numeric_limits<unsigned long long>::max());
+    test.assert_eq(
+        buffer,
+        to_string(numeric_limits<long long>::min()) + " " + to_string(numeric_limits<unsigned long long>::max()),
+        "2) Integer limits");
+
+    buffer.clear();
+    const char* cString = "c-string";
+    cfmt_to(buffer, string("%t %t %t %t %t"), true, cString, string("std::string"), 'A', UDF_With_Tostring{});
+    test.assert_eq(buffer, string("true c-string std::string 65 user-defined-tostring"), "3) bool, string-likes, char, UDF");
+
+    buffer.clear();
+    cfmt_to(buffer, "%t %t %", 1);
+    test.assert_eq(buffer, string("1 [missing token] [t or % expected after %]"), "4) Malformed formats");
+
+    buffer.clear();
+    cfmt_to(buffer, CFMT("%t%%/%t"), 50, 100u);
+    test.assert_eq(buffer, string("50%/100"), "5) Compiled format");
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <atomic>
+#include "..\CTest.h"
+
+//Fixtures are the tests a test runs itself (i.e. through RunTestGroup) to check what the runner makes of them.
+//They are tagged so that the suite's own run can leave them out (see main.cpp).
+#define TEST_FIXTURE_METHOD(METHOD_NAME, LPSTR_GROUP_NAME) TEST_TAGGED_METHOD(METHOD_NAME, LPSTR_GROUP_NAME, "fixture")
+
+//Makes a fixture fail on demand, only set while the test which owns the fixture runs it.
+//Atomic, so that every worker of a parallel or repeated run sees it.
+class FixtureToggle
+{
+    std::atomic<bool> isSet{false};
+
+public:
+    bool IsSet() const { return isSet.load(); }
+
+    //Sets the toggle until the end of the scope
+    class Scope
+    {
+        FixtureToggle& toggle;
+
+    public:
+        explicit Scope(FixtureToggle& _toggle) : toggle(_toggle) { toggle.isSet = true; }
+        ~Scope() { toggle.isSet = false; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
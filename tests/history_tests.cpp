@@ -0,0 +1,237 @@
+#include "..\CTest.h"
+#include "..\TestHistory.h"
+#include ".\fixture_toggle.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static FixtureToggle historyFixtureFails;
+
+TEST_FIXTURE_METHOD(History_Fixture_Passing_1, "history fixture")
+{
+    test.assert(true, "Always passes");
+}
+
+TEST_FIXTURE_METHOD(History_Fixture_Toggled, "history fixture")
+{
+    test.assert(!historyFixtureFails.IsSet(), "Fails while historyFixtureFails is set");
+}
+
+TEST_FIXTURE_METHOD(History_Fixture_Passing_2, "history fixture")
+{
+    test.assert(true, "Always passes");
+}
+
+static FixtureToggle scheduleFixtureHolds;
+static atomic<size_t> nScheduleFixturesStarted{0};
+
+//Keeps the first test of each of the 2 workers running until the other worker has started its first test too,
+//so that the first 2 tests started are the first 2 handed out by the schedule
+static void HoldUntilBothWorkersStarted()
+{
+    const size_t started = ++nScheduleFixturesStarted;
+    if(!scheduleFixtureHolds.IsSet() || started > 2) return;
+    for(int i = 0; i < 2000 && nScheduleFixturesStarted < 2; i++) this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+TEST_FIXTURE_METHOD(Schedule_Fixture_Short, "schedule fixture") { HoldUntilBothWorkersStarted(); test.assert(true, "Always passes"); }
+TEST_FIXTURE_METHOD(Schedule_Fixture_Medium, "schedule fixture") { HoldUntilBothWorkersStarted(); test.assert(true, "Always passes"); }
+TEST_FIXTURE_METHOD(Schedule_Fixture_Long, "schedule fixture") { HoldUntilBothWorkersStarted(); test.assert(true, "Always passes"); }
+TEST_FIXTURE_METHOD(Schedule_Fixture_Unknown, "schedule fixture") { HoldUntilBothWorkersStarted(); test.assert(true, "Always passes"); }
+
+struct StartOrderListener : public CTest::TestListener
+{
+    vector<string> started;
+    void OnTestStart(const string&, const string& methodName) override { started.push_back(methodName); }
+};
+
+TEST_GROUPED_METHOD(History_Round_Trip, "history")
+{
+    const string path = "canary_history_round_trip.tmp";
+
+    CTest::TestResults failing;
+    failing.groupName = "group\twith\\escapes";
+    failing.methodName = "Failing_Method";
+    failing.assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::plain_assert, false, "", ""});
+
+    CTest::TestResults passing;
+    passing.groupName = "group\twith\\escapes";
+    passing.methodName = "Passing_Method";
+
+    CTest::TestHistory history;
+    history.Record(failing);
+    history.Record(passing);
+    history.Save(path);
+
+    const CTest::TestHistory loaded = CTest::TestHistory::Load(path);
+    remove(path.c_str());
+
+    test.assert_eq(loaded.Size(), size_t(2), "1) All entries loaded");
+    test.assert(loaded.FailedLastRun(failing.groupName, failing.methodName), "2) Failure remembered");
+    test.assert(!loaded.FailedLastRun(passing.groupName, passing.methodName), "3) Pass remembered");
+    test.assert(loaded.Find("group", "Unknown_Method") == nullptr, "4) Unknown test has no entry");
+    test.assert_eq(CTest::TestHistory::Load(path).Size(), size_t(0), "5) Missing file is an empty history");
+}
+
+TEST_GROUPED_METHOD(History_Orders_Previous_Failures, "history")
+{
+    const string path = "canary_history_order.tmp";
+    remove(path.c_str());
+
+    CTest::RunOptions options;
+    options.historyFile = path;
+
+    {
+        const FixtureToggle::Scope failing(historyFixtureFails);
+        CTest::Canary::Instance().RunTestGroup("history fixture", options);
+    }
+
+    StartOrderListener failedFirst;
+    options.listeners = {&failedFirst};
+    options.historyOrder = CTest::HistoryOrder::previouslyFailedFirst;
+    CTest::Canary::Instance().RunTestGroup("history fixture", options);
+
+    test.assert(
+        failedFirst.started == vector<string>{"History_Fixture_Toggled", "History_Fixture_Passing_1", "History_Fixture_Passing_2"},
+        "1) Previous failure runs first, followed by the rest of the selection");
+
+    //The run above passed, so nothing is left to rerun
+    StartOrderListener failedOnly;
+    options.listeners = {&failedOnly};
+    options.historyOrder = CTest::HistoryOrder::previouslyFailedOnly;
+    CTest::Canary::Instance().RunTestGroup("history fixture", options);
+    test.assert(failedOnly.started.empty(), "2) Passing tests are forgotten as failures");
+
+    options.historyOrder = CTest::HistoryOrder::asRegistered;
+    {
+        const FixtureToggle::Scope failing(historyFixtureFails);
+        CTest::Canary::Instance().RunTestGroup("history fixture", options);
+    }
+
+    options.historyOrder = CTest::HistoryOrder::previouslyFailedOnly;
+    const auto rerun = CTest::Canary::Instance().RunTestGroup("history fixture", options);
+    test.assert(
+        rerun.size() == 1 && rerun.front().methodName == "History_Fixture_Toggled",
+        "3) Only the previous failure is rerun");
+
+    remove(path.c_str());
+}
+
+TEST_GROUPED_METHOD(History_Duration_Average, "history")
+{
+    const string path = "canary_history_duration.tmp";
+
+    CTest::TestResults result;
+    result.groupName = "group";
+    result.methodName = "Timed_Method";
+
+    CTest::TestHistory history;
+    result.executionTimeNanos = 1000;
+    history.Record(result);
+    test.assert(history.ExpectedNanos("group", "Timed_Method") == 1000.0, "1) First run taken as is");
+
+    result.executionTimeNanos = 2000;
+    history.Record(result);
+    const double expected = 1000.0 + CTest::TestHistory::durationSmoothing * 1000.0;
+    test.assert(abs(history.ExpectedNanos("group", "Timed_Method") - expected) < 0.5, "2) Later runs are averaged in");
+    test.assert(
+        history.ExpectedNanos("group", "Unknown_Method") == numeric_limits<double>::infinity(),
+        "3) Unknown test expected to be long");
+
+    history.Save(path);
+    const CTest::TestHistory loaded = CTest::TestHistory::Load(path);
+    test.assert(abs(loaded.ExpectedNanos("group", "Timed_Method") - expected) < 0.5, "4) Average survives a round trip");
+
+    //Files written before durations were recorded still load
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        file << "canary-test-history\ngroup\tTimed_Method\tfailed=1\n";
+    }
+    const CTest::TestHistory legacy = CTest::TestHistory::Load(path);
+    remove(path.c_str());
+
+    test.assert(legacy.FailedLastRun("group", "Timed_Method"), "5) Outcome read without a duration");
+    test.assert(
+        legacy.ExpectedNanos("group", "Timed_Method") == numeric_limits<double>::infinity(),
+        "6) Missing duration treated as unknown");
+}
+
+TEST_GROUPED_METHOD(History_Records_Parallel_Durations, "history")
+{
+    const string path = "canary_history_parallel.tmp";
+    remove(path.c_str());
+
+    CTest::RunOptions options;
+    options.historyFile = path;
+    options.jobs = 2;
+    options.historyOrder = CTest::HistoryOrder::previouslyFailedFirst;
+
+    //First run has no durations to schedule by, the second is ordered longest first
+    CTest::Canary::Instance().RunTestGroup("history fixture", options);
+    const auto results = CTest::Canary::Instance().RunTestGroup("history fixture", options);
+
+    const CTest::TestHistory history = CTest::TestHistory::Load(path);
+    remove(path.c_str());
+
+    test.assert_eq(results.size(), size_t(3), "1) Every test runs once");
+    bool allTimed = true;
+    for(const CTest::TestResults& result: results)
+    {
+        const CTest::TestHistory::Entry* entry = history.Find(result.groupName, result.methodName);
+        allTimed = allTimed && entry != nullptr && entry->hasDuration;
+    }
+    test.assert(allTimed, "2) Duration recorded for every test");
+}
+
+TEST_GROUPED_METHOD(History_Schedules_Longest_First, "history")
+{
+    const string path = "canary_history_schedule.tmp";
+    //Medium failed last time, Unknown has never run
+    auto writeHistory = [&path]
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        file << "canary-test-history\n";
+        file << "schedule fixture\tSchedule_Fixture_Short\tfailed=0\tnanos=1000\n";
+        file << "schedule fixture\tSchedule_Fixture_Medium\tfailed=1\tnanos=1000000\n";
+        file << "schedule fixture\tSchedule_Fixture_Long\tfailed=0\tnanos=1000000000\n";
+    };
+    auto firstStarted = [&path](CTest::HistoryOrder order)
+    {
+        CTest::RunOptions options;
+        options.historyFile = path;
+        options.historyOrder = order;
+        options.jobs = 2;
+        StartOrderListener listener;
+        options.listeners = {&listener};
+
+        const FixtureToggle::Scope holding(scheduleFixtureHolds);
+        nScheduleFixturesStarted = 0;
+        CTest::Canary::Instance().RunTestGroup("schedule fixture", options);
+
+        //One per worker, in whichever order the workers got to them
+        vector<string> started(listener.started.begin(), listener.started.begin() + min<size_t>(2, listener.started.size()));
+        sort(started.begin(), started.end());
+        return started;
+    };
+
+    writeHistory();
+    test.assert(
+        firstStarted(CTest::HistoryOrder::asRegistered) == vector<string>{"Schedule_Fixture_Long", "Schedule_Fixture_Unknown"},
+        "1) Unknown & longest tests started first");
+
+    writeHistory();
+    test.assert(
+        firstStarted(CTest::HistoryOrder::previouslyFailedFirst) == vector<string>{"Schedule_Fixture_Medium", "Schedule_Fixture_Unknown"},
+        "2) Previous failure still leads, followed by the longest");
+
+    remove(path.c_str());
+}
@@ -1,6 +1,8 @@
 #include "..\CTest.h"
 #include "..\jsonWriter.h"
 #include <string>
+#include <sstream>
+#include <limits>
 
 std::string RemoveAllWhitespace(const std::string& input)
 {
@@ -79,4 +81,168 @@ TEST_METHOD(Json_Writer_Tests)
             "Nested arrays"
         );
     }
-}
\ No newline at end of file
+}
+
+TEST_METHOD(Json_Writer_Styles)
+{
+    auto makeObject = []
+    {
+        auto obj = make_unique<JsonObject>();
+        obj->AddString("key", "value");
+        obj->AddNode("array", make_json_array(1, "two", false));
+        return obj;
+    };
+
+    test.assert(
+        makeObject()->serialize() == "{\n\"key\":\"value\",\n\"array\":[1,\"two\",false]\n}",
+        "1) Pretty style puts one member per line"
+    );
+
+    test.assert(
+        makeObject()->serialize(JsonStyle::Compact) == R"_({"key":"value","array":[1,"two",false]})_",
+        "2) Compact style has no whitespace"
+    );
+
+    {
+        std::string buffer = "prefix:";
+        SerializeJson(*makeObject(), buffer, JsonStyle::Compact);
+        test.assert(
+            buffer == R"_(prefix:{"key":"value","array":[1,"two",false]})_",
+            "3) Serialized output appended onto existing buffer"
+        );
+    }
+
+    {
+        std::ostringstream stream;
+        SerializeJson(*makeObject(), stream, JsonStyle::Compact);
+        test.assert(
+            stream.str() == makeObject()->serialize(JsonStyle::Compact),
+            "4) Streamed output matches string output"
+        );
+    }
+
+    test.assert(
+        make_json_array()->serialize() == "[]" && make_unique<JsonObject>()->serialize(JsonStyle::Compact) == "{}",
+        "5) Empty containers"
+    );
+
+    test.assert(
+        make_json_array(INT64_MIN, INT64_MAX, 0)->serialize() == "[-9223372036854775808,9223372036854775807,0]",
+        "6) Integer limits"
+    );
+
+    test.assert(
+        make_json_array(1.5, -0.25, 1e20, std::numeric_limits<double>::infinity())->serialize() == "[1.5,-0.25,1e+20,0]",
+        "7) Doubles, non-finite values written as 0"
+    );
+}
+
+TEST_METHOD(Json_Writer_Deep_Nesting)
+{
+    const int depth = 5000;
+    auto nested = make_json_array(0);
+    for(int i = 1; i < depth; i++)
+    {
+        nested = make_json_array(move(nested));
+    }
+
+    std::ostringstream stream;
+    SerializeJson(*nested, stream, JsonStyle::Compact);
+    const std::string serialized = stream.str();
+
+    test.assert_eq(serialized.size(), size_t(2 * depth + 1), "1) Deeply nested arrays serialized without recursion");
+    test.assert(
+        serialized == std::string(depth, '[') + "0" + std::string(depth, ']'), 
+        "2) Deeply nested arrays serialized without recursion"
+    );
+}
+
+TEST_METHOD(Json_String_Escaping)
+{
+    test.assert_eq(EscapeJsonString(R"(a"b\c/d)"), std::string(R"(a\"b\\c\/d)"), "1) Quotes, backslashes & slashes");
+    test.assert_eq(EscapeJsonString("\b\f\n\r\t"), std::string(R"(\b\f\n\r\t)"), "2) Short control escapes");
+    test.assert_eq(
+        EscapeJsonString(std::string("\x01\x1f\x7f", 3) + std::string(1, '\0')),
+        std::string("\\u0001\\u001f\x7f\\u0000"),
+        "3) Remaining control characters as \\u00XX");
+
+    //Long enough to exercise the 16-byte scan as well as the tail
+    const std::string clean(37, 'x');
+    test.assert_eq(EscapeJsonString(clean), clean, "4) Clean runs copied as is");
+    test.assert_eq(
+        EscapeJsonString(clean + "\n" + clean + "\"" ),
+        clean + "\\n" + clean + "\\\"",
+        "5) Escapes after clean runs");
+
+    const std::string utf8 = "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x90\xa4";
+    test.assert_eq(EscapeJsonString(utf8), utf8, "6) Valid UTF-8 kept");
+    test.assert_eq(
+        EscapeJsonString(clean + "\xff" + "a\xc3" + "\xed\xa0\x80"),
+        clean + "\\ufffd" + "a\\ufffd" + "\\ufffd\\ufffd\\ufffd",
+        "7) Invalid UTF-8 replaced");
+    test.assert_eq(
+        EscapeJsonString("\xff\n", Utf8Handling::Passthrough),
+        std::string("\xff\\n"),
+        "8) UTF-8 validation is optional");
+}
+
+TEST_METHOD(Json_Document)
+{
+    JsonDocument document;
+    const JsonDocument::NodeId root = document.GetRoot();
+    document.AddString(root, "key", "value");
+    const JsonDocument::NodeId array = document.AddArray(root, "array");
+    document.AppendInteger(array, 1);
+    document.AppendString(array, "two");
+    document.AppendBool(array, false);
+    document.AppendDouble(array, 1.5);
+    document.AddObject(root, "empty");
+
+    auto tree = make_unique<JsonObject>();
+    tree->AddString("key", "value");
+    tree->AddNode("array", make_json_array(1, "two", false, 1.5));
+    tree->AddNode("empty", make_unique<JsonObject>());
+
+    test.assert_eq(document.serialize(), tree->serialize(), "1) Pretty output matches the JsonNode tree");
+    test.assert_eq(
+        document.serialize(JsonStyle::Compact),
+        tree->serialize(JsonStyle::Compact),
+        "2) Compact output matches the JsonNode tree");
+
+    test.assert_throw([&]{ document.AddBool(root, "key", true); }, "3) Duplicate keys rejected");
+    test.assert_throw([&]{ document.AppendBool(root, true); }, "4) Objects have no elements");
+    test.assert_throw([&]{ document.AddBool(array, "key", true); }, "5) Arrays have no members");
+
+    const JsonDocument::NodeId found = document.FindMember(root, "key");
+    test.assert(
+        found != JsonDocument::noNode && document.GetString(found) == JsonStringRef("value"),
+        "6) Member lookup");
+    test.assert(document.FindMember(root, "missing") == JsonDocument::noNode, "7) Missing member");
+
+    //Past the threshold lookups go through the hashed index
+    const JsonDocument::NodeId wide = document.AddObject(root, "wide");
+    for(int i = 0; i < 100; i++)
+    {
+        document.AddInteger(wide, "member-" + std::to_string(i), i);
+    }
+    test.assert_eq(document.GetChildCount(wide), size_t(100), "8) All members added");
+    test.assert_eq(document.GetInteger(document.FindMember(wide, "member-3")), int64_t(3), "9) Indexed lookup (early member)");
+    test.assert_eq(document.GetInteger(document.FindMember(wide, "member-99")), int64_t(99), "10) Indexed lookup (late member)");
+    test.assert_throw([&]{ document.AddBool(wide, "member-50", true); }, "11) Duplicate keys rejected with the index");
+
+    document.Clear(JsonType::Array);
+    document.AppendString(document.GetRoot(), "\"quoted\"");
+    test.assert_eq(document.serialize(), std::string(R"(["\"quoted\""])"), "12) Cleared document reused");
+    test.assert_throw([&]{ document.Clear(JsonType::String); }, "13) Root must be a container");
+
+    //The emptied key index is reused, without any of the members indexed before the Clear()
+    document.Clear();
+    const JsonDocument::NodeId reindexed = document.AddObject(document.GetRoot(), "wide");
+    for(int i = 0; i < 20; i++)
+    {
+        document.AddInteger(reindexed, "other-" + std::to_string(i), i);
+    }
+    test.assert(document.FindMember(reindexed, "member-3") == JsonDocument::noNode, "14) Earlier index emptied");
+    test.assert_eq(document.GetInteger(document.FindMember(reindexed, "other-17")), int64_t(17), "15) Reused index lookup");
+    test.assert_throw([&]{ document.AddBool(reindexed, "other-1", true); }, "16) Duplicate keys rejected with the reused index");
+}
@@ -0,0 +1,121 @@
+#include "..\CTest.h"
+#include "..\LogBuffer.h"
+#include ".\fixture_toggle.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    size_t nFormattedValues = 0;
+
+    struct CountedValue
+    {
+        int value;
+    };
+
+    string to_string(const CountedValue& counted)
+    {
+        nFormattedValues++;
+        return "counted " + std::to_string(counted.value);
+    }
+}
+
+static FixtureToggle logFixtureFails;
+
+TEST_FIXTURE_METHOD(Log_Fixture_Chatty_Passing, "log fixture")
+{
+    for(int i = 0; i < 5000; i++) test.logf("passing iteration %t", i);
+    test.assert(true, "Always passes");
+}
+
+TEST_FIXTURE_METHOD(Log_Fixture_Chatty_Toggled, "log fixture")
+{
+    for(int i = 0; i < 5000; i++) test.logf("toggled iteration %t", i);
+    test.log("last words");
+    test.assert(!logFixtureFails.IsSet(), "Fails while logFixtureFails is set");
+}
+
+TEST_GROUPED_METHOD(Log_Buffer_Ring, "log buffer")
+{
+    CTest::LogBuffer buffer(3);
+    for(int i = 0; i < 5; i++) buffer.Push("line %t of %t", i, 5);
+    test.assert_eq(buffer.Size(), size_t(3), "1) Bounded");
+    test.assert_eq(buffer.GetDroppedCount(), size_t(2), "2) Overwritten logs counted");
+
+    vector<string> logs;
+    buffer.MoveTo(logs);
+    test.assert(
+        logs == vector<string>({"line 2 of 5", "line 3 of 5", "line 4 of 5"}),
+        "3) Most recent logs, oldest first"
+    );
+    test.assert_eq(buffer.Size(), size_t(0), "4) Emptied");
+
+    CTest::LogBuffer unbounded(0);
+    for(int i = 0; i < 100; i++) unbounded.Push(to_string(i));
+    test.assert(unbounded.Size() == 100 && unbounded.GetDroppedCount() == 0, "5) 0 keeps every log");
+}
+
+TEST_GROUPED_METHOD(Log_Buffer_Deferred_Formatting, "log buffer")
+{
+    nFormattedValues = 0;
+
+    CTest::LogBuffer buffer(4);
+    for(int i = 0; i < 10; i++) buffer.Push("%t at %t%%", CountedValue{i}, 0.5);
+    test.assert_eq(nFormattedValues, size_t(0), "1) Arguments copied, not formatted");
+
+    vector<string> logs;
+    buffer.MoveTo(logs);
+    test.assert_eq(nFormattedValues, size_t(4), "2) Only the logs kept get formatted");
+    test.assert(logs.size() == 4 && logs[0] == "counted 6 at 0.500000%", "3) Formatted with cfmt");
+
+    buffer.Push("%t", CountedValue{1});
+    buffer.Discard();
+    test.assert_eq(nFormattedValues, size_t(4), "4) Discarded logs never formatted");
+
+    //Strings & pointers could change before the log is formatted, so those logs are formatted straight away
+    string name = "before";
+    const char* label = "label";
+    buffer.Push("%t/%t/%t", name, label, 1);
+    name = "after";
+    buffer.MoveTo(logs);
+    test.assert(logs.back() == "before/label/1", "5) Formatted when logged");
+}
+
+TEST_GROUPED_METHOD(Log_Retention_In_Runs, "log buffer")
+{
+    CTest::RunOptions options;
+    options.logs.maxLogsPerTest = 10;
+    options.logs.retention = CTest::LogRetention::failingTestsOnly;
+
+    vector<CTest::TestResults> results;
+    {
+        const FixtureToggle::Scope failing(logFixtureFails);
+        results = CTest::Canary::Instance().RunTestGroup("log fixture", options);
+    }
+
+    test.assert_eq(results.size(), size_t(2), "1) Both tests ran");
+    if(results.size() != 2) return;
+
+    //Failed tests first
+    const CTest::TestResults& failing = results[0];
+    const CTest::TestResults& passing = results[1];
+    test.assert(failing.methodName == "Log_Fixture_Chatty_Toggled", "2) Failing test");
+    test.assert(
+        failing.logs.size() == 10 && failing.logs[8] == "toggled iteration 4999" && failing.logs[9] == "last words",
+        "3) Failing test keeps its most recent logs"
+    );
+    test.assert_eq(failing.nDroppedLogs, size_t(4991), "4) Dropped logs counted");
+    test.assert(passing.logs.empty() && passing.nDroppedLogs == 0, "5) Passing test keeps none");
+    test.assert(
+        CTest::JsonifyTestResults(results).find("\"dropped-logs\":4991") != string::npos,
+        "6) Dropped logs in JSON report"
+    );
+
+    options.logs.retention = CTest::LogRetention::always;
+    for(const CTest::TestResults& result: CTest::Canary::Instance().RunTestGroup("log fixture", options))
+    {
+        test.assert(result.logs.size() == 10 && result.nDroppedLogs > 0, "7) Every test keeps its logs");
+    }
+}
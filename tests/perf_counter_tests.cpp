@@ -0,0 +1,51 @@
+#include "..\CTest.h"
+#include "..\PerfCounters.h"
+#include "..\JsonWriter.h"
+#include <string>
+
+using namespace std;
+
+TEST_GROUPED_METHOD(Perf_Counter_Fixture_Loop, "perf counter fixture")
+{
+    volatile uint64_t sum = 0;
+    for(uint64_t i = 0; i < 100000; i++) sum = sum + i;
+    test.assert(sum > 0, "1) summed");
+}
+
+TEST_GROUPED_METHOD(Perf_Counters_Recorded_When_Requested, "perf counters")
+{
+    const auto uncounted = CTest::Canary::Instance().RunTestGroup("perf counter fixture");
+    test.assert(uncounted.size() == 1 && !uncounted.front().hasHardwareCounters, "1) Not counted by default");
+
+    CTest::RunOptions options;
+    options.countHardwareEvents = true;
+    const auto results = CTest::Canary::Instance().RunTestGroup("perf counter fixture", options);
+    test.assert_eq(results.size(), size_t(1), "2) Fixture ran");
+    if(results.size() != 1) return;
+
+    const CTest::TestResults& result = results.front();
+    test.assert(result.GetNumberOfPassedAndFailedCases().second == 0, "3) Fixture passed");
+
+    //Containers & VMs frequently expose no hardware events at all, the run carries on without them
+    if(!CTest::PerfCounterGroup().IsOpen())
+    {
+        test.assert(!result.hasHardwareCounters, "4) Nothing recorded without perf events");
+        test.assert(
+            CTest::JsonifyTestResults(results).find("hardware-counters") == string::npos,
+            "5) Nothing in JSON report without perf events"
+        );
+        return;
+    }
+
+    test.assert(result.hasHardwareCounters, "4) Counters recorded");
+    const CTest::HardwareCounterStatistics& counters = result.hardwareCounters;
+    test.assert(counters.cycles != 0 && counters.instructions != 0, "5) Available events counted");
+    test.assert(
+        counters.instructions < 0 || counters.instructions >= 100000,
+        "6) Instructions of the test method counted"
+    );
+    test.assert(
+        CTest::JsonifyTestResults(results).find("\"hardware-counters\":{") != string::npos,
+        "7) Counters in JSON report"
+    );
+}
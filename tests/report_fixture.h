@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "..\CTest.h"
+
+//A plain, a benchmarked & a repeated test, filling in every part of TestResults the report formats carry.
+//Plain has 3 asserts sharing a description and 2 logs, for formats which store repeated strings once.
+/*ODR*/ inline std::vector<CTest::TestResults> MakeReportFixtureResults(const std::string& groupName)
+{
+    std::vector<CTest::TestResults> results(3);
+
+    results[0].groupName = groupName;
+    results[0].methodName = "Plain";
+    results[0].executionTimeMillis = 12;
+    results[0].executionTimeNanos = 12345678;
+    results[0].threadCpuTimeNanos = 1234;
+    results[0].processCpuTimeNanos = 5678;
+    results[0].logs = {"first log", "second \"log\"\n"};
+    for(int i = 0; i < 3; i++)
+    {
+        results[0].assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::assert_equals, i != 1, "shared description", "Actual: 1 |Expected: 2"});
+    }
+
+    results[1].groupName = groupName;
+    results[1].methodName = "Benchmarked";
+    results[1].executionTimeMillis = 0;
+    results[1].isBenchmark = true;
+    results[1].benchmark.iterationsPerSample = 64;
+    results[1].benchmark.nanosPerIterationSamples = {1.5, 2.5, 2.0};
+    results[1].benchmark.nanosPerIteration = CTest::ComputeSampleStatistics(results[1].benchmark.nanosPerIterationSamples);
+    results[1].hasAllocationStatistics = true;
+    results[1].allocations = CTest::AllocationStatistics{3, 4096, 2048, 16};
+    results[1].assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::plain_assert, true, "shared description", ""});
+
+    results[2].groupName = groupName;
+    results[2].methodName = "Repeated";
+    results[2].executionTimeMillis = 0;
+    results[2].isRepeated = true;
+    results[2].repeat.nIterations = 4;
+    results[2].repeat.nFailedIterations = 1;
+    results[2].repeat.firstFailedIteration = 2;
+    results[2].repeat.wallNanosSamples = {10.0, 20.0, 30.0, 40.0};
+    results[2].repeat.wallNanos = CTest::ComputeSampleStatistics(results[2].repeat.wallNanosSamples);
+    results[2].hasHardwareCounters = true;
+    results[2].hardwareCounters.cycles = 1000;
+    results[2].hardwareCounters.instructions = 2500;
+    results[2].nDroppedLogs = 7;
+    results[2].assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::timeout, false, "Test method exceeded its timeout", "Ran for 5 ms"});
+    return results;
+}
@@ -0,0 +1,189 @@
+#include "..\CTest.h"
+#include "..\JsonReader.h"
+#include "..\RunComparison.h"
+#include ".\report_fixture.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    CTest::TestResults MakeComparedResults(const string& methodName, bool passed, int64_t executionTimeNanos)
+    {
+        CTest::TestResults results;
+        results.groupName = "compared";
+        results.methodName = methodName;
+        results.executionTimeMillis = executionTimeNanos / 1000000;
+        results.executionTimeNanos = executionTimeNanos;
+        results.assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::plain_assert, passed, "outcome", ""});
+        return results;
+    }
+
+    //The shared fixture, with the strings JSON has to escape or encode
+    vector<CTest::TestResults> MakeJsonFixtureResults()
+    {
+        vector<CTest::TestResults> results = MakeReportFixtureResults("report");
+        results[0].groupName = "report \"group\"";
+        results[0].logs = {"tab\tnewline\n", "caf\xc3\xa9 \xf0\x9f\x98\x80", string("nul\0byte", 8)};
+        results[0].assertionResults.emplace_back(CTest::AssertResult{CTest::AssertType::time_budget, true, "fast enough", "\\back\\slash"});
+        return results;
+    }
+
+    bool ContainsTest(const vector<CTest::TestId>& tests, const string& methodName)
+    {
+        for(const CTest::TestId& id: tests)
+        {
+            if(id.methodName == methodName) return true;
+        }
+        return false;
+    }
+}
+
+TEST_GROUPED_METHOD(Json_Reader_Tokens, "run comparison")
+{
+    string json = "{\"a\\\"b\":[1,-2.5e1,true,null,\"\\u00e9\\ud83d\\ude00\\ud800x\"], \"skipped\":{\"x\":[{}]}, \"n\":123456789012}";
+    JsonReader reader(&json[0], json.size());
+
+    test.assert(reader.Next() == JsonToken::BeginObject, "1) Object");
+    test.assert(reader.Next() == JsonToken::Key && reader.GetString() == "a\"b", "2) Key unescaped in place");
+    test.assert(reader.Next() == JsonToken::BeginArray && reader.GetDepth() == 2, "3) Nested array");
+    test.assert(reader.Next() == JsonToken::Integer && reader.GetInteger() == 1, "4) Integer");
+    test.assert(reader.Next() == JsonToken::Double && reader.GetDouble() == -25.0, "5) Double");
+    test.assert(reader.Next() == JsonToken::Boolean && reader.GetBool(), "6) Boolean");
+    test.assert(reader.Next() == JsonToken::Null, "7) Null");
+    test.assert(
+        reader.Next() == JsonToken::String && reader.GetString() == "\xc3\xa9\xf0\x9f\x98\x80\xef\xbf\xbdx",
+        "8) \\u escapes & surrogate pairs to UTF-8, lone surrogates replaced"
+    );
+    test.assert(reader.Next() == JsonToken::EndArray, "9) End of array");
+
+    test.assert(reader.Next() == JsonToken::Key && reader.GetString() == "skipped", "10) Key before skipped value");
+    reader.SkipValue();
+    test.assert(reader.Next() == JsonToken::Key && reader.GetString() == "n", "11) Nested containers skipped");
+    test.assert(reader.Next() == JsonToken::Integer && reader.GetInteger() == 123456789012LL, "12) 64-bit integer");
+    test.assert(reader.Next() == JsonToken::EndObject && reader.Next() == JsonToken::End, "13) End of input");
+
+    auto parse = [](string malformed)
+    {
+        JsonReader malformedReader(&malformed[0], malformed.size());
+        while(malformedReader.Next() != JsonToken::End) {}
+    };
+    test.assert_throw([&parse]{ parse("[1,]"); }, "14) Trailing comma");
+    test.assert_throw([&parse]{ parse("{\"a\" 1}"); }, "15) Missing colon");
+    test.assert_throw([&parse]{ parse("[\"unterminated]"); }, "16) Unterminated string");
+    test.assert_throw([&parse]{ parse("[\"bad\\q\"]"); }, "17) Invalid escape");
+    test.assert_throw([&parse]{ parse("{\"a\":[1}"); }, "18) Mismatched brackets");
+    test.assert_throw([&parse]{ parse("[01.]"); }, "19) Malformed number");
+    test.assert_nothrow([&parse]{ parse("{}\n[]\n\"line\"\n"); }, "20) Several top-level values");
+
+    string truncated = "{\"a\":tru";
+    try
+    {
+        parse(truncated);
+        test.assert(false, "21) Offset of the error");
+    }
+    catch(const JsonParseError& error)
+    {
+        test.assert_eq(error.GetOffset(), size_t(5), "21) Offset of the error");
+    }
+}
+
+TEST_GROUPED_METHOD(Json_Report_Round_Trip, "run comparison")
+{
+    const vector<CTest::TestResults> results = MakeJsonFixtureResults();
+    const string report = CTest::JsonifyTestResults(results);
+
+    const vector<CTest::TestResults> parsed = CTest::ParseJsonTestResults(report);
+    test.assert_eq(parsed.size(), size_t(3), "1) Every test read");
+    test.assert(CTest::JsonifyTestResults(parsed) == report, "2) Same report written again");
+    test.assert(
+        parsed.size() == 3 && parsed[0].logs == results[0].logs && parsed[0].groupName == results[0].groupName,
+        "3) Escaped strings read back exactly"
+    );
+    test.assert(
+        parsed.size() == 3 && parsed[0].assertionResults.size() == 4 &&
+        parsed[0].assertionResults[3].assertType == CTest::AssertType::time_budget,
+        "4) Assert types by name"
+    );
+    test.assert(
+        parsed.size() == 3 && parsed[2].hardwareCounters.branchMisses == -1 && parsed[2].repeat.wallNanos.nSamples == 4,
+        "5) Statistics"
+    );
+
+    ostringstream lines;
+    CTest::JsonLinesReporter reporter(lines);
+    for(const CTest::TestResults& result: results) reporter.OnTestEnd(result);
+    test.assert(
+        CTest::JsonifyTestResults(CTest::ParseJsonTestResults(lines.str())) == report,
+        "6) JSON Lines"
+    );
+
+    const string path = "canary_run_comparison.tmp";
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        CTest::WriteJsonReport(results, file, JsonStyle::Compact);
+    }
+    test.assert_eq(CTest::LoadJsonTestResults(path).size(), size_t(3), "7) Loaded from a file");
+    remove(path.c_str());
+
+    test.assert_throw([]{ CTest::ParseJsonTestResults("[1, 2]"); }, "8) Not a report");
+    test.assert_throw([]{ CTest::ParseJsonTestResults("{\"test-results\":[{\"name\":1}]}"); }, "9) Wrong member type");
+    test.assert_throw([&path]{ CTest::LoadJsonTestResults(path); }, "10) Missing file");
+}
+
+TEST_GROUPED_METHOD(Run_Comparison_Categories, "run comparison")
+{
+    const vector<CTest::TestResults> baseRun = {
+        MakeComparedResults("Stable", true, 1000),
+        MakeComparedResults("Breaks", true, 1000),
+        MakeComparedResults("Fixed", false, 1000),
+        MakeComparedResults("Removed", true, 1000),
+    };
+    const vector<CTest::TestResults> currentRun = {
+        MakeComparedResults("Added", false, 1000),
+        MakeComparedResults("Fixed", true, 1500),
+        MakeComparedResults("Breaks", false, 500),
+        MakeComparedResults("Stable", true, 3000),
+    };
+
+    const CTest::RunComparison comparison = CTest::CompareRuns(baseRun, currentRun);
+    test.assert(comparison.newlyFailing.size() == 1 && ContainsTest(comparison.newlyFailing, "Breaks"), "1) Newly failing");
+    test.assert(comparison.newlyPassing.size() == 1 && ContainsTest(comparison.newlyPassing, "Fixed"), "2) Newly passing");
+    test.assert(comparison.added.size() == 1 && ContainsTest(comparison.added, "Added"), "3) Added");
+    test.assert(comparison.removed.size() == 1 && ContainsTest(comparison.removed, "Removed"), "4) Removed");
+
+    test.assert_eq(comparison.timeDeltas.size(), size_t(3), "5) Deltas of the tests in both runs");
+    if(comparison.timeDeltas.size() != 3) return;
+    test.assert(
+        comparison.timeDeltas[0].test.methodName == "Stable" && comparison.timeDeltas[0].DeltaNanos() == 2000.0,
+        "6) Biggest slowdown first"
+    );
+    test.assert(
+        comparison.timeDeltas[2].test.methodName == "Breaks" && comparison.timeDeltas[2].RelativeDelta() == -0.5,
+        "7) Speed-ups last"
+    );
+
+    //Benchmarks are compared by their time per iteration, not by the time taken to run all the samples
+    vector<CTest::TestResults> benchmarkBase = {MakeComparedResults("Benchmark", true, 1000000)};
+    benchmarkBase[0].isBenchmark = true;
+    benchmarkBase[0].benchmark.nanosPerIteration.median = 10.0;
+    vector<CTest::TestResults> benchmarkCurrent = benchmarkBase;
+    benchmarkCurrent[0].benchmark.nanosPerIteration.median = 12.0;
+    const CTest::RunComparison benchmarkComparison = CTest::CompareRuns(benchmarkBase, benchmarkCurrent);
+    test.assert(
+        benchmarkComparison.timeDeltas.size() == 1 && benchmarkComparison.timeDeltas[0].DeltaNanos() == 2.0,
+        "8) Benchmark median per iteration"
+    );
+
+    //The usual use, comparing against the report of an earlier run
+    const vector<CTest::TestResults> loadedBase = CTest::ParseJsonTestResults(CTest::JsonifyTestResults(baseRun));
+    const CTest::RunComparison loadedComparison = CTest::CompareRuns(loadedBase, currentRun);
+    test.assert(
+        loadedComparison.newlyFailing.size() == 1 && loadedComparison.removed.size() == 1 && loadedComparison.timeDeltas.size() == 3,
+        "9) Against a loaded report"
+    );
+}
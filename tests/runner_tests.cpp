@@ -0,0 +1,741 @@
+#include "..\CTest.h"
+#include "..\ForkedWorkerPool.h"
+#include "..\JsonWriter.h"
+#include "..\Watchdog.h"
+#include ".\fixture_toggle.h"
+#include <atomic>
+#include <string>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+
+TEST_GROUPED_METHOD(Parallel_Fixture_Passing_1, "parallel fixture")
+{
+    test.assert(true, "1) parallel fixture");
+}
+
+TEST_GROUPED_METHOD(Parallel_Fixture_Passing_2, "parallel fixture")
+{
+    test.assert_eq(2, 2, "2) parallel fixture");
+}
+
+TEST_GROUPED_METHOD(Parallel_Fixture_Passing_3, "parallel fixture")
+{
+    test.log("3) parallel fixture");
+    test.assert_neq(3, 4, "3) parallel fixture");
+}
+
+TEST_GROUPED_METHOD(Parallel_Fixture_Passing_4, "parallel fixture")
+{
+    test.assert(true, "4a) parallel fixture");
+    test.assert(true, "4b) parallel fixture");
+}
+
+vector<string> SummarizeResults(const vector<CTest::TestResults>& results)
+{
+    vector<string> summary;
+    std::transform(
+        results.begin(), results.end(),
+        back_inserter(summary),
+        [](const CTest::TestResults& result)
+        {
+            size_t nPassed = 0;
+            size_t nFailed = 0;
+            tie(nPassed, nFailed) = result.GetNumberOfPassedAndFailedCases();
+            return result.groupName + "/" + result.methodName + "/" + to_string(nPassed) + "/" + to_string(nFailed);
+        }
+    );
+    return summary;
+}
+
+TEST_GROUPED_METHOD(Parallel_Run_Matches_Sequential_Run, "runner")
+{
+    auto sequentialResults = CTest::Canary::Instance().RunTestGroup("parallel fixture");
+
+    CTest::RunOptions parallelOptions;
+    parallelOptions.jobs = 3;
+    auto parallelResults = CTest::Canary::Instance().RunTestGroup("parallel fixture", parallelOptions);
+
+    test.assert_eq(parallelResults.size(), sequentialResults.size(), "1) All tests executed in parallel");
+    test.assert(
+        SummarizeResults(parallelResults) == SummarizeResults(sequentialResults),
+        "2) Parallel results identical to sequential results"
+    );
+
+    parallelOptions.jobs = 0;
+    auto hardwareParallelResults = CTest::Canary::Instance().RunTestGroup("parallel fixture", parallelOptions);
+    test.assert(
+        SummarizeResults(hardwareParallelResults) == SummarizeResults(sequentialResults),
+        "3) One job per hardware thread"
+    );
+}
+
+TEST_GROUPED_METHOD(Forked_Run_Matches_Sequential_Run, "runner")
+{
+    if(!CTest::ForkedWorkerPool::IsSupported()) return;
+
+    auto sequentialResults = CTest::Canary::Instance().RunTestGroup("parallel fixture");
+
+    CTest::RunOptions forkedOptions;
+    forkedOptions.jobs = 2;
+    forkedOptions.isolation = CTest::ExecutionIsolation::forkedProcesses;
+    auto forkedResults = CTest::Canary::Instance().RunTestGroup("parallel fixture", forkedOptions);
+
+    test.assert(
+        SummarizeResults(forkedResults) == SummarizeResults(sequentialResults),
+        "1) Forked results identical to sequential results"
+    );
+
+    const auto loggingResult = std::find_if(
+        forkedResults.begin(), forkedResults.end(),
+        [](const CTest::TestResults& result){ return result.methodName == "Parallel_Fixture_Passing_3"; }
+    );
+    test.assert(
+        loggingResult != forkedResults.end() && loggingResult->logs == vector<string>{"3) parallel fixture"},
+        "2) Logs sent back from worker process"
+    );
+}
+
+TEST_GROUPED_METHOD(Forked_Worker_Crash_Isolated, "runner")
+{
+    if(!CTest::ForkedWorkerPool::IsSupported()) return;
+
+    const size_t nTasks = 5;
+    const size_t crashingTask = 1;
+    vector<CTest::TestResults> results(nTasks);
+
+    CTest::ForkedWorkerPool pool(2);
+    pool.Run(
+        vector<size_t>{0, 1, 2, 3, 4},
+        [crashingTask](size_t taskIndex)
+        {
+            if(taskIndex == crashingTask) raise(SIGSEGV);
+
+            CTest::TestResults result;
+            result.methodName = "task " + to_string(taskIndex);
+            result.executionTimeMillis = 0;
+            result.assertionResults.emplace_back(
+                CTest::AssertResult{CTest::AssertType::plain_assert, true, "ran in worker", ""}
+            );
+            return result;
+        },
+        [](size_t taskIndex, const string& reason)
+        {
+            CTest::TestResults result;
+            result.methodName = "task " + to_string(taskIndex);
+            result.assertionResults.emplace_back(
+                CTest::AssertResult{CTest::AssertType::process_terminated, false, "crashed", reason}
+            );
+            return result;
+        },
+        [&results](size_t taskIndex, CTest::TestResults&& result)
+        {
+            results.at(taskIndex) = move(result);
+        }
+    );
+
+    size_t nPassedTasks = 0;
+    for(size_t i = 0; i < nTasks; i++)
+    {
+        if(i != crashingTask && results[i].methodName == "task " + to_string(i) && 
+            results[i].GetNumberOfPassedAndFailedCases().second == 0) nPassedTasks++;
+    }
+    test.assert_eq(nPassedTasks, nTasks - 1, "1) Remaining tasks completed after a worker crashed");
+
+    const auto& crashed = results[crashingTask].assertionResults;
+    test.assert(
+        crashed.size() == 1 && !crashed[0].passed && crashed[0].assertType == CTest::AssertType::process_terminated,
+        "2) Crashed task recorded as failed"
+    );
+    test.assert(
+        !crashed.empty() && crashed[0].additionalDetails.find("signal " + to_string(SIGSEGV)) != string::npos,
+        "3) Terminating signal recorded"
+    );
+}
+
+TEST_GROUPED_METHOD(Forked_Worker_Timeout_Killed, "runner")
+{
+    if(!CTest::ForkedWorkerPool::IsSupported()) return;
+
+    const size_t nTasks = 4;
+    const size_t hangingTask = 2;
+    vector<CTest::TestResults> results(nTasks);
+
+    auto makeResult = [](size_t taskIndex, CTest::AssertType assertType, bool passed, const string& details)
+    {
+        CTest::TestResults result;
+        result.methodName = "task " + to_string(taskIndex);
+        result.executionTimeMillis = 0;
+        result.assertionResults.emplace_back(CTest::AssertResult{assertType, passed, "", details});
+        return result;
+    };
+
+    CTest::ForkedWorkerPool pool(2);
+    pool.Run(
+        vector<size_t>{0, 1, 2, 3},
+        [hangingTask, &makeResult](size_t taskIndex)
+        {
+            while(taskIndex == hangingTask) this_thread::sleep_for(chrono::seconds(1));
+            return makeResult(taskIndex, CTest::AssertType::plain_assert, true, "");
+        },
+        [&makeResult](size_t taskIndex, const string& reason)
+        {
+            return makeResult(taskIndex, CTest::AssertType::process_terminated, false, reason);
+        },
+        [&results](size_t taskIndex, CTest::TestResults&& result)
+        {
+            results.at(taskIndex) = move(result);
+        },
+        [hangingTask](size_t taskIndex)
+        {
+            return taskIndex == hangingTask? int64_t(50) : int64_t(0);
+        },
+        [&makeResult](size_t taskIndex, const string& reason)
+        {
+            return makeResult(taskIndex, CTest::AssertType::timeout, false, reason);
+        }
+    );
+
+    size_t nPassedTasks = 0;
+    for(size_t i = 0; i < nTasks; i++)
+    {
+        if(i != hangingTask && results[i].GetNumberOfPassedAndFailedCases() == make_pair(size_t(1), size_t(0))) nPassedTasks++;
+    }
+    test.assert_eq(nPassedTasks, nTasks - 1, "1) Remaining tasks completed after a worker was killed");
+
+    const auto& timedOut = results[hangingTask].assertionResults;
+    test.assert(
+        timedOut.size() == 1 && !timedOut[0].passed && timedOut[0].assertType == CTest::AssertType::timeout,
+        "2) Hanging task recorded as timed out"
+    );
+    test.assert(results[hangingTask].executionTimeMillis >= 50, "3) Elapsed time recorded");
+}
+
+TEST_GROUPED_METHOD(Forked_Worker_Output_Flushed, "runner")
+{
+    if(!CTest::ForkedWorkerPool::IsSupported()) return;
+
+    const string path = "canary_forked_output.tmp";
+    remove(path.c_str());
+
+    CTest::ForkedWorkerPool pool(2);
+    pool.Run(
+        vector<size_t>{0, 1, 2},
+        [&path](size_t taskIndex)
+        {
+            //Left open on purpose, like stdout redirected to a file the output sits in the stream's buffer
+            FILE* output = fopen(path.c_str(), "a");
+            if(output != nullptr) fprintf(output, "task %u\n", static_cast<unsigned>(taskIndex));
+
+            CTest::TestResults result;
+            result.methodName = "task " + to_string(taskIndex);
+            result.executionTimeMillis = 0;
+            return result;
+        },
+        [](size_t, const string&) { return CTest::TestResults{}; },
+        [](size_t, CTest::TestResults&&) {}
+    );
+
+    size_t nLines = 0;
+    ifstream written(path);
+    for(string line; getline(written, line);) nLines++;
+    written.close();
+    remove(path.c_str());
+    test.assert_eq(nLines, size_t(3), "1) Buffered output of every task written out");
+}
+
+TEST_GROUPED_METHOD(Forked_Worker_Killed_When_Run_Throws, "runner")
+{
+    if(!CTest::ForkedWorkerPool::IsSupported()) return;
+
+    const auto start = chrono::steady_clock::now();
+    CTest::ForkedWorkerPool pool(2);
+    test.assert_throw([&pool]
+    {
+        pool.Run(
+            vector<size_t>{0, 1},
+            [](size_t taskIndex)
+            {
+                //Task 1 hangs well past the check below, unless its worker gets killed
+                for(int i = 0; i < 30 && taskIndex == 1; i++) this_thread::sleep_for(chrono::seconds(1));
+                CTest::TestResults result;
+                result.executionTimeMillis = 0;
+                return result;
+            },
+            [](size_t, const string&) { return CTest::TestResults{}; },
+            [](size_t taskIndex, CTest::TestResults&&)
+            {
+                if(taskIndex == 0) throw runtime_error("listener failed");
+            }
+        );
+    }, "1) Exception from onResult passed on");
+
+    const auto elapsed = chrono::steady_clock::now() - start;
+    test.assert(elapsed < chrono::seconds(10), "2) Hanging worker killed instead of waited for");
+}
+
+TEST_GROUPED_METHOD(Watchdog_Reports_Overrun, "runner")
+{
+    mutex lock;
+    condition_variable expired;
+    vector<size_t> expiredTasks;
+    int64_t elapsedNanos = 0;
+
+    {
+        CTest::Watchdog watchdog([&](size_t taskIndex, int64_t taskElapsedNanos)
+        {
+            lock_guard<mutex> guard(lock);
+            expiredTasks.push_back(taskIndex);
+            elapsedNanos = taskElapsedNanos;
+            expired.notify_one();
+        });
+
+        watchdog.Start(3, 60000);
+        watchdog.Start(7, 20);
+        watchdog.Finish(3);
+
+        unique_lock<mutex> guard(lock);
+        expired.wait_for(guard, chrono::seconds(10), [&expiredTasks]{ return !expiredTasks.empty(); });
+        guard.unlock();
+
+        //Finished in time, never reported
+        watchdog.Start(1, 60000);
+        watchdog.Finish(1);
+    }
+
+    test.assert(expiredTasks == vector<size_t>{7}, "1) Only the overrunning task reported");
+    test.assert(elapsedNanos >= 20000000, "2) Reported once its deadline has passed");
+}
+
+TEST_GROUPED_METHOD(Watchdog_Finish_While_Waiting, "runner")
+{
+    atomic<size_t> nExpired{0};
+    {
+        CTest::Watchdog watchdog([&nExpired](size_t, int64_t){ nExpired++; });
+
+        //Each task is the one the watcher is waiting on when it gets finished & erased
+        for(size_t taskIndex = 0; taskIndex < 20; taskIndex++)
+        {
+            watchdog.Start(taskIndex, 60000);
+            this_thread::sleep_for(chrono::milliseconds(1));
+            watchdog.Finish(taskIndex);
+        }
+
+        watchdog.Start(100, 1);
+        for(int i = 0; i < 10000 && nExpired == 0; i++) this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    test.assert_eq(nExpired.load(), size_t(1), "1) Only the overrunning task reported after the others were finished");
+}
+
+TEST_TIMED_METHOD(Timeout_Fixture_In_Time, "timeout fixture", 60000)
+{
+    test.assert(true, "Finishes well within its timeout");
+}
+
+TEST_GROUPED_METHOD(Timed_Tests_Run_Under_Watchdog, "runner")
+{
+    CTest::RunOptions options;
+    options.defaultTimeoutMillis = 60000;
+    const auto results = CTest::Canary::Instance().RunTestGroup("timeout fixture", options);
+    test.assert(
+        results.size() == 1 && results[0].GetNumberOfPassedAndFailedCases().second == 0,
+        "1) Test finishing in time passes"
+    );
+
+    test.assert_throw(
+        []{ CTest::Canary::Instance().AddTestMethod("Negative_Timeout", "unused", [](CTest::Tester&){}, {}, -1); },
+        "2) Negative timeout rejected"
+    );
+}
+
+static FixtureToggle failFastFixtureFails;
+
+TEST_FIXTURE_METHOD(Fail_Fast_Fixture_1, "fail fast fixture") { test.assert(!failFastFixtureFails.IsSet(), "1) fail fast fixture"); }
+TEST_FIXTURE_METHOD(Fail_Fast_Fixture_2, "fail fast fixture") { test.assert(!failFastFixtureFails.IsSet(), "2) fail fast fixture"); }
+TEST_FIXTURE_METHOD(Fail_Fast_Fixture_3, "fail fast fixture") { test.assert(!failFastFixtureFails.IsSet(), "3) fail fast fixture"); }
+TEST_FIXTURE_METHOD(Fail_Fast_Fixture_4, "fail fast fixture") { test.assert(!failFastFixtureFails.IsSet(), "4) fail fast fixture"); }
+
+TEST_GROUPED_METHOD(Max_Failures_Cancels_Run, "runner")
+{
+    CTest::RunOptions options;
+    options.maxFailures = 1;
+
+    vector<CTest::TestResults> sequential, parallel, forked;
+    {
+        const FixtureToggle::Scope failing(failFastFixtureFails);
+        sequential = CTest::Canary::Instance().RunTestGroup("fail fast fixture", options);
+
+        options.jobs = 2;
+        parallel = CTest::Canary::Instance().RunTestGroup("fail fast fixture", options);
+
+        if(CTest::ForkedWorkerPool::IsSupported())
+        {
+            options.isolation = CTest::ExecutionIsolation::forkedProcesses;
+            forked = CTest::Canary::Instance().RunTestGroup("fail fast fixture", options);
+        }
+    }
+
+    test.assert(
+        sequential.size() == 1 && sequential[0].methodName == "Fail_Fast_Fixture_1" && sequential[0].GetNumberOfPassedAndFailedCases().second == 1,
+        "1) Sequential run stops after the first failure");
+    //Each worker finishes at most the test it started before the first failure was reported
+    const bool allFailed = all_of(parallel.begin(), parallel.end(), [](const CTest::TestResults& result)
+    {
+        return result.GetNumberOfPassedAndFailedCases().second > 0;
+    });
+    test.assert(
+        parallel.size() >= 1 && parallel.size() <= 2 && allFailed,
+        "2) Parallel run stops after the first failure");
+    //Each forked worker finishes at most the test it was running when the run got cancelled
+    test.assert(
+        !CTest::ForkedWorkerPool::IsSupported() || (forked.size() >= 1 && forked.size() <= 2),
+        "3) Forked run stops early");
+
+    options = CTest::RunOptions{};
+    options.maxFailures = 1;
+    test.assert_eq(
+        CTest::Canary::Instance().RunTestGroup("fail fast fixture", options).size(), size_t(4),
+        "4) Passing run is not cancelled");
+}
+
+static FixtureToggle repeatFixtureFlaky;
+//Shared by the iterations on every worker
+static atomic<size_t> repeatFixtureCalls{0};
+
+TEST_FIXTURE_METHOD(Repeat_Fixture_Flaky, "repeat fixture")
+{
+    const size_t call = repeatFixtureCalls++;
+    test.log("call " + to_string(call));
+    test.assert(!repeatFixtureFlaky.IsSet() || call % 3 != 2, "Fails on every third call while repeatFixtureFlaky is set");
+}
+
+TEST_GROUPED_METHOD(Repeat_Runs_And_Aggregates_Iterations, "runner")
+{
+    auto findFlaky = [](const vector<CTest::TestResults>& results)
+    {
+        const auto found = find_if(results.begin(), results.end(), [](const CTest::TestResults& result)
+        {
+            return result.methodName == "Repeat_Fixture_Flaky";
+        });
+        return found != results.end()? &*found : nullptr;
+    };
+
+    CTest::RunOptions options;
+    options.repeat.count = 5;
+
+    const FixtureToggle::Scope flakyScope(repeatFixtureFlaky);
+    repeatFixtureCalls = 0;
+    const auto counted = CTest::Canary::Instance().RunTestGroup("repeat fixture", options);
+    const CTest::TestResults* flaky = findFlaky(counted);
+
+    test.assert(counted.size() == 1 && flaky != nullptr && flaky->isRepeated, "1) One combined result per test");
+    if(flaky == nullptr) return;
+    test.assert(
+        flaky->repeat.nIterations == 5 && flaky->repeat.nFailedIterations == 1 && flaky->repeat.firstFailedIteration == 2,
+        "2) Iterations & first failure counted");
+    test.assert(flaky->repeat.PassRate() == 0.8, "3) Pass rate");
+    test.assert(
+        flaky->GetNumberOfPassedAndFailedCases().second == 1 && flaky->logs == vector<string>{"call 2"},
+        "4) Asserts & logs of the first failing iteration reported");
+    test.assert_eq(flaky->repeat.wallNanos.nSamples, size_t(5), "5) Timing sample per iteration");
+    test.assert(
+        CTest::JsonifyTestResults(counted).find("\"first-failed-iteration\":2") != string::npos,
+        "6) First failure in JSON report");
+
+    options.repeat.untilFirstFailure = true;
+    repeatFixtureCalls = 0;
+    const auto untilFailure = CTest::Canary::Instance().RunTestGroup("repeat fixture", options);
+    flaky = findFlaky(untilFailure);
+    test.assert(flaky != nullptr && flaky->repeat.nIterations == 3, "7) Stops after the first failing iteration");
+
+    if(CTest::ForkedWorkerPool::IsSupported())
+    {
+        CTest::RunOptions forkedOptions;
+        forkedOptions.isolation = CTest::ExecutionIsolation::forkedProcesses;
+        forkedOptions.repeat.count = 4;
+        repeatFixtureCalls = 0;
+        const auto forked = CTest::Canary::Instance().RunTestGroup("repeat fixture", forkedOptions);
+        flaky = findFlaky(forked);
+        test.assert(
+            flaky != nullptr && flaky->repeat.nIterations == 4 && flaky->repeat.firstFailedIteration == 2,
+            "8) Repeated inside the worker process");
+    }
+
+    CTest::RunOptions parallelOptions;
+    parallelOptions.jobs = 4;
+    parallelOptions.repeat.count = 40;
+    repeatFixtureCalls = 0;
+    const auto parallel = CTest::Canary::Instance().RunTestGroup("repeat fixture", parallelOptions);
+    flaky = findFlaky(parallel);
+    test.assert(
+        parallel.size() == 1 && flaky != nullptr && flaky->repeat.nIterations == 40 && flaky->repeat.nFailedIterations == 13,
+        "9) Iterations & failures spread across workers add up");
+
+    CTest::RunOptions budgetOptions;
+    budgetOptions.repeat.count = 0;
+    budgetOptions.repeat.budgetMillis = 20;
+    const auto budgeted = CTest::Canary::Instance().RunTestGroup("repeat fixture", budgetOptions);
+    flaky = findFlaky(budgeted);
+    test.assert(flaky != nullptr && flaky->repeat.nIterations >= 1, "10) Repeats until the budget runs out");
+
+    budgetOptions.repeat.budgetMillis = 0;
+    test.assert_throw(
+        [&budgetOptions]{ CTest::Canary::Instance().RunTestGroup("repeat fixture", budgetOptions); },
+        "11) Unbounded repeat rejected");
+}
+
+TEST_GROUPED_METHOD(Shard_Assignment_Is_Stable, "runner")
+{
+    test.assert_eq(CTest::GetTestShard("group A", "GroupA_Method_1", 10), size_t(5), "1) FNV-1a shard assignment");
+    test.assert_eq(CTest::GetTestShard("group A", "GroupA_Method_1", 16), size_t(1), "2) FNV-1a shard assignment");
+    test.assert_eq(CTest::GetTestShard("any group", "any method", 1), size_t(0), "3) Single shard takes every test");
+    test.assert_neq(
+        CTest::GetTestShard("ab", "c", 1000000), 
+        CTest::GetTestShard("a", "bc", 1000000), 
+        "4) Group/method boundary is part of the hash"
+    );
+
+    test.assert_throw([]{ CTest::GetTestShard("group", "method", 0); }, "5) Zero shards rejected");
+    test.assert_throw([]{ CTest::Canary::Instance().RunShard(2, 2); }, "6) Out of range shard index rejected");
+}
+
+TEST_GROUPED_METHOD(Shard_Results_Merged, "runner")
+{
+    auto makeResult = [](const string& name, bool passed)
+    {
+        CTest::TestResults result;
+        result.methodName = name;
+        result.executionTimeMillis = 1;
+        result.assertionResults.emplace_back(
+            CTest::AssertResult{CTest::AssertType::plain_assert, passed, name, ""}
+        );
+        return result;
+    };
+
+    vector<vector<CTest::TestResults>> shards(2);
+    shards[0].emplace_back(makeResult("b", true));
+    shards[0].emplace_back(makeResult("d", true));
+    shards[1].emplace_back(makeResult("a", true));
+    shards[1].emplace_back(makeResult("c", false));
+
+    const auto merged = CTest::MergeTestResults(move(shards));
+
+    vector<string> mergedOrder;
+    for(const auto& result: merged) mergedOrder.emplace_back(result.methodName);
+
+    test.assert(mergedOrder == vector<string>{"c", "a", "b", "d"}, "1) Merged results sorted with failures first");
+
+    const string report = CTest::JsonifyTestResults(merged);
+    test.assert(report.find("\"passing-tests\":3") != string::npos, "2) Merged passing total");
+    test.assert(report.find("\"failing-tests\":1") != string::npos, "3) Merged failing total");
+    test.assert(report.find("\"total-test-time-millis\":4") != string::npos, "4) Merged test time");
+}
+
+TEST_GROUPED_METHOD(Results_View_Orders_Without_Copying, "runner")
+{
+    vector<CTest::TestResults> results(3);
+    results[0].methodName = "b";
+    results[1].methodName = "a";
+    results[2].methodName = "c";
+    results[2].assertionResults.emplace_back(
+        CTest::AssertResult{CTest::AssertType::plain_assert, false, "failing", ""}
+    );
+    results[0].assertionResults.emplace_back(
+        CTest::AssertResult{CTest::AssertType::plain_assert, true, "passing", ""}
+    );
+
+    const CTest::TestResultsView asGiven(results);
+    const CTest::TestResultsView sorted(results, CTest::ResultOrder::failedTestsFirst);
+
+    test.assert(asGiven.GetEntries().front().results == &results[0], "1) Entries point at the original results");
+
+    vector<string> sortedOrder;
+    for(const auto& entry: sorted.GetEntries()) sortedOrder.emplace_back(entry.results->methodName);
+    test.assert(sortedOrder == vector<string>{"c", "a", "b"}, "2) Failures first, then by name");
+
+    test.assert_eq(sorted.GetEntries().front().nFailed, size_t(1), "3) Failure count cached");
+    test.assert_eq(sorted.GetOverallResults().nTotalPassedTests, size_t(1), "4) Overall passing count");
+    test.assert_eq(sorted.GetOverallResults().nTotalFailedTests, size_t(1), "5) Overall failing count");
+
+    test.assert_eq(
+        CTest::FormatAsText(sorted),
+        CTest::FormatAsText(CTest::MergeTestResults({results})),
+        "6) Text report of a sorted view matches the sorted results");
+    test.assert_eq(
+        CTest::JsonifyTestResults(asGiven, JsonStyle::Compact),
+        CTest::JsonifyTestResults(results, JsonStyle::Compact),
+        "7) JSON report of a view matches the results");
+}
+
+TEST_TAGGED_METHOD(Selection_Fixture_Fast_Parser, "selection fixture", "fast")
+{
+    test.assert(true, "Fast parser");
+}
+
+TEST_TAGGED_METHOD(Selection_Fixture_Slow_Parser, "selection fixture", "slow", "io")
+{
+    test.assert(true, "Slow parser");
+}
+
+TEST_TAGGED_METHOD(Selection_Fixture_Slow_Writer, "selection fixture 2", "slow")
+{
+    test.assert(true, "Slow writer");
+}
+
+TEST_GROUPED_METHOD(Selection_Fixture_Untagged, "selection fixture 2")
+{
+    test.assert(true, "Untagged");
+}
+
+TEST_GROUPED_METHOD(Query_Selects_By_Group_Tag_And_Name, "runner")
+{
+    auto runQuery = [](const CTest::TestQuery& query)
+    {
+        vector<string> names;
+        for(const auto& result: CTest::Canary::Instance().RunQuery(query)) names.emplace_back(result.methodName);
+        return names;
+    };
+
+    CTest::TestQuery byGroups;
+    byGroups.groups = {"selection fixture", "selection fixture 2"};
+    test.assert_eq(runQuery(byGroups).size(), size_t(4), "1) Several groups");
+
+    CTest::TestQuery byTag;
+    byTag.includeTags = {"slow"};
+    test.assert(
+        runQuery(byTag) == vector<string>{"Selection_Fixture_Slow_Parser", "Selection_Fixture_Slow_Writer"},
+        "2) Tests from any group carrying the tag");
+
+    CTest::TestQuery groupAndTag;
+    groupAndTag.groups = {"selection fixture 2"};
+    groupAndTag.includeTags = {"slow"};
+    test.assert(runQuery(groupAndTag) == vector<string>{"Selection_Fixture_Slow_Writer"}, "3) Group and tag combined");
+
+    CTest::TestQuery excluded;
+    excluded.groups = {"selection fixture", "selection fixture 2"};
+    excluded.excludeTags = {"slow"};
+    test.assert(
+        runQuery(excluded) == vector<string>{"Selection_Fixture_Fast_Parser", "Selection_Fixture_Untagged"},
+        "4) Excluded tag");
+
+    CTest::TestQuery glob;
+    glob.namePatterns = {"Selection_Fixture_*_Pars?r"};
+    test.assert(
+        runQuery(glob) == vector<string>{"Selection_Fixture_Fast_Parser", "Selection_Fixture_Slow_Parser"},
+        "5) Glob name pattern");
+
+    CTest::TestQuery regex;
+    regex.groups = {"selection fixture 2"};
+    regex.namePatterns = {"Selection_Fixture_(Untagged|Nothing)"};
+    regex.patternSyntax = CTest::NamePatternSyntax::regex;
+    test.assert(runQuery(regex) == vector<string>{"Selection_Fixture_Untagged"}, "6) Regex matches the whole name");
+
+    CTest::TestQuery unknown;
+    unknown.groups = {"no such group"};
+    test.assert(runQuery(unknown).empty(), "7) Unknown group selects nothing");
+}
+
+struct RecordingListener : public CTest::TestListener
+{
+    size_t nRunStarts = 0;
+    size_t nTestsAnnounced = 0;
+    size_t nTestStarts = 0;
+    size_t nAsserts = 0;
+    size_t nTestEnds = 0;
+    size_t nRunEnds = 0;
+    size_t nPassedAtRunEnd = 0;
+
+    void OnRunStart(size_t nTests) override { nRunStarts++; nTestsAnnounced = nTests; }
+    void OnTestStart(const string&, const string&) override { nTestStarts++; }
+    void OnAssert(const string&, const string&, const CTest::AssertResult&) override { nAsserts++; }
+    void OnTestEnd(const CTest::TestResults&) override { nTestEnds++; }
+    void OnRunEnd(const CTest::OverallTestResults& overall) override 
+    { 
+        nRunEnds++; 
+        nPassedAtRunEnd = overall.nTotalPassedTests; 
+    }
+};
+
+TEST_GROUPED_METHOD(Listener_Receives_Run_Events, "runner")
+{
+    for(size_t jobs: {1, 3})
+    {
+        RecordingListener listener;
+        std::ostringstream jsonLines;
+        CTest::JsonLinesReporter jsonLinesReporter(jsonLines);
+
+        CTest::RunOptions options;
+        options.jobs = jobs;
+        options.listeners = {&listener, &jsonLinesReporter};
+        options.retainResults = false;
+
+        const auto results = CTest::Canary::Instance().RunTestGroup("parallel fixture", options);
+        const string jobCaption = " (" + to_string(jobs) + " jobs)";
+
+        test.assert(results.empty(), "1) Results not retained" + jobCaption);
+        test.assert(
+            listener.nRunStarts == 1 && listener.nTestsAnnounced == 4 && listener.nRunEnds == 1, 
+            "2) Run start & end reported" + jobCaption
+        );
+        test.assert(listener.nTestStarts == 4 && listener.nTestEnds == 4, "3) Test start & end reported" + jobCaption);
+        test.assert_eq(listener.nAsserts, size_t(5), "4) Asserts reported" + jobCaption);
+        test.assert_eq(listener.nPassedAtRunEnd, size_t(5), "5) Overall results reported at run end" + jobCaption);
+
+        const string lines = jsonLines.str();
+        test.assert_eq(
+            static_cast<size_t>(std::count(lines.begin(), lines.end(), '\n')), size_t(4), 
+            "6) One JSON line per test" + jobCaption
+        );
+        test.assert(
+            lines.find(R"_({"name":"Parallel_Fixture_Passing_3","group":"parallel fixture","all-passed":true)_") != string::npos,
+            "7) Compact JSON record per test" + jobCaption
+        );
+    }
+}
+
+TEST_GROUPED_METHOD(Timing_Fixture_Sleeping, "timing fixture")
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    test.assert(true, "Waits instead of computing");
+}
+
+TEST_GROUPED_METHOD(Timing_Fixture_Spinning, "timing fixture")
+{
+    const auto start = std::chrono::steady_clock::now();
+    volatile uint64_t counter = 0;
+    while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(5)) counter = counter + 1;
+    test.assert(counter > 0, "Computes instead of waiting");
+}
+
+TEST_GROUPED_METHOD(Wall_And_Cpu_Time_Recorded, "runner")
+{
+    const auto results = CTest::Canary::Instance().RunTestGroup("timing fixture");
+    test.assert_eq(results.size(), size_t(2), "1) Timing fixture executed");
+    if(results.size() != 2) return;
+
+    const CTest::TestResults& sleeping = results[0].methodName == "Timing_Fixture_Sleeping"? results[0] : results[1];
+    const CTest::TestResults& spinning = results[0].methodName == "Timing_Fixture_Spinning"? results[0] : results[1];
+
+    test.assert(sleeping.executionTimeNanos >= 20000000, "2) Nanosecond wall time recorded");
+    test.assert_eq(sleeping.executionTimeMillis, sleeping.executionTimeNanos / 1000000, "3) Millisecond wall time consistent");
+    test.assert(sleeping.threadCpuTimeNanos < sleeping.executionTimeNanos / 2, "4) Waiting test uses little CPU time");
+    test.assert(spinning.threadCpuTimeNanos > 0 && spinning.processCpuTimeNanos > 0, "5) Computing test uses CPU time");
+
+    const string jsonReport = CTest::JsonifyTestResults(results);
+    test.assert(
+        jsonReport.find("\"thread-cpu-time-nanos\":") != string::npos &&
+        jsonReport.find("\"process-cpu-time-nanos\":") != string::npos &&
+        jsonReport.find("\"test-time-nanos\":") != string::npos,
+        "6) Times in JSON report"
+    );
+    test.assert(CTest::FormatAsText(results).find("thread cpu ") != string::npos, "7) Times in text report");
+}